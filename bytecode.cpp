@@ -0,0 +1,353 @@
+#include "bytecode.h"
+#include <tuple>
+#include <unordered_set>
+
+using namespace std;
+
+// Same literal rule as Interpreter::getValue.
+static bool isNumber(const string& s) {
+    if (s.empty()) return false;
+    for (char c : s)
+        if (!isdigit(c) && c != '-') return false;
+    return true;
+}
+
+static bool writesResult(const string& op) {
+    return op == "MOV" || op == "=" || op.empty() || op == "+" || op == "-" || op == "*" || op == "/" ||
+           op == "%" || op == "<" || op == ">" || op == "<=" || op == ">=" || op == "==" || op == "!=";
+}
+
+// Literals get constant slots in order of appearance; every other token
+// is a variable, since the IR interpreter looked any non-literal up by name.
+void BytecodeCompiler::collect(const string& token) {
+    if (isNumber(token)) {
+        if (constants.count(token)) return;
+        int value = 0;
+        try {
+            value = stoi(token);
+        } catch (...) {
+        }
+        constants[token] = program.frame.size();
+        program.frame.push_back(value);
+    } else {
+        declare(token);
+    }
+}
+
+void BytecodeCompiler::declare(const string& name) {
+    if (variables.count(name)) return;
+    variables[name] = -1;
+    names.push_back(name);
+}
+
+int BytecodeCompiler::operand(const string& token) {
+    if (!isNumber(token)) return variables[token];
+    try {
+        stoi(token);
+    } catch (...) {
+        badLiterals.push_back(token);
+    }
+    return constants[token];
+}
+
+int BytecodeCompiler::stringOperand(const string& token) {
+    auto it = stringSlots.find(token);
+    if (it != stringSlots.end()) return it->second;
+    stringSlots[token] = program.strings.size();
+    program.strings.push_back(isStringLiteral(token) ? text(literalText(token)) : -1);
+    return program.strings.size() - 1;
+}
+
+int BytecodeCompiler::text(const string& value) {
+    auto it = textIds.find(value);
+    if (it != textIds.end()) return it->second;
+    textIds[value] = program.texts.size();
+    program.texts.push_back(value);
+    return program.texts.size() - 1;
+}
+
+void BytecodeCompiler::emit(Opcode op, int a, int b, int c) {
+    BytecodeInstr instr;
+    instr.op = op;
+    instr.a = a;
+    instr.b = b;
+    instr.c = c;
+    program.code.push_back(instr);
+}
+
+// The last instruction computed temp, nothing else reads temp and no label
+// points between the two, so the next instruction may absorb it.
+bool BytecodeCompiler::fusesWithLast(const string& temp) {
+    if (!fuse || program.code.empty() || labelTarget == (int)program.code.size() || reads[temp] != 1) return false;
+    const BytecodeInstr& last = program.code.back();
+    if (last.op == OP_STR_CONCAT) {
+        auto slot = stringSlots.find(temp);
+        return slot != stringSlots.end() && last.c == slot->second;
+    }
+    auto slot = variables.find(temp);
+    return last.op >= OP_ADD && last.op <= OP_NE && slot != variables.end() && last.c == slot->second;
+}
+
+BytecodeProgram BytecodeCompiler::compile(const vector<Instruction>& code, bool profiling) {
+    program = BytecodeProgram();
+    constants.clear();
+    variables.clear();
+    names.clear();
+    textIds.clear();
+    reads.clear();
+    stringNames = findStringNames(code);
+    stringSlots.clear();
+    arrayIds.clear();
+    fuse = !profiling;
+    labelTarget = -1;
+
+    static const unordered_map<string, Opcode> binary = {
+        {"+", OP_ADD}, {"-", OP_SUB}, {"*", OP_MUL}, {"/", OP_DIV}, {"%", OP_MOD},
+        {"<", OP_LT}, {">", OP_GT}, {"<=", OP_LE}, {">=", OP_GE}, {"==", OP_EQ}, {"!=", OP_NE}};
+
+    // ---- Frame ----
+    // Printing a variable that was never assigned prints its name, so
+    // assignments to printed variables are followed by OP_MARK.
+    unordered_set<string> assigned, printed;
+    auto read = [&](const string& token) {
+        collect(token);
+        reads[token]++;
+    };
+    // IR index -> loop, for the header, first body instruction and back edge
+    unordered_map<size_t, int> parallelAt;
+    vector<ParallelLoop> parallel;
+    for (size_t pc = 0; !profiling && pc < code.size(); ++pc) {
+        ParallelLoop loop;
+        if (code[pc].op != "parallel" || !findParallelLoop(code, pc, loop)) continue;
+        read(loop.var);
+        read(loop.bound);
+        for (const auto& reduction : loop.reductions) declare(reduction.first);
+        declare("limit " + to_string(parallel.size()));  // not a valid identifier
+        parallelAt[loop.header] = parallelAt[loop.body] = parallelAt[loop.backEdge] = parallel.size();
+        parallel.push_back(loop);
+    }
+    for (const auto& instr : code) {
+        const string& op = instr.op;
+        if (writesResult(op) && stringNames.count(instr.result)) {
+            reads[instr.arg1]++;
+            if (op == "+") reads[instr.arg2]++;
+        } else if (writesResult(op)) {
+            read(instr.arg1);
+            if (binary.count(op)) read(instr.arg2);
+            declare(instr.result);
+            assigned.insert(instr.result);
+        } else if (op == "ifFalse" || op == "jumptable" || op == "return") {
+            read(instr.arg1);
+        } else if (op == "param") {
+            read(instr.arg1.empty() ? instr.result : instr.arg1);
+        } else if (op == "print") {
+            printed.insert(instr.arg1);
+            reads[instr.arg1]++;
+        } else if (op == "read" || op == "load") {
+            if (op == "load") read(instr.arg2);
+            declare(instr.result);
+            assigned.insert(instr.result);
+        } else if (op == "store") {
+            read(instr.arg1);
+            read(instr.arg2);
+        } else if (op == "bounds") {
+            read(instr.arg1);
+        } else if (op == "array" && !arrayIds.count(instr.result)) {
+            int size = stoi(instr.arg1);
+            arrayIds[instr.result] = program.arrays.size();
+            program.arrays.push_back({program.cells, size, text(instr.result)});
+            program.cells += size;
+        }
+    }
+    program.constants = program.frame.size();
+    for (const auto& name : names) {
+        variables[name] = program.frame.size();
+        program.frame.push_back(0);
+    }
+
+    // ---- Code ----
+    static const unordered_map<int, Opcode> branchIfFalse = {
+        {OP_LT, OP_JGE}, {OP_GT, OP_JLE}, {OP_LE, OP_JGT}, {OP_GE, OP_JLT}, {OP_EQ, OP_JNE}, {OP_NE, OP_JEQ}};
+    unordered_map<string, int> labels;
+    unordered_map<string, int> loopEnds;                 // label -> IR index of the last jump back to it
+    if (profiling) {
+        unordered_map<string, int> seen;
+        for (size_t pc = 0; pc < code.size(); ++pc) {
+            const Instruction& instr = code[pc];
+            if (instr.op == "label") seen[instr.result] = pc;
+            if ((instr.op == "goto" || instr.op == "ifFalse") && seen.count(instr.result)) loopEnds[instr.result] = pc;
+        }
+    }
+    vector<pair<size_t, string>> jumps;                  // instruction, label
+    program.loops.resize(parallel.size());
+    vector<tuple<size_t, int, string>> tableEntries;     // table, entry (-1: fallback), label
+    // An operand literal that std::stoi rejects made the IR interpreter throw
+    // when the instruction ran; keep that by failing just before it.
+    auto checkLiterals = [&]() {
+        for (const auto& literal : badLiterals) emit(OP_BAD_LITERAL, 0, text(literal));
+        badLiterals.clear();
+    };
+
+    for (size_t pc = 0; pc < code.size(); ++pc) {
+        const Instruction& instr = code[pc];
+        const string& op = instr.op;
+        size_t first = program.code.size();
+        auto loopAt = parallelAt.find(pc);
+        if (loopAt != parallelAt.end()) {
+            const ParallelLoop& loop = parallel[loopAt->second];
+            ParallelCode& lowered = program.loops[loopAt->second];
+            if (pc == (size_t)loop.header) {
+                lowered.var = variables[loop.var];
+                lowered.bound = operand(loop.bound);
+                checkLiterals();
+                lowered.limit = variables["limit " + to_string(loopAt->second)];
+                for (const auto& reduction : loop.reductions)
+                    lowered.reductions.push_back({variables[reduction.first], reduction.second});
+                emit(OP_PARALLEL, 0, 0, loopAt->second);
+                jumps.push_back({program.code.size() - 1, code[loop.exit].result});
+            } else if (pc == (size_t)loop.body) {
+                lowered.body = labelTarget = program.code.size();
+            } else {
+                emit(OP_PAR_NEXT, lowered.var, lowered.limit, lowered.body);
+                program.source.push_back(pc);
+                continue;
+            }
+        }
+
+        if (op == "label") {
+            labels[instr.result] = labelTarget = program.code.size();
+            if (profiling) {
+                auto end = loopEnds.find(instr.result);
+                emit(OP_LABEL, pc, end != loopEnds.end() ? end->second : -1);
+            }
+        } else if (writesResult(op) && stringNames.count(instr.result)) {
+            int a = stringOperand(instr.arg1);
+            if (op == "+") {
+                emit(OP_STR_CONCAT, a, stringOperand(instr.arg2), stringOperand(instr.result));
+            } else if (fusesWithLast(instr.arg1)) {
+                program.code.back().c = stringOperand(instr.result);
+                program.superinstructions++;
+            } else {
+                emit(OP_STR_COPY, a, 0, stringOperand(instr.result));
+            }
+        } else if (writesResult(op)) {
+            auto bin = binary.find(op);
+            int a = operand(instr.arg1);
+            int b = bin != binary.end() ? operand(instr.arg2) : 0;
+            checkLiterals();
+            if (bin == binary.end() && fusesWithLast(instr.arg1)) {
+                program.code.back().c = variables[instr.result];
+                program.superinstructions++;
+            } else {
+                emit(bin != binary.end() ? bin->second : OP_COPY, a, b, variables[instr.result]);
+            }
+            if (printed.count(instr.result)) emit(OP_MARK, variables[instr.result]);
+        } else if (op == "ifFalse") {
+            int a = operand(instr.arg1);
+            checkLiterals();
+            auto branch = branchIfFalse.end();
+            if (fusesWithLast(instr.arg1)) branch = branchIfFalse.find(program.code.back().op);
+            if (branch != branchIfFalse.end()) {
+                program.code.back().op = branch->second;
+                program.superinstructions++;
+                jumps.push_back({program.code.size() - 1, instr.result});
+            } else {
+                jumps.push_back({program.code.size(), instr.result});
+                emit(OP_JUMP_IF_FALSE, a);
+            }
+        } else if (op == "goto") {
+            jumps.push_back({program.code.size(), instr.result});
+            emit(OP_JUMP);
+        } else if (op == "jumptable") {
+            int a = operand(instr.arg1);
+            checkLiterals();
+            JumpTable table;
+            table.min = stoll(instr.arg2);
+            size_t index = program.tables.size();
+            tableEntries.push_back(make_tuple(index, -1, instr.result));
+            for (size_t k = pc + 1; k < code.size() && code[k].op == "case"; ++k) {
+                tableEntries.push_back(make_tuple(index, (int)table.targets.size(), code[k].result));
+                table.targets.push_back(0);
+            }
+            // a missing label falls through the case entries
+            table.fallback = program.code.size() + 1;
+            program.tables.push_back(table);
+            emit(OP_JUMP_TABLE, a, index);
+        } else if (op == "param") {
+            int a = operand(instr.arg1.empty() ? instr.result : instr.arg1);
+            checkLiterals();
+            emit(OP_PARAM, a);
+        } else if (op == "call") {
+            if (instr.result == "prrint") emit(OP_PRINT_CALL);
+        } else if (op == "return") {
+            int a = operand(instr.arg1);
+            checkLiterals();
+            emit(OP_RETURN, a);
+        } else if (op == "read") {
+            emit(OP_READ, 0, 0, variables[instr.result]);
+            if (printed.count(instr.result)) emit(OP_MARK, variables[instr.result]);
+        } else if (op == "load") {
+            int a = operand(instr.arg2);
+            checkLiterals();
+            emit(OP_LOAD, a, program.arrays[arrayIds[instr.arg1]].base, variables[instr.result]);
+            if (printed.count(instr.result)) emit(OP_MARK, variables[instr.result]);
+        } else if (op == "store") {
+            int a = operand(instr.arg1), b = operand(instr.arg2);
+            checkLiterals();
+            emit(OP_STORE, a, b, program.arrays[arrayIds[instr.result]].base);
+        } else if (op == "bounds") {
+            int a = operand(instr.arg1);
+            checkLiterals();
+            int array = arrayIds[instr.result];
+            emit(OP_BOUNDS, a, array, program.arrays[array].size);
+        } else if (op == "print") {
+            if (stringNames.count(instr.arg1)) emit(OP_PRINT_STR, stringOperand(instr.arg1));
+            else if (isStringLiteral(instr.arg1)) emit(OP_PRINT_TEXT, 0, text(literalText(instr.arg1)));
+            else if (assigned.count(instr.arg1)) emit(OP_PRINT_VAR, variables[instr.arg1], text(instr.arg1));
+            else emit(OP_PRINT_TEXT, 0, text(instr.arg1));
+        }
+        for (size_t i = first; i < program.code.size(); ++i) program.source.push_back(pc);
+    }
+    emit(OP_HALT);
+    program.source.push_back(code.size());
+
+    // Like the IR interpreter, a jump to a missing label falls through.
+    auto target = [&](const string& label, int32_t next) {
+        auto it = labels.find(label);
+        return it != labels.end() ? (int32_t)it->second : next;
+    };
+    for (const auto& jump : jumps) {
+        BytecodeInstr& instr = program.code[jump.first];
+        if (instr.op == OP_PARALLEL) program.loops[instr.c].exit = target(jump.second, jump.first + 1);
+        else instr.c = target(jump.second, jump.first + 1);
+    }
+    for (const auto& entry : tableEntries) {
+        JumpTable& table = program.tables[get<0>(entry)];
+        int index = get<1>(entry);
+        if (index < 0) continue;
+        table.targets[index] = target(get<2>(entry), table.fallback);
+    }
+    for (const auto& entry : tableEntries) {
+        if (get<1>(entry) >= 0) continue;
+        JumpTable& table = program.tables[get<0>(entry)];
+        table.fallback = target(get<2>(entry), table.fallback);
+    }
+
+    // A goto to a loop header whose test exits to the instruction after the
+    // goto runs the test itself, with the condition reversed.
+    static const unordered_map<int, Opcode> reversed = {
+        {OP_JLT, OP_JGE}, {OP_JGE, OP_JLT}, {OP_JGT, OP_JLE}, {OP_JLE, OP_JGT}, {OP_JEQ, OP_JNE}, {OP_JNE, OP_JEQ}};
+    for (size_t i = 0; fuse && i < program.code.size(); ++i) {
+        BytecodeInstr& jump = program.code[i];
+        if (jump.op != OP_JUMP) continue;
+        const BytecodeInstr& header = program.code[jump.c];
+        auto condition = reversed.find(header.op);
+        if (condition == reversed.end() || header.c != (int32_t)i + 1) continue;
+        jump.op = condition->second;
+        jump.a = header.a;
+        jump.b = header.b;
+        jump.c++;
+        program.superinstructions++;
+    }
+    return program;
+}
@@ -0,0 +1,135 @@
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+#include "icg.h"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+using namespace std;
+
+enum Opcode : uint8_t {
+    OP_COPY,            // c = a
+    OP_ADD, OP_SUB, OP_MUL, OP_DIV, OP_MOD,
+    OP_LT, OP_GT, OP_LE, OP_GE, OP_EQ, OP_NE,   // c = a op b
+    OP_MARK,            // a is now assigned
+    OP_JUMP,            // pc = c
+    OP_JUMP_IF_FALSE,   // if (!a) pc = c
+    OP_JUMP_TABLE,      // pc = tables[b] entry for a
+    OP_PARAM,           // the next print call prints a
+    OP_PRINT_CALL,      // print the pending param, if any
+    OP_PRINT_VAR,       // print a if assigned, else texts[b]
+    OP_PRINT_TEXT,      // print texts[b]
+    OP_READ,            // c = the next integer of the input
+    OP_STR_COPY,        // string c = string a
+    OP_STR_CONCAT,      // string c = string a + string b
+    OP_PRINT_STR,       // print string a
+    OP_LOAD,            // c = cells[b + a]
+    OP_STORE,           // cells[c + a] = b
+    OP_BOUNDS,          // stop with an error unless 0 <= a < c; b is the array
+    OP_PARALLEL,        // run the iterations of loops[c], then pc = its exit
+    OP_PAR_NEXT,        // if (a < b) pc = c, else the iterations being run are done
+    OP_RETURN,          // stop with a
+    OP_LABEL,           // profiling only: IR label a was reached; a loop through IR index b if b >= 0
+    OP_BAD_LITERAL,     // std::stoi(texts[b]) throws, as the IR interpreter did
+    OP_HALT,
+    // superinstructions: if (a op b) pc = c
+    OP_JLT, OP_JGT, OP_JLE, OP_JGE, OP_JEQ, OP_JNE,
+    OP_COUNT
+};
+
+// Operands a and b are frame indices: constants come first in the frame,
+// then one slot per variable, so reading an operand never checks its kind.
+// String operations index the separate string frame instead. Jump targets
+// are absolute bytecode indices.
+struct BytecodeInstr {
+    Opcode op;
+    int32_t a = 0, b = 0, c = 0;
+};
+
+struct JumpTable {
+    long long min;
+    int32_t fallback;         // target when the value is out of range
+    vector<int32_t> targets;
+};
+
+// An array's elements are `size` consecutive cells from `base`.
+struct ArrayLayout {
+    int32_t base;
+    int32_t size;
+    int32_t name;   // text id
+};
+
+// A loop whose iterations may run in parallel (see findParallelLoop). Its
+// body runs from `body` until OP_PAR_NEXT finds the loop variable at the
+// hidden `limit` slot, so any range of iterations can be run on its own.
+struct ParallelCode {
+    int32_t var, bound, limit;                // frame indices
+    int32_t body = 0, exit = 0;
+    vector<pair<int32_t, int>> reductions;    // frame index, identity
+};
+
+struct BytecodeProgram {
+    vector<BytecodeInstr> code;
+    vector<int> frame;             // initial frame: constants, then zeroed variables
+    int constants = 0;             // number of leading constant slots
+    vector<string> texts;          // printed names and strings, and string literals
+    vector<int32_t> strings;       // string frame: text of each literal, -1 for variables, which start empty
+    vector<JumpTable> tables;
+    vector<ArrayLayout> arrays;
+    vector<ParallelCode> loops;
+    int cells = 0;                 // elements of all arrays, zeroed at the start of a run
+    vector<int32_t> source;        // bytecode index -> IR index
+    int superinstructions = 0;     // IR instruction pairs executed as one
+};
+
+// Lowers three-address code to bytecode once, resolving every operand to a
+// frame index and every label to an absolute target. A jump to a missing
+// label falls through, as in the IR interpreter. With profiling, labels are
+// kept as OP_LABEL so the interpreter can count and time loops; a label is
+// the start of a loop that ends at the last jump back to it.
+//
+// Without profiling, the most frequent ICG sequences become single
+// instructions: a comparison into a temp followed by `ifFalse` on it, a
+// binary operation into a temp followed by a copy of it, and a `goto` to a
+// loop header that tests the loop condition, which branches on that
+// condition directly. A temp is only dropped when nothing else reads it.
+//
+// sttring values (see findStringNames) live in the string frame; each
+// distinct literal is interned once in texts and gets one slot. Arrays are
+// laid out one after another in a separate block of cells, and a `bounds`
+// check tests against the size of the array it names.
+//
+// Without profiling, a loop that findParallelLoop accepts is entered through
+// OP_PARALLEL, placed before its header, and its back edge becomes
+// OP_PAR_NEXT. Other `parallel` and `reduce` markers are dropped.
+class BytecodeCompiler {
+public:
+    BytecodeProgram compile(const vector<Instruction>& code, bool profiling = false);
+
+private:
+    BytecodeProgram program;
+    unordered_map<string, int> constants;   // literal -> frame index
+    unordered_map<string, int> variables;   // name -> frame index
+    vector<string> names;                   // variables in order of appearance
+    unordered_map<string, int> textIds;
+    vector<string> badLiterals;             // rejected by std::stoi, pending for the current instruction
+    unordered_map<string, int> reads;       // operand reads per name
+    unordered_set<string> stringNames;
+    unordered_map<string, int> stringSlots; // literal or name -> string frame index
+    unordered_map<string, int> arrayIds;    // name -> index in program.arrays
+    bool fuse = false;
+    int labelTarget = -1;                   // bytecode index the last label resolved to
+
+    bool fusesWithLast(const string& temp);
+    void collect(const string& token);
+    void declare(const string& name);
+    int operand(const string& token);
+    int stringOperand(const string& token);
+    int text(const string& value);
+    void emit(Opcode op, int a = 0, int b = 0, int c = 0);
+};
+
+#endif
@@ -0,0 +1,319 @@
+#include "cgen.h"
+#include "runtime_io.h"
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <unordered_set>
+
+using namespace std;
+
+static bool isLiteral(const string& s) {
+    if (s.empty()) return false;
+    for (char c : s) {
+        if (!isdigit(c) && c != '-') return false;
+    }
+    return true;
+}
+
+static bool isName(const string& s) {
+    return !s.empty() && s[0] != '"' && !isLiteral(s);
+}
+
+static string quote(const string& text) {
+    ostringstream out;
+    out << '"';
+    for (unsigned char c : text) {
+        if (c == '"' || c == '\\') out << '\\' << c;
+        else if (c >= 32 && c < 127 && c != '?') out << c;
+        else out << '\\' << (char)('0' + (c >> 6)) << (char)('0' + ((c >> 3) & 7)) << (char)('0' + (c & 7));
+    }
+    out << '"';
+    return out.str();
+}
+
+// Identifiers are prefixed so IR names cannot clash with C keywords or the
+// runtime; characters C does not allow are spelled out as hex.
+static string identifier(const string& prefix, const string& name) {
+    string id = prefix;
+    for (unsigned char c : name) {
+        if (isalnum(c)) {
+            id += c;
+        } else {
+            static const char* hex = "0123456789abcdef";
+            id += "_";
+            id += hex[c >> 4];
+            id += hex[c & 15];
+        }
+    }
+    return id;
+}
+
+string CSourceGenerator::variable(const string& name) {
+    auto it = names.find(name);
+    if (it != names.end()) return it->second;
+    return names[name] = identifier("v_", name);
+}
+
+// Literals are printed as int constants, variables by name, anything else
+// reads as 0 like in the interpreter.
+string CSourceGenerator::value(const string& arg) {
+    if (isLiteral(arg)) {
+        long long number = strtoll(arg.c_str(), nullptr, 10);
+        return number == -2147483648LL ? "(-2147483647 - 1)" : to_string((int)number);
+    }
+    if (isName(arg)) return variable(arg);
+    return "0";
+}
+
+string CSourceGenerator::generate(const vector<Instruction>& code) {
+    names.clear();
+    errors.clear();
+    parallelLoops = 0;
+
+    unordered_set<string> labels, defined;
+    vector<string> order;
+    auto declare = [&](const string& name) {
+        if (isName(name) && !names.count(name)) {
+            variable(name);
+            order.push_back(name);
+        }
+    };
+    vector<string> printed;
+    vector<const Instruction*> arrays;
+    bool reads = false, checks = false;
+    for (const auto& instr : code) {
+        if (instr.op == "label") labels.insert(instr.result);
+        if (instr.op == "read") reads = true;
+        if (instr.op == "bounds") checks = true;
+        if (instr.op == "array") arrays.push_back(&instr);
+        if (instr.op == "label" || instr.op == "goto" || instr.op == "case" || instr.op == "call" ||
+            instr.op == "array") continue;
+        if (instr.op != "load") declare(instr.arg1);
+        declare(instr.arg2);
+        if (instr.op == "param" && instr.arg1.empty()) declare(instr.result);
+        if (writesResult(instr)) {
+            declare(instr.result);
+            defined.insert(instr.result);
+        }
+        if (instr.op == "print" && isName(instr.arg1)) printed.push_back(instr.arg1);
+    }
+    unordered_set<string> flagged;
+    for (const auto& name : printed) {
+        if (defined.count(name)) flagged.insert(name);
+    }
+
+    ostringstream out;
+    out << "#include <stdio.h>\n";
+    if (checks) out << "#include <stdlib.h>\n";
+    if (reads) out << "#include <unistd.h>\n";
+    out << "\n";
+    // arrays are static so that large ones do not need stack space
+    unordered_set<string> placed;
+    for (const Instruction* array : arrays) {
+        if (placed.insert(array->result).second)
+            out << "static int " << identifier("a_", array->result) << "[" << value(array->arg1) << "];\n";
+    }
+    if (!arrays.empty()) out << "\n";
+    if (checks) {
+        out << "static void rt_bounds(int index, const char* suffix) {\n"
+            << "    fflush(stdout);\n"
+            << "    fprintf(stderr, \"%s%d%s\\n\", " << quote(OUT_OF_BOUNDS_PREFIX) << ", index, suffix);\n"
+            << "    exit(1);\n}\n\n";
+    }
+    out << "static int rt_div(int a, int b) {\n"
+        << "    return b == 0 ? 0 : b == -1 ? (int)(0u - (unsigned)a) : a / b;\n}\n\n";
+    out << "static int rt_mod(int a, int b) {\n"
+        << "    return b == 0 || b == -1 ? 0 : a % b;\n}\n\n";
+    if (reads) {
+        // same rules as InputReader::readInt, reading in blocks after flushing the output
+        out << "static char rt_in[1 << 16];\nstatic long rt_inpos, rt_inlen;\n\n"
+            << "static int rt_getc(void) {\n"
+            << "    if (rt_inpos == rt_inlen) {\n"
+            << "        fflush(stdout);\n"
+            << "        long n = read(0, rt_in, sizeof rt_in);\n"
+            << "        if (n <= 0) return -1;\n"
+            << "        rt_inpos = 0;\n"
+            << "        rt_inlen = n;\n"
+            << "    }\n"
+            << "    return (unsigned char)rt_in[rt_inpos++];\n}\n\n"
+            << "static int rt_read(void) {\n"
+            << "    unsigned value = 0;\n"
+            << "    int c = rt_getc(), negative;\n"
+            << "    while (c >= 0 && c <= ' ') c = rt_getc();\n"
+            << "    negative = c == '-';\n"
+            << "    if (negative) c = rt_getc();\n"
+            << "    for (; c >= '0' && c <= '9'; c = rt_getc()) value = value * 10 + (unsigned)(c - '0');\n"
+            << "    return (int)(negative ? 0u - value : value);\n}\n\n";
+    }
+    out << "int main(void) {\n";
+    for (const auto& name : order) {
+        out << "    int " << variable(name) << " = 0;\n";
+        if (flagged.count(name)) out << "    int " << variable(name) << "_set = 0;\n";
+    }
+    out << "\n";
+
+    auto label = [](const string& name) { return identifier("L_", name); };
+    auto assign = [&](const string& result, const string& expression) {
+        out << "    " << variable(result) << " = " << expression << ";";
+        if (flagged.count(result)) out << " " << variable(result) << "_set = 1;";
+        out << "\n";
+    };
+    static const unordered_map<string, string> wrapping = {{"+", "+"}, {"-", "-"}, {"*", "*"}};
+    static const unordered_map<string, string> comparisons = {
+        {"<", "<"}, {">", ">"}, {"<=", "<="}, {">=", ">="}, {"==", "=="}, {"!=", "!="}};
+
+    vector<string> params;
+    auto lower = [&](size_t& i) {
+        const auto& instr = code[i];
+        const string& op = instr.op;
+        string a = value(instr.arg1), b = value(instr.arg2);
+        if (op == "" || op == "=" || op == "MOV") {
+            assign(instr.result, a);
+        } else if (wrapping.count(op)) {
+            assign(instr.result, "(int)((unsigned)" + a + " " + wrapping.at(op) + " (unsigned)" + b + ")");
+        } else if (comparisons.count(op)) {
+            assign(instr.result, a + " " + comparisons.at(op) + " " + b);
+        } else if (op == "/" || op == "%") {
+            assign(instr.result, string(op == "/" ? "rt_div(" : "rt_mod(") + a + ", " + b + ")");
+        } else if (op == "label") {
+            out << label(instr.result) << ": ;\n";
+        } else if (op == "goto") {
+            // like the interpreter, a jump to a missing label falls through
+            if (labels.count(instr.result)) out << "    goto " << label(instr.result) << ";\n";
+        } else if (op == "ifFalse") {
+            if (labels.count(instr.result)) out << "    if (!" << a << ") goto " << label(instr.result) << ";\n";
+        } else if (op == "jumptable") {
+            out << "    switch ((long long)" << a << " - " << b << "LL) {\n";
+            for (int k = 0; i + 1 < code.size() && code[i + 1].op == "case"; ++k) {
+                const string& target = code[++i].result;
+                out << "    case " << k << ": ";
+                if (labels.count(target)) out << "goto " << label(target) << ";\n";
+                else out << "break;\n";
+            }
+            if (labels.count(instr.result)) out << "    default: goto " << label(instr.result) << ";\n";
+            out << "    }\n";
+        } else if (op == "print") {
+            if (flagged.count(instr.arg1)) {
+                string name = variable(instr.arg1);
+                out << "    if (" << name << "_set) printf(\"%d\\n\", " << name << "); else puts("
+                    << quote(instr.arg1) << ");\n";
+            } else {
+                string text = isStringLiteral(instr.arg1) ? literalText(instr.arg1) : instr.arg1;
+                out << "    puts(" << quote(text) << ");\n";
+            }
+        } else if (op == "read") {
+            assign(instr.result, "rt_read()");
+        } else if (op == "load") {
+            assign(instr.result, identifier("a_", instr.arg1) + "[" + b + "]");
+        } else if (op == "store") {
+            out << "    " << identifier("a_", instr.result) << "[" << a << "] = " << b << ";\n";
+        } else if (op == "bounds") {
+            string suffix = outOfBoundsSuffix(instr.result, stol(instr.arg2));
+            out << "    if ((unsigned)" << a << " >= " << b << "u) rt_bounds(" << a << ", " << quote(suffix) << ");\n";
+        } else if (op == "param") {
+            params.push_back(instr.arg1.empty() ? instr.result : instr.arg1);
+        } else if (op == "call") {
+            if (instr.result == "prrint" && !params.empty()) {
+                out << "    printf(\"%d\\n\", " << value(params.back()) << ");\n";
+                params.clear();
+            }
+        } else if (op == "return") {
+            out << "    return " << a << ";\n";
+        }
+    };
+
+    // A parallel loop becomes an OpenMP `for` over the loop variable. What
+    // the body writes is private to an iteration, starting from its value
+    // before the loop; the reduction variables and their print flags are
+    // OpenMP reductions.
+    auto lowerParallel = [&](const ParallelLoop& loop) {
+        int id = parallelLoops++;
+        string lo = "rt_lo" + to_string(id), hi = "rt_hi" + to_string(id), k = "rt_k" + to_string(id);
+        string var = variable(loop.var);
+        unordered_set<string> reduced;
+        vector<string> sums, products, flags;
+        for (const auto& reduction : loop.reductions) {
+            if (!isName(reduction.first) || !reduced.insert(reduction.first).second) continue;
+            (reduction.second == 1 ? products : sums).push_back(variable(reduction.first));
+            if (flagged.count(reduction.first)) flags.push_back(variable(reduction.first) + "_set");
+        }
+        vector<string> privates = {var};
+        unordered_set<string> seen = {loop.var};
+        for (int j = loop.body; j < loop.increment; ++j) {
+            const string& result = code[j].result;
+            if (!writesResult(code[j]) || reduced.count(result) || !seen.insert(result).second) continue;
+            privates.push_back(variable(result));
+            if (flagged.count(result)) privates.push_back(variable(result) + "_set");
+        }
+        auto clause = [&](const string& name, const vector<string>& list) {
+            if (list.empty()) return;
+            out << " " << name;
+            for (size_t j = 0; j < list.size(); ++j) out << (j ? ", " : "") << list[j];
+            out << ")";
+        };
+        out << "    {\n    int " << lo << " = " << var << ", " << hi << " = " << value(loop.bound) << ";\n"
+            << "    #pragma omp parallel for schedule(static)";
+        clause("firstprivate(", privates);
+        clause("reduction(+: ", sums);
+        clause("reduction(*: ", products);
+        clause("reduction(|: ", flags);
+        out << "\n    for (int " << k << " = " << lo << "; " << k << " < " << hi << "; " << k << "++) {\n"
+            << "    " << var << " = " << k << ";\n";
+        for (size_t j = loop.body; j < (size_t)loop.increment; ++j) lower(j);
+        out << "    }\n    if (" << lo << " < " << hi << ") " << var << " = " << hi << ";\n    }\n";
+        if (labels.count(code[loop.exit].result)) out << "    goto " << label(code[loop.exit].result) << ";\n";
+    };
+
+    unordered_map<size_t, ParallelLoop> parallel;  // by header index
+    for (size_t i = 0; i < code.size(); ++i) {
+        ParallelLoop loop;
+        if (code[i].op == "parallel" && findParallelLoop(code, i, loop)) parallel[loop.header] = loop;
+    }
+    for (size_t i = 0; i < code.size(); ++i) {
+        auto loop = parallel.find(i);
+        if (loop == parallel.end()) {
+            lower(i);
+            continue;
+        }
+        lowerParallel(loop->second);
+        i = loop->second.backEdge;
+    }
+    out << "    return 0;\n}\n";
+    return out.str();
+}
+
+bool CSourceGenerator::buildExecutable(const vector<Instruction>& code, const string& output) {
+    if (!findStringNames(code).empty()) {
+        errors.push_back("sttring values are only supported by the interpreter");
+        return false;
+    }
+    string source = output + ".c";
+    ofstream file(source);
+    if (!file) {
+        errors.push_back("Could not write " + source);
+        return false;
+    }
+    file << generate(code);
+    file.close();
+
+    string compile = "cc -O2 -w -o \"" + output + "\" \"" + source + "\"";
+    if (parallelLoops) {
+        // without OpenMP the pragmas are ignored and the loops run sequentially
+        string openmp = "cc -O2 -fopenmp -w -o \"" + output + "\" \"" + source + "\"";
+        if (system(openmp.c_str()) == 0) return true;
+    }
+    if (system(compile.c_str()) != 0) {
+        errors.push_back("C compiler failed: " + compile);
+        return false;
+    }
+    return true;
+}
+
+void CSourceGenerator::printErrors() {
+    for (const auto& error : errors) cerr << "C backend error: " << error << endl;
+}
+
+bool CSourceGenerator::hasErrors() const {
+    return !errors.empty();
+}
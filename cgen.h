@@ -0,0 +1,35 @@
+#ifndef CGEN_H
+#define CGEN_H
+
+#include "icg.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+// Translates the IR into a single C file whose main() behaves like the
+// interpreter: variables are int locals starting at 0, arithmetic wraps,
+// division by zero gives 0, and printing a never-assigned variable prints
+// its name. `return` becomes main's return value. Arrays are static int
+// arrays, and a failed bounds check stops the program with status 1.
+// Parallel loops become OpenMP loops.
+class CSourceGenerator {
+public:
+    string generate(const vector<Instruction>& code);
+    // Writes output.c and compiles it with `cc -O2`, adding -fopenmp when
+    // there are parallel loops and the compiler supports it.
+    bool buildExecutable(const vector<Instruction>& code, const string& output);
+    void printErrors();
+    bool hasErrors() const;
+
+private:
+    unordered_map<string, string> names;  // IR variable -> C identifier
+    vector<string> errors;
+    int parallelLoops = 0;  // in the last generated source
+
+    string variable(const string& name);
+    string value(const string& arg);
+};
+
+#endif
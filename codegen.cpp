@@ -1,21 +1,51 @@
-#include "codegen.h"
-#include <iostream>
-
-using namespace std;
-
-void CodeGenerator::generateAssembly(const vector<Instruction>& icgInstructions) {
-    int regCount = 0;
-
-    for (const auto& instr : icgInstructions) {
-        if (instr.op.empty()) {
-            // Simple assignment
-            cout << "MOV " << instr.result << ", " << instr.arg1 << endl;
-        } else {
-            // Binary operation
-            string reg = "R" + to_string(regCount++);
-            cout << "MOV " << reg << ", " << instr.arg1 << endl;
-            cout << instr.op << " " << reg << ", " << instr.arg2 << endl;
-            cout << "MOV " << instr.result << ", " << reg << endl;
-        }
-    }
-}
+#include "codegen.h"
+#include <iostream>
+
+using namespace std;
+
+void CodeGenerator::generateAssembly(const vector<Instruction>& icgInstructions, ostream& out) {
+    int regCount = 0;
+    int tableCount = 0;
+
+    for (size_t i = 0; i < icgInstructions.size(); ++i) {
+        const auto& instr = icgInstructions[i];
+        if (instr.op == "jumptable") {
+            // Bounds check against the entry count, then an indexed jump.
+            size_t entries = 0;
+            while (i + 1 + entries < icgInstructions.size() &&
+                   icgInstructions[i + 1 + entries].op == "case") entries++;
+            string reg = "R" + to_string(regCount++);
+            string table = "JT" + to_string(tableCount++);
+            out << "MOV " << reg << ", " << instr.arg1 << endl;
+            out << "SUB " << reg << ", " << instr.arg2 << endl;
+            out << "CMP " << reg << ", " << entries << endl;
+            out << "JAE " << instr.result << endl;
+            out << "JMP [" << table << " + " << reg << "]" << endl;
+            out << table << ":" << endl;
+        } else if (instr.op == "case") {
+            out << ".word " << instr.result << endl;
+        } else if (instr.op == "read") {
+            out << "IN " << instr.result << endl;
+        } else if (instr.op == "array") {
+            out << instr.result << ": .space " << instr.arg1 << " * 4" << endl;
+        } else if (instr.op == "load") {
+            out << "MOV " << instr.result << ", [" << instr.arg1 << " + 4 * " << instr.arg2 << "]" << endl;
+        } else if (instr.op == "store") {
+            out << "MOV [" << instr.result << " + 4 * " << instr.arg1 << "], " << instr.arg2 << endl;
+        } else if (instr.op == "bounds") {
+            out << "CMP " << instr.arg1 << ", " << instr.arg2 << endl;
+            out << "JAE bounds_error" << endl;
+        } else if (instr.op == "parallel" || instr.op == "reduce") {
+            out << "; " << instr.op << " " << instr.arg1 << ", " << instr.arg2 << endl;
+        } else if (instr.op.empty()) {
+            // Simple assignment
+            out << "MOV " << instr.result << ", " << instr.arg1 << endl;
+        } else {
+            // Binary operation
+            string reg = "R" + to_string(regCount++);
+            out << "MOV " << reg << ", " << instr.arg1 << endl;
+            out << instr.op << " " << reg << ", " << instr.arg2 << endl;
+            out << "MOV " << instr.result << ", " << reg << endl;
+        }
+    }
+}
@@ -1,13 +1,14 @@
-#ifndef CODEGEN_H
-#define CODEGEN_H
-
-#include "icg.h"
-#include <vector>
-#include <string>
-
-class CodeGenerator {
-public:
-    void generateAssembly(const std::vector<Instruction>& icgInstructions);
-};
-
-#endif
+#ifndef CODEGEN_H
+#define CODEGEN_H
+
+#include "icg.h"
+#include <iostream>
+#include <vector>
+#include <string>
+
+class CodeGenerator {
+public:
+    void generateAssembly(const std::vector<Instruction>& icgInstructions, std::ostream& out = std::cout);
+};
+
+#endif
@@ -0,0 +1,140 @@
+#include "compiler.h"
+#include <iostream>
+#include <sstream>
+#include "codegen.h"
+
+string readSource(InputReader& in, vector<string>* lines) {
+    string line, code;
+    while (in.readLine(line)) {
+        if (line == "#") break;
+        code += line + "\n";
+        if (lines) lines->push_back(line);
+    }
+    return code;
+}
+
+void printCode(const vector<Instruction>& code) {
+    for (auto& instr : code) {
+        if (instr.op == "label") {
+            cout << instr.result << ":\n";
+        } else {
+            cout << instr.op << " " << instr.arg1;
+            if (!instr.arg2.empty()) cout << ", " << instr.arg2;
+            if (!instr.result.empty()) cout << " => " << instr.result;
+            cout << endl;
+        }
+    }
+}
+
+void printThreeAddressCode(const vector<Instruction>& code) {
+    for (const auto& instr : code) {
+        if (instr.op == "label") {
+            cout << instr.result << ":\n";
+        } else if (instr.op == "goto") {
+            cout << "goto " << instr.result << "\n";
+        } else if (instr.op == "ifFalse") {
+            cout << "ifFalse " << instr.arg1 << " goto " << instr.result << "\n";
+        } else if (instr.op == "call") {
+            cout << "call " << instr.result << "\n";
+        } else if (instr.op == "return") {
+            cout << "return " << instr.arg1 << "\n";
+        } else if (instr.op == "=") {
+            cout << instr.result << " = " << instr.arg1 << "\n";
+        } else if (instr.op == "param") {
+            cout << "param " << instr.arg1 << "\n";
+        } else if (instr.op == "print") {
+            cout << "print " << instr.arg1 << "\n";
+        } else {
+            cout << instr.result << " = " << instr.arg1 << " " << instr.op << " " << instr.arg2 << "\n";
+        }
+    }
+}
+
+Compiler::Compiler(const OptimizerOptions& options) : options(options) {}
+
+bool Compiler::compile(const string& source, CompileStage last) {
+    stage = STAGE_LEXER;
+    tokens = tokenize(source);
+    if (last == STAGE_LEXER) return true;
+
+    stage = STAGE_PARSER;
+    parser.reset(new Parser(tokens));
+    root = parser->parse();
+    if (!root) {
+        errors = parser->getErrors();
+        return false;
+    }
+    if (last == STAGE_PARSER) return true;
+
+    stage = STAGE_SEMANTIC;
+    sema.analyze(root);
+    if (sema.hasErrors()) {
+        errors = sema.getErrors();
+        return false;
+    }
+    if (last == STAGE_SEMANTIC) return true;
+
+    stage = STAGE_ICG;
+    icg.generate(root);
+    if (last == STAGE_ICG) return true;
+
+    stage = STAGE_OPTIMIZER;
+    optimizer.reset(new Optimizer(options));
+    optimized = optimizer->optimize(icg.getICG());
+    if (optimizer->hasErrors()) {
+        errors = optimizer->getErrors();
+        return false;
+    }
+    if (last == STAGE_OPTIMIZER) return true;
+
+    stage = STAGE_CODEGEN;
+    ostringstream out;
+    CodeGenerator codegen;
+    codegen.generateAssembly(optimized, out);
+    assembly = out.str();
+    return true;
+}
+
+CompileStage Compiler::getStage() const {
+    return stage;
+}
+
+const vector<Token>& Compiler::getTokens() const {
+    return tokens;
+}
+
+Parser& Compiler::getParser() {
+    return *parser;
+}
+
+ParseNode* Compiler::getParseTree() const {
+    return root;
+}
+
+SemanticAnalyzer& Compiler::getSemantic() {
+    return sema;
+}
+
+IntermediateCodeGenerator& Compiler::getICG() {
+    return icg;
+}
+
+const vector<Instruction>& Compiler::getOptimized() const {
+    return optimized;
+}
+
+Optimizer& Compiler::getOptimizer() {
+    return *optimizer;
+}
+
+const string& Compiler::getAssembly() const {
+    return assembly;
+}
+
+bool Compiler::hasErrors() const {
+    return !errors.empty();
+}
+
+const vector<string>& Compiler::getErrors() const {
+    return errors;
+}
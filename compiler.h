@@ -0,0 +1,64 @@
+#ifndef COMPILER_H
+#define COMPILER_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "lexer.h"
+#include "parser.h"
+#include "semantic.h"
+#include "icg.h"
+#include "optimizer.h"
+#include "runtime_io.h"
+
+using namespace std;
+
+// Reads source text up to a line holding only `#`, or to the end of the
+// input. The rest of `in` is left to the program's `san` calls.
+string readSource(InputReader& in, vector<string>* lines = nullptr);
+
+void printCode(const vector<Instruction>& code);  // as `+ a, b => t1`, one per line
+void printThreeAddressCode(const vector<Instruction>& code);  // as `t1 = a + b`, one per line
+
+enum CompileStage { STAGE_LEXER, STAGE_PARSER, STAGE_SEMANTIC, STAGE_ICG, STAGE_OPTIMIZER, STAGE_CODEGEN };
+
+// The pipeline from source text to pseudo-assembly: lexer, parser, semantic
+// analysis, intermediate code, optimization and code generation. compile()
+// runs the stages in order up to `last` and stops after one that reports
+// errors. A Compiler compiles one program and owns all it produced, parse
+// tree included. It keeps no state outside itself, so separate instances
+// may compile on separate threads at once.
+class Compiler {
+public:
+    explicit Compiler(const OptimizerOptions& options = OptimizerOptions());
+
+    bool compile(const string& source, CompileStage last = STAGE_CODEGEN);  // false on errors
+    CompileStage getStage() const;  // the last stage that ran
+
+    const vector<Token>& getTokens() const;
+    Parser& getParser();
+    ParseNode* getParseTree() const;  // nullptr after a syntax error
+    SemanticAnalyzer& getSemantic();
+    IntermediateCodeGenerator& getICG();
+    const vector<Instruction>& getOptimized() const;
+    Optimizer& getOptimizer();        // once the optimizer has run
+    const string& getAssembly() const;
+
+    bool hasErrors() const;
+    const vector<string>& getErrors() const;  // syntax, semantic or IR verification errors, whichever stopped the compilation
+
+private:
+    OptimizerOptions options;
+    vector<Token> tokens;
+    unique_ptr<Parser> parser;
+    ParseNode* root = nullptr;
+    SemanticAnalyzer sema;
+    IntermediateCodeGenerator icg;
+    unique_ptr<Optimizer> optimizer;  // created when needed, as it may start threads
+    vector<Instruction> optimized;
+    string assembly;
+    vector<string> errors;
+    CompileStage stage = STAGE_LEXER;
+};
+
+#endif
@@ -0,0 +1,239 @@
+#include "elf.h"
+#include "encoder.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <elf.h>
+#include <fstream>
+#include <iostream>
+#include <sys/stat.h>
+#include <unordered_map>
+
+using namespace std;
+
+static const uint64_t BASE_ADDRESS = 0x400000;
+static const uint64_t PAGE = 0x1000;
+
+static uint64_t alignUp(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+template <typename T>
+static void append(vector<uint8_t>& out, const T& value) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+bool ElfWriter::writeExecutable(const MachineProgram& program, const string& path) {
+    errors.clear();
+    X86Encoder encoder;
+    if (!encoder.encode(program.text)) {
+        errors.push_back("Could not encode the program");
+        encoder.printErrors();
+        return false;
+    }
+    const vector<uint8_t>& text = encoder.getCode();
+
+    // ---- Layout ----
+    int segments = program.bss.empty() ? 1 : 2;
+    uint64_t textOffset = alignUp(sizeof(Elf64_Ehdr) + segments * sizeof(Elf64_Phdr), 16);
+    uint64_t rodataOffset = alignUp(textOffset + text.size(), 16);
+    vector<uint8_t> rodata;
+
+    struct Symbol { string name; uint64_t address; uint64_t size; int section; };
+    vector<Symbol> symbols;
+    unordered_map<string, uint64_t> addresses;
+    enum { TEXT = 1, RODATA = 2, BSS = 3 };
+
+    for (const auto& label : encoder.getLabels()) {
+        addresses[label.first] = BASE_ADDRESS + textOffset + label.second;
+        symbols.push_back({label.first, addresses[label.first], 0, TEXT});
+    }
+    for (const auto& str : program.strings) {
+        addresses[str.first] = BASE_ADDRESS + rodataOffset + rodata.size();
+        symbols.push_back({str.first, addresses[str.first], str.second.size(), RODATA});
+        rodata.insert(rodata.end(), str.second.begin(), str.second.end());
+    }
+    uint64_t segmentEnd = rodataOffset + rodata.size();
+    uint64_t bssAddress = alignUp(BASE_ADDRESS + segmentEnd, PAGE);
+    uint64_t bssSize = 0;
+    for (const auto& block : program.bss) {
+        bssSize = alignUp(bssSize, 16);
+        addresses[block.first] = bssAddress + bssSize;
+        symbols.push_back({block.first, addresses[block.first], (uint64_t)block.second, BSS});
+        bssSize += block.second;
+    }
+    if (!addresses.count(program.entry)) {
+        errors.push_back("Entry symbol " + program.entry + " is not defined");
+        return false;
+    }
+
+    // ---- Relocation ----
+    vector<uint8_t> code = text;
+    for (const auto& relocation : encoder.getRelocations()) {
+        auto symbol = addresses.find(relocation.symbol);
+        if (symbol == addresses.end()) {
+            errors.push_back("Undefined symbol " + relocation.symbol);
+            continue;
+        }
+        uint64_t field = BASE_ADDRESS + textOffset + relocation.offset;
+        int64_t value = (int64_t)symbol->second + relocation.addend - (int64_t)field;
+        if (value < INT32_MIN || value > INT32_MAX) {
+            errors.push_back("Relocation out of range for " + relocation.symbol);
+            continue;
+        }
+        int32_t field32 = (int32_t)value;
+        memcpy(&code[relocation.offset], &field32, sizeof(field32));
+    }
+    if (!errors.empty()) return false;
+
+    // ---- Symbol and string tables ----
+    // Locals first, as ELF requires, with the entry point as the only global.
+    sort(symbols.begin(), symbols.end(), [&](const Symbol& a, const Symbol& b) {
+        bool aGlobal = a.name == program.entry, bGlobal = b.name == program.entry;
+        if (aGlobal != bGlobal) return bGlobal;
+        return a.address != b.address ? a.address < b.address : a.name < b.name;
+    });
+    vector<uint8_t> symtab, strtab(1, 0);
+    append(symtab, Elf64_Sym{});
+    int firstGlobal = 1;
+    for (const auto& symbol : symbols) {
+        if (symbol.name.compare(0, 2, ".L") == 0) continue;
+        Elf64_Sym entry = {};
+        entry.st_name = strtab.size();
+        bool global = symbol.name == program.entry;
+        int type = symbol.section == TEXT ? STT_FUNC : STT_OBJECT;
+        entry.st_info = ELF64_ST_INFO(global ? STB_GLOBAL : STB_LOCAL, type);
+        entry.st_shndx = symbol.section;
+        entry.st_value = symbol.address;
+        entry.st_size = symbol.size;
+        append(symtab, entry);
+        if (!global) firstGlobal++;
+        strtab.insert(strtab.end(), symbol.name.begin(), symbol.name.end());
+        strtab.push_back(0);
+    }
+
+    vector<uint8_t> shstrtab(1, 0);
+    auto sectionName = [&](const string& name) {
+        uint32_t offset = shstrtab.size();
+        shstrtab.insert(shstrtab.end(), name.begin(), name.end());
+        shstrtab.push_back(0);
+        return offset;
+    };
+
+    // ---- File ----
+    vector<uint8_t> file;
+    Elf64_Ehdr header = {};
+    memcpy(header.e_ident, ELFMAG, SELFMAG);
+    header.e_ident[EI_CLASS] = ELFCLASS64;
+    header.e_ident[EI_DATA] = ELFDATA2LSB;
+    header.e_ident[EI_VERSION] = EV_CURRENT;
+    header.e_ident[EI_OSABI] = ELFOSABI_SYSV;
+    header.e_type = ET_EXEC;
+    header.e_machine = EM_X86_64;
+    header.e_version = EV_CURRENT;
+    header.e_entry = addresses[program.entry];
+    header.e_phoff = sizeof(Elf64_Ehdr);
+    header.e_ehsize = sizeof(Elf64_Ehdr);
+    header.e_phentsize = sizeof(Elf64_Phdr);
+    header.e_phnum = segments;
+    header.e_shentsize = sizeof(Elf64_Shdr);
+    header.e_shnum = 7;
+    header.e_shstrndx = 6;
+    append(file, header);
+
+    Elf64_Phdr codeSegment = {};
+    codeSegment.p_type = PT_LOAD;
+    codeSegment.p_flags = PF_R | PF_X;
+    codeSegment.p_offset = 0;
+    codeSegment.p_vaddr = codeSegment.p_paddr = BASE_ADDRESS;
+    codeSegment.p_filesz = codeSegment.p_memsz = segmentEnd;
+    codeSegment.p_align = PAGE;
+    append(file, codeSegment);
+    if (segments == 2) {
+        Elf64_Phdr dataSegment = {};
+        dataSegment.p_type = PT_LOAD;
+        dataSegment.p_flags = PF_R | PF_W;
+        dataSegment.p_offset = 0;
+        dataSegment.p_vaddr = dataSegment.p_paddr = bssAddress;
+        dataSegment.p_filesz = 0;
+        dataSegment.p_memsz = bssSize;
+        dataSegment.p_align = PAGE;
+        append(file, dataSegment);
+    }
+
+    file.resize(textOffset, 0);
+    file.insert(file.end(), code.begin(), code.end());
+    file.resize(rodataOffset, 0);
+    file.insert(file.end(), rodata.begin(), rodata.end());
+
+    file.resize(alignUp(file.size(), 8), 0);
+    uint64_t symtabOffset = file.size();
+    file.insert(file.end(), symtab.begin(), symtab.end());
+    uint64_t strtabOffset = file.size();
+    file.insert(file.end(), strtab.begin(), strtab.end());
+
+    vector<Elf64_Shdr> sections(7);
+    sections[TEXT].sh_name = sectionName(".text");
+    sections[TEXT].sh_type = SHT_PROGBITS;
+    sections[TEXT].sh_flags = SHF_ALLOC | SHF_EXECINSTR;
+    sections[TEXT].sh_addr = BASE_ADDRESS + textOffset;
+    sections[TEXT].sh_offset = textOffset;
+    sections[TEXT].sh_size = code.size();
+    sections[TEXT].sh_addralign = 16;
+    sections[RODATA].sh_name = sectionName(".rodata");
+    sections[RODATA].sh_type = SHT_PROGBITS;
+    sections[RODATA].sh_flags = SHF_ALLOC;
+    sections[RODATA].sh_addr = BASE_ADDRESS + rodataOffset;
+    sections[RODATA].sh_offset = rodataOffset;
+    sections[RODATA].sh_size = rodata.size();
+    sections[RODATA].sh_addralign = 1;
+    sections[BSS].sh_name = sectionName(".bss");
+    sections[BSS].sh_type = SHT_NOBITS;
+    sections[BSS].sh_flags = SHF_ALLOC | SHF_WRITE;
+    sections[BSS].sh_addr = bssAddress;
+    sections[BSS].sh_offset = rodataOffset + rodata.size();
+    sections[BSS].sh_size = bssSize;
+    sections[BSS].sh_addralign = 16;
+    sections[4].sh_name = sectionName(".symtab");
+    sections[4].sh_type = SHT_SYMTAB;
+    sections[4].sh_offset = symtabOffset;
+    sections[4].sh_size = symtab.size();
+    sections[4].sh_link = 5;
+    sections[4].sh_info = firstGlobal;
+    sections[4].sh_addralign = 8;
+    sections[4].sh_entsize = sizeof(Elf64_Sym);
+    sections[5].sh_name = sectionName(".strtab");
+    sections[5].sh_type = SHT_STRTAB;
+    sections[5].sh_offset = strtabOffset;
+    sections[5].sh_size = strtab.size();
+    sections[5].sh_addralign = 1;
+    sections[6].sh_name = sectionName(".shstrtab");
+    sections[6].sh_type = SHT_STRTAB;
+    sections[6].sh_offset = file.size();
+    sections[6].sh_size = shstrtab.size();
+    sections[6].sh_addralign = 1;
+    file.insert(file.end(), shstrtab.begin(), shstrtab.end());
+
+    file.resize(alignUp(file.size(), 8), 0);
+    uint64_t sectionsOffset = file.size();
+    for (const auto& section : sections) append(file, section);
+    memcpy(&file[0] + offsetof(Elf64_Ehdr, e_shoff), &sectionsOffset, sizeof(sectionsOffset));
+
+    ofstream out(path, ios::binary | ios::trunc);
+    if (!out.write(reinterpret_cast<const char*>(file.data()), file.size())) {
+        errors.push_back("Could not write " + path);
+        return false;
+    }
+    out.close();
+    chmod(path.c_str(), 0755);
+    return true;
+}
+
+void ElfWriter::printErrors() {
+    for (const auto& error : errors) cerr << "ELF writer error: " << error << endl;
+}
+
+bool ElfWriter::hasErrors() const {
+    return !errors.empty();
+}
@@ -0,0 +1,25 @@
+#ifndef ELF_H
+#define ELF_H
+
+#include "machine.h"
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Writes a MachineProgram as a static x86-64 Linux executable without any
+// external tools: the text is encoded with X86Encoder, the string constants
+// follow it in the same read/execute segment, and the zeroed data gets a
+// read/write segment of its own. Symbols other than assembler-local ".L"
+// labels go into .symtab so the result can be inspected with readelf.
+class ElfWriter {
+public:
+    bool writeExecutable(const MachineProgram& program, const string& path);
+    void printErrors();
+    bool hasErrors() const;
+
+private:
+    vector<string> errors;
+};
+
+#endif
@@ -0,0 +1,273 @@
+#include "encoder.h"
+#include <iostream>
+
+using namespace std;
+
+static bool fitsInt8(long long value) {
+    return value >= -128 && value <= 127;
+}
+
+static bool fitsInt32(long long value) {
+    return value >= INT32_MIN && value <= INT32_MAX;
+}
+
+// Condition codes of jcc/setcc, as added to the 0x80/0x90 opcodes.
+static int conditionCode(const string& cc) {
+    static const unordered_map<string, int> codes = {
+        {"o", 0x0}, {"no", 0x1}, {"b", 0x2}, {"ae", 0x3}, {"e", 0x4}, {"z", 0x4},
+        {"ne", 0x5}, {"nz", 0x5}, {"be", 0x6}, {"a", 0x7}, {"s", 0x8}, {"ns", 0x9},
+        {"p", 0xA}, {"np", 0xB}, {"l", 0xC}, {"ge", 0xD}, {"le", 0xE}, {"g", 0xF}};
+    auto it = codes.find(cc);
+    return it == codes.end() ? -1 : it->second;
+}
+
+void X86Encoder::emitBytes(long long value, int count) {
+    for (int i = 0; i < count; ++i) code.push_back((uint8_t)(value >> (8 * i)));
+}
+
+// REX prefix, opcode, ModRM, SIB, displacement and immediate for an
+// instruction with a register (or /digit) field and a register/memory
+// operand. Byte operations on spl..dil need a REX prefix even when empty.
+void X86Encoder::emitModRM(int width, const vector<uint8_t>& opcode, int regField, bool regIsRegister,
+                           const MachineOperand& rm, int immBytes, long long imm) {
+    int rex = 0x40;
+    if (width == 64) rex |= 0x08;
+    if (regField & 8) rex |= 0x04;
+    if (rm.kind == MachineOperand::REG) {
+        if (rm.base & 8) rex |= 0x01;
+    } else {
+        if (rm.index != NO_REGISTER && (rm.index & 8)) rex |= 0x02;
+        if (rm.base != NO_REGISTER && (rm.base & 8)) rex |= 0x01;
+    }
+    bool needRex = rex != 0x40;
+    if (width == 8) {
+        if (regIsRegister && regField >= 4 && regField < 8) needRex = true;
+        if (rm.kind == MachineOperand::REG && rm.base >= 4 && rm.base < 8) needRex = true;
+    }
+    if (needRex) code.push_back(rex);
+    code.insert(code.end(), opcode.begin(), opcode.end());
+
+    size_t ripField = string::npos;
+    int reg = (regField & 7) << 3;
+    if (rm.kind == MachineOperand::REG) {
+        code.push_back(0xC0 | reg | (rm.base & 7));
+    } else if (rm.base == NO_REGISTER) {
+        code.push_back(reg | 5);
+        ripField = code.size();
+        emitBytes(0, 4);
+    } else {
+        int base = rm.base & 7;
+        bool sib = rm.index != NO_REGISTER || base == 4;
+        long long displacement = rm.value;
+        int mod = displacement == 0 && base != 5 ? 0 : fitsInt8(displacement) ? 1 : 2;
+        code.push_back((mod << 6) | reg | (sib ? 4 : base));
+        if (sib) {
+            int scale = rm.scale == 8 ? 3 : rm.scale == 4 ? 2 : rm.scale == 2 ? 1 : 0;
+            int index = rm.index == NO_REGISTER ? 4 : rm.index & 7;
+            code.push_back((scale << 6) | (index << 3) | base);
+        }
+        if (mod == 1) emitBytes(displacement, 1);
+        if (mod == 2) emitBytes(displacement, 4);
+    }
+    emitBytes(imm, immBytes);
+    if (ripField != string::npos) {
+        long long addend = rm.value - (long long)(code.size() - ripField);
+        fixups.push_back({ripField, rm.symbol, addend, ""});
+    }
+}
+
+void X86Encoder::emitRel32(const vector<uint8_t>& opcode, const string& symbol) {
+    code.insert(code.end(), opcode.begin(), opcode.end());
+    fixups.push_back({code.size(), symbol, -4, ""});
+    emitBytes(0, 4);
+}
+
+void X86Encoder::encodeInstr(const MachineInstr& instr) {
+    const string& op = instr.op;
+    const MachineOperand& src = instr.src;
+    const MachineOperand& dst = instr.dst;
+    bool srcReg = src.kind == MachineOperand::REG, srcImm = src.kind == MachineOperand::IMM;
+    bool srcMem = src.kind == MachineOperand::MEM, dstReg = dst.kind == MachineOperand::REG;
+
+    if (op == "label") {
+        if (!labels.emplace(dst.symbol, code.size()).second) errors.push_back("Duplicate label " + dst.symbol);
+        return;
+    }
+    if (op == ".long") {
+        fixups.push_back({code.size(), dst.symbol, 0, src.symbol});
+        emitBytes(0, 4);
+        return;
+    }
+    if (op.compare(0, 5, "lock ") == 0) {
+        code.push_back(0xF0);
+        encodeInstr({op.substr(5), src, dst});
+        return;
+    }
+    if (op == "ret") { code.push_back(0xC3); return; }
+    if (op == "syscall") { code.insert(code.end(), {0x0F, 0x05}); return; }
+    if (op == "cltd") { code.push_back(0x99); return; }
+    if (op == "cqto") { code.insert(code.end(), {0x48, 0x99}); return; }
+    if ((op == "pushq" || op == "popq") && dstReg) {
+        if (dst.base & 8) code.push_back(0x41);
+        code.push_back((op == "pushq" ? 0x50 : 0x58) + (dst.base & 7));
+        return;
+    }
+    if (op == "jmp" || op == "call") {
+        bool jump = op == "jmp";
+        if (dst.kind == MachineOperand::SYMBOL) emitRel32({(uint8_t)(jump ? 0xE9 : 0xE8)}, dst.symbol);
+        else emitModRM(32, {0xFF}, jump ? 4 : 2, false, dst);
+        return;
+    }
+    if (op[0] == 'j' && conditionCode(op.substr(1)) >= 0 && dst.kind == MachineOperand::SYMBOL) {
+        emitRel32({0x0F, (uint8_t)(0x80 + conditionCode(op.substr(1)))}, dst.symbol);
+        return;
+    }
+    if (op.compare(0, 3, "set") == 0 && conditionCode(op.substr(3)) >= 0) {
+        emitModRM(8, {0x0F, (uint8_t)(0x90 + conditionCode(op.substr(3)))}, 0, false, dst);
+        return;
+    }
+    if (op == "movzbl" && dstReg) {
+        emitModRM(srcReg && src.base >= 4 && src.base < 8 ? 8 : 32, {0x0F, 0xB6}, dst.base, false, src);
+        return;
+    }
+    if (op == "movslq" && dstReg) {
+        emitModRM(64, {0x63}, dst.base, true, src);
+        return;
+    }
+    if (op == "movabsq" && srcImm && dstReg) {
+        code.push_back(0x48 | (dst.base & 8 ? 1 : 0));
+        code.push_back(0xB8 + (dst.base & 7));
+        emitBytes(src.value, 8);
+        return;
+    }
+    if (op == "leaq" && srcMem && dstReg) {
+        emitModRM(64, {0x8D}, dst.base, true, src);
+        return;
+    }
+
+    char suffix = op.back();
+    int width = suffix == 'b' ? 8 : suffix == 'l' ? 32 : suffix == 'q' ? 64 : 0;
+    string name = op.substr(0, op.size() - 1);
+    if (width == 0) {
+        errors.push_back("Cannot encode " + formatInstruction(instr));
+        return;
+    }
+    bool byte = width == 8;
+    if (srcImm && !fitsInt32(src.value)) {
+        errors.push_back("Immediate out of range in " + formatInstruction(instr));
+        return;
+    }
+
+    static const unordered_map<string, int> alu = {
+        {"add", 0}, {"or", 1}, {"and", 4}, {"sub", 5}, {"xor", 6}, {"cmp", 7}};
+    static const unordered_map<string, int> unary = {
+        {"not", 2}, {"neg", 3}, {"mul", 4}, {"div", 6}, {"idiv", 7}};
+
+    if (name == "mov") {
+        if (srcImm && dstReg && width == 32) {
+            if (dst.base & 8) code.push_back(0x41);
+            code.push_back(0xB8 + (dst.base & 7));
+            emitBytes(src.value, 4);
+        } else if (srcImm) {
+            emitModRM(width, {(uint8_t)(byte ? 0xC6 : 0xC7)}, 0, false, dst, byte ? 1 : 4, src.value);
+        } else if (srcReg) {
+            emitModRM(width, {(uint8_t)(byte ? 0x88 : 0x89)}, src.base, true, dst);
+        } else if (srcMem && dstReg) {
+            emitModRM(width, {(uint8_t)(byte ? 0x8A : 0x8B)}, dst.base, true, src);
+        } else {
+            errors.push_back("Cannot encode " + formatInstruction(instr));
+        }
+        return;
+    }
+    auto aluOp = alu.find(name);
+    if (aluOp != alu.end()) {
+        int digit = aluOp->second;
+        if (srcImm) {
+            if (byte) emitModRM(8, {0x80}, digit, false, dst, 1, src.value);
+            else if (fitsInt8(src.value)) emitModRM(width, {0x83}, digit, false, dst, 1, src.value);
+            else emitModRM(width, {0x81}, digit, false, dst, 4, src.value);
+        } else if (srcReg) {
+            emitModRM(width, {(uint8_t)(digit * 8 + (byte ? 0 : 1))}, src.base, true, dst);
+        } else if (srcMem && dstReg) {
+            emitModRM(width, {(uint8_t)(digit * 8 + (byte ? 2 : 3))}, dst.base, true, src);
+        } else {
+            errors.push_back("Cannot encode " + formatInstruction(instr));
+        }
+        return;
+    }
+    if (name == "test") {
+        if (srcReg) emitModRM(width, {(uint8_t)(byte ? 0x84 : 0x85)}, src.base, true, dst);
+        else if (srcImm) emitModRM(width, {(uint8_t)(byte ? 0xF6 : 0xF7)}, 0, false, dst, byte ? 1 : 4, src.value);
+        else errors.push_back("Cannot encode " + formatInstruction(instr));
+        return;
+    }
+    if (name == "imul" && dstReg && !byte) {
+        if (srcImm && fitsInt8(src.value)) emitModRM(width, {0x6B}, dst.base, true, dst, 1, src.value);
+        else if (srcImm) emitModRM(width, {0x69}, dst.base, true, dst, 4, src.value);
+        else emitModRM(width, {0x0F, 0xAF}, dst.base, true, src);
+        return;
+    }
+    auto unaryOp = unary.find(name);
+    if (unaryOp != unary.end()) {
+        emitModRM(width, {(uint8_t)(byte ? 0xF6 : 0xF7)}, unaryOp->second, false, dst);
+        return;
+    }
+    if ((name == "xadd" || name == "cmpxchg") && srcReg && !byte) {
+        emitModRM(width, {0x0F, (uint8_t)(name == "xadd" ? 0xC1 : 0xB1)}, src.base, true, dst);
+        return;
+    }
+    if (name == "inc" || name == "dec") {
+        emitModRM(width, {(uint8_t)(byte ? 0xFE : 0xFF)}, name == "inc" ? 0 : 1, false, dst);
+        return;
+    }
+    errors.push_back("Cannot encode " + formatInstruction(instr));
+}
+
+bool X86Encoder::encode(const vector<MachineInstr>& text) {
+    code.clear();
+    labels.clear();
+    relocations.clear();
+    fixups.clear();
+    errors.clear();
+
+    for (const auto& instr : text) encodeInstr(instr);
+
+    for (const auto& fixup : fixups) {
+        auto target = labels.find(fixup.symbol);
+        if (!fixup.base.empty()) {
+            auto base = labels.find(fixup.base);
+            if (target == labels.end() || base == labels.end()) {
+                errors.push_back("Undefined label in table: " + fixup.symbol + " - " + fixup.base);
+                continue;
+            }
+            long long value = (long long)target->second - (long long)base->second;
+            for (int i = 0; i < 4; ++i) code[fixup.offset + i] = (uint8_t)(value >> (8 * i));
+        } else if (target != labels.end()) {
+            long long value = (long long)target->second + fixup.addend - (long long)fixup.offset;
+            for (int i = 0; i < 4; ++i) code[fixup.offset + i] = (uint8_t)(value >> (8 * i));
+        } else {
+            relocations.push_back({fixup.offset, fixup.symbol, fixup.addend});
+        }
+    }
+    return errors.empty();
+}
+
+const vector<uint8_t>& X86Encoder::getCode() const {
+    return code;
+}
+
+const unordered_map<string, size_t>& X86Encoder::getLabels() const {
+    return labels;
+}
+
+const vector<Relocation>& X86Encoder::getRelocations() const {
+    return relocations;
+}
+
+void X86Encoder::printErrors() {
+    for (const auto& error : errors) cerr << "Encoder error: " << error << endl;
+}
+
+bool X86Encoder::hasErrors() const {
+    return !errors.empty();
+}
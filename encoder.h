@@ -0,0 +1,52 @@
+#ifndef ENCODER_H
+#define ENCODER_H
+
+#include "machine.h"
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+// A 32-bit field in the code that refers to a symbol outside the encoded
+// text. The field must receive symbol + addend - (address of the field).
+struct Relocation {
+    size_t offset;
+    string symbol;
+    long long addend;
+};
+
+// Encodes machine instructions into x86-64 machine code. Jumps and calls use
+// 32-bit displacements; references between text labels are resolved here,
+// references to anything else (rip-relative data) are left as relocations.
+class X86Encoder {
+public:
+    bool encode(const vector<MachineInstr>& text);
+    const vector<uint8_t>& getCode() const;
+    const unordered_map<string, size_t>& getLabels() const;
+    const vector<Relocation>& getRelocations() const;
+    void printErrors();
+    bool hasErrors() const;
+
+private:
+    struct Fixup {
+        size_t offset;
+        string symbol;
+        long long addend;
+        string base;  // for ".long": the field holds symbol - base
+    };
+
+    vector<uint8_t> code;
+    unordered_map<string, size_t> labels;
+    vector<Relocation> relocations;
+    vector<Fixup> fixups;
+    vector<string> errors;
+
+    void encodeInstr(const MachineInstr& instr);
+    void emitModRM(int width, const vector<uint8_t>& opcode, int regField, bool regIsRegister,
+                   const MachineOperand& rm, int immBytes = 0, long long imm = 0);
+    void emitRel32(const vector<uint8_t>& opcode, const string& symbol);
+    void emitBytes(long long value, int count);
+};
+
+#endif
@@ -0,0 +1,145 @@
+#include "evaluator.h"
+#include <climits>
+#include <unordered_map>
+using namespace std;
+
+PartialEvaluator::PartialEvaluator(long stepBudget, size_t outputLimit)
+    : stepBudget(stepBudget), outputLimit(outputLimit) {}
+
+// Same literal rule as Interpreter::isNumber.
+bool PartialEvaluator::isNumber(const string& s) {
+    if (s.empty()) return false;
+    for (char c : s)
+        if (!isdigit(c) && c != '-') return false;
+    return true;
+}
+
+// Interpreter::getValue, except that literals which would not parse and
+// strings make the value unknown instead of throwing.
+bool PartialEvaluator::getValue(const string& token, int& value) {
+    if (isStringLiteral(token) || stringNames.count(token)) return false;
+    if (isNumber(token)) {
+        try {
+            value = stoi(token);
+        } catch (...) {
+            return false;
+        }
+        return true;
+    }
+    auto it = variables.find(token);
+    value = it != variables.end() ? it->second : 0;
+    return true;
+}
+
+void PartialEvaluator::evaluate(const vector<Instruction>& code) {
+    steps = 0;
+    output.clear();
+    variables.clear();
+    stopReason.clear();
+    stringNames = findStringNames(code);
+
+    unordered_map<string, int> labels;
+    vector<int> tableSize(code.size(), 0);
+    for (int i = 0; i < (int)code.size(); ++i) {
+        if (code[i].op == "label") labels[code[i].result] = i;
+        if (code[i].op == "jumptable") {
+            while (i + 1 + tableSize[i] < (int)code.size() && code[i + 1 + tableSize[i]].op == "case")
+                tableSize[i]++;
+        }
+    }
+    auto jump = [&](const string& label, int& pc) {
+        auto it = labels.find(label);
+        if (it != labels.end()) pc = it->second - 1;
+    };
+
+    int pc = 0;
+    for (; pc < (int)code.size(); ++pc) {
+        const Instruction& inst = code[pc];
+        if (steps >= stepBudget) {
+            stopReason = "step budget exhausted";
+            break;
+        }
+        if (output.size() >= outputLimit) {
+            stopReason = "output limit reached";
+            break;
+        }
+        steps++;
+
+        const string& op = inst.op;
+        int a = 0, b = 0;
+        if (op == "label" || op == "case" || op == "array" || op == "parallel" || op == "reduce") {
+            continue;
+        } else if (op == "=" || op == "MOV" || op.empty()) {
+            if (!getValue(inst.arg1, a)) break;
+            variables[inst.result] = a;
+        } else if (op == "+" || op == "-" || op == "*" || op == "/" || op == "%" ||
+                   op == "<" || op == ">" || op == "<=" || op == ">=" || op == "==" || op == "!=") {
+            if (!getValue(inst.arg1, a) || !getValue(inst.arg2, b)) break;
+            unsigned ua = a, ub = b;
+            int r;
+            if (op == "+") r = (int)(ua + ub);
+            else if (op == "-") r = (int)(ua - ub);
+            else if (op == "*") r = (int)(ua * ub);
+            else if (op == "/" || op == "%") {
+                if (a == INT_MIN && b == -1) {
+                    stopReason = "overflowing division";
+                    break;
+                }
+                r = b == 0 ? 0 : (op == "/" ? a / b : a % b);
+            }
+            else if (op == "<") r = a < b;
+            else if (op == ">") r = a > b;
+            else if (op == "<=") r = a <= b;
+            else if (op == ">=") r = a >= b;
+            else if (op == "==") r = a == b;
+            else r = a != b;
+            variables[inst.result] = r;
+        } else if (op == "ifFalse") {
+            if (!getValue(inst.arg1, a)) break;
+            if (!a) jump(inst.result, pc);
+        } else if (op == "goto") {
+            jump(inst.result, pc);
+        } else if (op == "jumptable") {
+            if (!getValue(inst.arg1, a) || !isNumber(inst.arg2)) break;
+            long long index = (long long)a - stoll(inst.arg2);
+            jump(index >= 0 && index < tableSize[pc] ? code[pc + 1 + index].result : inst.result, pc);
+        } else if (op == "print") {
+            if (stringNames.count(inst.arg1)) break;
+            auto it = variables.find(inst.arg1);
+            output.push_back(it != variables.end() ? to_string(it->second) : inst.arg1);
+        } else {
+            // return, param/call and anything else that talks to the outside world
+            stopReason = "'" + op + "' is evaluated at run time";
+            break;
+        }
+    }
+    if (stopReason.empty() && pc < (int)code.size()) {
+        stopReason = "operand cannot be evaluated";
+        if (steps > 0) steps--;
+    }
+    stopIndex = pc;
+}
+
+int PartialEvaluator::getStopIndex() const {
+    return stopIndex;
+}
+
+bool PartialEvaluator::finished() const {
+    return stopReason.empty();
+}
+
+long PartialEvaluator::getSteps() const {
+    return steps;
+}
+
+const string& PartialEvaluator::getStopReason() const {
+    return stopReason;
+}
+
+const vector<string>& PartialEvaluator::getOutput() const {
+    return output;
+}
+
+const map<string, int>& PartialEvaluator::getVariables() const {
+    return variables;
+}
@@ -0,0 +1,44 @@
+#ifndef EVALUATOR_H
+#define EVALUATOR_H
+
+#include "icg.h"
+#include <map>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+using namespace std;
+
+// Runs three-address code at compile time with the interpreter's semantics,
+// for as long as it stays independent of the outside world and within a step
+// budget. Afterwards the stop point, the printed lines and the variable state
+// at that point describe everything the executed prefix did. Only intt values
+// are evaluated: the first instruction that reads or writes a sttring or an
+// array element stops it.
+class PartialEvaluator {
+    long stepBudget;
+    size_t outputLimit;
+
+    long steps = 0;
+    int stopIndex = 0;
+    string stopReason;
+    vector<string> output;
+    map<string, int> variables;
+    unordered_set<string> stringNames;
+
+    bool isNumber(const string& s);
+    bool getValue(const string& token, int& value);
+
+public:
+    PartialEvaluator(long stepBudget, size_t outputLimit);
+    void evaluate(const vector<Instruction>& code);
+
+    int getStopIndex() const;                 // first instruction not executed
+    bool finished() const;                    // ran off the end of the program
+    long getSteps() const;
+    const string& getStopReason() const;
+    const vector<string>& getOutput() const;
+    const map<string, int>& getVariables() const;
+};
+
+#endif
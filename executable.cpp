@@ -1,86 +1,252 @@
-//g++ -std=gnu++17 executable.cpp lexer.cpp parser.cpp semantic.cpp icg.cpp optimizer.cpp codegen.cpp interpreter.cpp -o executable.exe
-
-// .\executable.exe
-
-#include <iostream>
-#include <string>
-#include <vector>
-#include "interpreter.h" 
-#include "lexer.h"
-#include "parser.h"
-#include "semantic.h"
-#include "icg.h"
-#include "optimizer.h"
-#include "codegen.h"
-#include "interpreter.h"
-using namespace std;
-
-int main() {
-    cout << "Enter your source code (end with # on a new line):\n";
-    string line, code;
-    while (getline(cin, line)) {
-        if (line == "#") break;
-        code += line + "\n";
-    }
-
-    // --- Lexical Analysis ---
-    vector<Token> tokens = tokenize(code);
-    cout << "\n--- Tokens ---\n";
-    printTokens(tokens);
-
-    // --- Syntax Analysis ---
-    Parser parser(tokens);
-    ParseNode* root = parser.parse();
-
-    if (!root) {
-        cout << "\n--- Syntax Error ---\n";
-        return 1;
-    }
-
-    cout << "\n--- Parse Tree ---\n";
-    parser.printParseTree(root);
-
-    // --- Semantic Analysis ---
-    SemanticAnalyzer sema;
-    sema.analyze(root);
-    sema.printErrors();
-
-    if (sema.hasErrors()) {
-        cout << "\nCompilation stopped due to semantic errors.\n";
-        return 1;
-    }
-
-    // --- Intermediate Code Generation ---
-    IntermediateCodeGenerator icg;
-    icg.generate(root);
-
-    cout << "\n--- Intermediate Code ---\n";
-    icg.printInstructions();
-
-    // --- Optimization ---
-    Optimizer optimizer;
-    vector<Instruction> optimized = optimizer.optimize(icg.getICG());
-
-    cout << "\n--- Optimized Code ---\n";
-    for (auto& instr : optimized) {
-        if (instr.op == "label") {
-            cout << instr.result << ":\n";
-        } else {
-            cout << instr.op << " " << instr.arg1;
-            if (!instr.arg2.empty()) cout << ", " << instr.arg2;
-            if (!instr.result.empty()) cout << " => " << instr.result;
-            cout << endl;
-        }
-    }
-
-    // --- Code Generation (Assembly stub) ---
-    CodeGenerator codegen;
-    codegen.generateAssembly(optimized);  
-
-    // --- Execution ---
-    Interpreter interpreter;
-    cout << "\n--- Output ---\n";
-    interpreter.execute(optimized);
-
-    return 0;
-}
+//g++ -std=gnu++17 executable.cpp compiler.cpp lexer.cpp parser.cpp semantic.cpp icg.cpp optimizer.cpp verifier.cpp evaluator.cpp profile.cpp thread_pool.cpp codegen.cpp machine.cpp regalloc.cpp peephole.cpp x86gen.cpp encoder.cpp elf.cpp jit.cpp cgen.cpp bytecode.cpp runtime_io.cpp runtime_string.cpp interpreter.cpp tree_interpreter.cpp -pthread -o executable.exe
+
+// .\executable.exe [-O0|-O1|-O2|-O3] [--stats] [--verify-ir] [--unroll-factor=N] [--unroll-limit=N] [--eval-budget=N]
+//                  [--profile-out=FILE] [--profile-use=FILE] [--threads=N]
+//                  [--native=FILE] [--system-as] [--native-c=FILE] [--engine=interpreter|jit|tree]
+//                  [--dispatch=switch|threaded] [--profile] [--profile-report=FILE] [--dump]
+//                  [--max-instructions=N] [--max-memory=BYTES] [--max-output=BYTES]
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include "interpreter.h" 
+#include "compiler.h"
+#include "x86gen.h"
+#include "jit.h"
+#include "cgen.h"
+#include "runtime_io.h"
+#include "interpreter.h"
+#include "tree_interpreter.h"
+using namespace std;
+
+// --engine=tree: checks the program and runs its parse tree, skipping
+// intermediate code, optimization and code generation. Only the program's
+// output and errors are printed, unless `dump` asks for the front end's
+// tokens, parse tree and checks as well.
+static int runTree(InputReader& input, bool dump, bool showStats) {
+    Compiler compiler;
+    compiler.compile(readSource(input), STAGE_SEMANTIC);
+    if (dump) {
+        cout << "\n--- Tokens ---\n";
+        printTokens(compiler.getTokens());
+    }
+
+    ParseNode* root = compiler.getParseTree();
+    if (!root) {
+        compiler.getParser().printErrors();
+        return 1;
+    }
+    if (dump) {
+        cout << "\n--- Parse Tree ---\n";
+        compiler.getParser().printParseTree(root);
+    }
+
+    if (dump || compiler.hasErrors()) compiler.getSemantic().printErrors();
+    if (compiler.hasErrors()) {
+        cout << "\nCompilation stopped due to semantic errors.\n";
+        return 1;
+    }
+
+    TreeInterpreter interpreter;
+    interpreter.setInput(input);
+    if (dump) cout << "\n--- Output ---\n";
+    try {
+        interpreter.execute(root);
+    } catch (const RuntimeError& e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+    if (showStats) interpreter.printStatistics();
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    OptimizerOptions options;
+    ExecutionLimits limits;
+    bool showStats = false;
+    string profileOut;
+    bool showProfile = false;
+    string profileReport;
+    string nativeOut;
+    bool useJit = false;
+    bool useTree = false;
+    bool dump = false;
+    DispatchMode dispatch = DISPATCH_THREADED;
+    bool systemTools = false;
+    string nativeCOut;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg.size() == 3 && arg.compare(0, 2, "-O") == 0 && arg[2] >= '0' && arg[2] <= '3') {
+            options.level = arg[2] - '0';
+        } else if (arg == "--stats") {
+            showStats = true;
+        } else if (arg == "--verify-ir") {
+            options.verify = true;
+        } else if (arg.rfind("--unroll-factor=", 0) == 0) {
+            options.unrollFactor = atoi(arg.c_str() + 16);
+        } else if (arg.rfind("--unroll-limit=", 0) == 0) {
+            options.unrollLimit = atoi(arg.c_str() + 15);
+        } else if (arg.rfind("--eval-budget=", 0) == 0) {
+            options.evalBudget = atol(arg.c_str() + 14);
+        } else if (arg.rfind("--profile-out=", 0) == 0) {
+            profileOut = arg.substr(14);
+        } else if (arg == "--profile") {
+            showProfile = true;
+        } else if (arg.rfind("--profile-report=", 0) == 0) {
+            profileReport = arg.substr(17);
+        } else if (arg.rfind("--profile-use=", 0) == 0) {
+            options.profilePath = arg.substr(14);
+        } else if (arg.rfind("--native=", 0) == 0) {
+            nativeOut = arg.substr(9);
+        } else if (arg.rfind("--native-c=", 0) == 0) {
+            nativeCOut = arg.substr(11);
+        } else if (arg == "--system-as") {
+            systemTools = true;
+        } else if (arg == "--engine=interpreter" || arg == "--engine=jit" || arg == "--engine=tree") {
+            useJit = arg == "--engine=jit";
+            useTree = arg == "--engine=tree";
+        } else if (arg == "--dump") {
+            dump = true;
+        } else if (arg == "--dispatch=switch" || arg == "--dispatch=threaded") {
+            dispatch = arg == "--dispatch=switch" ? DISPATCH_SWITCH : DISPATCH_THREADED;
+        } else if (arg.rfind("--threads=", 0) == 0) {
+            options.threads = atoi(arg.c_str() + 10);
+        } else if (arg.rfind("--max-instructions=", 0) == 0) {
+            limits.instructions = atol(arg.c_str() + 19);
+        } else if (arg.rfind("--max-memory=", 0) == 0) {
+            limits.memory = strtoul(arg.c_str() + 13, nullptr, 10);
+        } else if (arg.rfind("--max-output=", 0) == 0) {
+            limits.output = strtoul(arg.c_str() + 13, nullptr, 10);
+        } else {
+            cerr << "Unknown option: " << arg << endl;
+            return 1;
+        }
+    }
+    if (useJit && (!profileOut.empty() || showProfile || !profileReport.empty())) {
+        cerr << "Profiling needs the interpreter engine" << endl;
+        return 1;
+    }
+    if ((useJit || useTree) && (limits.instructions || limits.memory || limits.output)) {
+        cerr << "Execution limits need the interpreter engine" << endl;
+        return 1;
+    }
+    if (useTree && (!profileOut.empty() || showProfile || !profileReport.empty() || !nativeOut.empty() ||
+                    !nativeCOut.empty())) {
+        cerr << "--engine=tree runs the parse tree; it cannot profile or build executables" << endl;
+        return 1;
+    }
+
+    // The rest of standard input, after the source, is the program's input.
+    InputReader input;
+    if (useTree) return runTree(input, dump, showStats);
+    cout << "Enter your source code (end with # on a new line):\n";
+    vector<string> sourceLines;
+    Compiler compiler(options);
+    compiler.compile(readSource(input, &sourceLines));
+
+    // --- Lexical Analysis ---
+    cout << "\n--- Tokens ---\n";
+    printTokens(compiler.getTokens());
+
+    // --- Syntax Analysis ---
+    ParseNode* root = compiler.getParseTree();
+    if (!root) {
+        compiler.getParser().printErrors();
+        return 1;
+    }
+
+    cout << "\n--- Parse Tree ---\n";
+    compiler.getParser().printParseTree(root);
+
+    // --- Semantic Analysis ---
+    compiler.getSemantic().printErrors();
+
+    if (compiler.getSemantic().hasErrors()) {
+        cout << "\nCompilation stopped due to semantic errors.\n";
+        return 1;
+    }
+
+    // --- Intermediate Code Generation ---
+    cout << "\n--- Intermediate Code ---\n";
+    compiler.getICG().printInstructions();
+
+    // --- Optimization ---
+    if (compiler.hasErrors()) {
+        for (const string& error : compiler.getErrors()) cerr << error << endl;
+        return 1;
+    }
+    const vector<Instruction>& optimized = compiler.getOptimized();
+
+    cout << "\n--- Optimized Code ---\n";
+    printCode(optimized);
+
+    if (showStats) {
+        compiler.getOptimizer().printStatistics();
+    }
+
+    // --- Code Generation (Assembly stub) ---
+    cout << compiler.getAssembly();
+
+    // --- Native Executable ---
+    if (!nativeOut.empty()) {
+        X86Generator native;
+        native.setThreads(options.threads);
+        if (native.buildExecutable(optimized, nativeOut, systemTools)) {
+            cout << "\nNative executable written to " << nativeOut << "\n";
+            if (showStats) native.printStatistics();
+        } else {
+            native.printErrors();
+        }
+    }
+
+    if (!nativeCOut.empty()) {
+        CSourceGenerator cgen;
+        if (cgen.buildExecutable(optimized, nativeCOut)) {
+            cout << "\nC backend executable written to " << nativeCOut << "\n";
+        } else {
+            cgen.printErrors();
+        }
+    }
+
+    // --- Execution ---
+    if (useJit) {
+        JitCompiler jit;
+        jit.setThreads(options.threads);
+        if (!jit.compile(optimized)) {
+            jit.printErrors();
+            return 1;
+        }
+        cout << "\n--- Output ---\n";
+        try {
+            jit.run(cout, &input);
+        } catch (const RuntimeError& e) {
+            cerr << e.what() << endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    Interpreter interpreter;
+    interpreter.setDispatch(dispatch);
+    interpreter.setInput(input);
+    interpreter.setThreads(options.threads);
+    interpreter.setLimits(limits);
+    if (!profileOut.empty()) {
+        interpreter.setProfileOutput(profileOut);
+    }
+    interpreter.setProfiling(showProfile || !profileReport.empty());
+    cout << "\n--- Output ---\n";
+    try {
+        interpreter.execute(optimized);
+    } catch (const RuntimeError& e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+    if (showStats) interpreter.printStatistics();
+    if (showProfile) interpreter.getRuntimeProfile().printReport(cout, sourceLines);
+    if (!profileReport.empty() && !interpreter.getRuntimeProfile().save(profileReport)) {
+        cerr << "Could not write profile report to " << profileReport << endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,69 @@
+#include "executor.h"
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+#include <thread>
+
+const char* runStatusName(RunStatus status) {
+    switch (status) {
+        case RUN_OK: return "ok";
+        case RUN_ERROR: return "error";
+        case RUN_INSTRUCTION_LIMIT: return "instruction limit";
+        case RUN_MEMORY_LIMIT: return "memory limit";
+        case RUN_OUTPUT_LIMIT: return "output limit";
+    }
+    return "unknown";
+}
+
+ProgramExecutor::ProgramExecutor(const ExecutionLimits& limits, unsigned threads) : limits(limits) {
+    unsigned workers = threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency());
+    if (workers > 1) pool.reset(new ThreadPool(workers - 1));  // the calling thread works too
+}
+
+unsigned ProgramExecutor::size() const {
+    return pool ? pool->size() + 1 : 1;
+}
+
+std::vector<RunResult> ProgramExecutor::run(const std::vector<ExecutionJob>& jobs) {
+    std::vector<RunResult> results(jobs.size());
+    if (!pool) {
+        for (size_t i = 0; i < jobs.size(); ++i) results[i] = runOne(jobs[i]);
+        return results;
+    }
+    pool->parallelFor(jobs.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) results[i] = runOne(jobs[i]);
+    });
+    return results;
+}
+
+// Nothing a run throws gets past here, and no bytecode traps, so one program
+// cannot stop the others.
+RunResult ProgramExecutor::runOne(const ExecutionJob& job) {
+    RunResult result;
+    result.name = job.name;
+    std::ostringstream out;
+    InputReader input(job.input);
+    ExecutionContext context(job.program);
+    context.setOutput(out);
+    context.setInput(input);
+    context.setLimits(limits);
+    context.setThreadPool(pool.get());
+
+    auto start = std::chrono::steady_clock::now();
+    try {
+        result.exitCode = context.run();
+    } catch (const LimitExceeded& e) {
+        result.status = e.kind == LimitExceeded::INSTRUCTIONS ? RUN_INSTRUCTION_LIMIT
+                        : e.kind == LimitExceeded::MEMORY     ? RUN_MEMORY_LIMIT
+                                                              : RUN_OUTPUT_LIMIT;
+        result.error = e.what();
+    } catch (const std::exception& e) {
+        result.status = RUN_ERROR;
+        result.error = e.what();
+    }
+    auto end = std::chrono::steady_clock::now();
+    result.milliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+    result.steps = context.getSteps();
+    result.output = out.str();
+    return result;
+}
@@ -0,0 +1,49 @@
+#ifndef EXECUTOR_H
+#define EXECUTOR_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "interpreter.h"
+#include "thread_pool.h"
+
+// One program for ProgramExecutor, with the text its `san` calls read.
+struct ExecutionJob {
+    std::string name;
+    std::shared_ptr<const PreparedProgram> program;
+    std::string input;
+};
+
+enum RunStatus { RUN_OK, RUN_ERROR, RUN_INSTRUCTION_LIMIT, RUN_MEMORY_LIMIT, RUN_OUTPUT_LIMIT };
+
+const char* runStatusName(RunStatus status);
+
+struct RunResult {
+    std::string name;
+    RunStatus status = RUN_OK;
+    int exitCode = 0;        // the returned value, when the run finished
+    std::string output;      // up to the output limit
+    std::string error;       // why the run stopped, unless RUN_OK
+    long steps = 0;          // bytecode instructions executed
+    double milliseconds = 0;
+};
+
+// Runs many programs at once on a thread pool, each in its own
+// ExecutionContext under the same ExecutionLimits. A program that fails or
+// goes over a limit only ends its own run: its result says why, and the
+// others go on. Parallel loops share the pool with the programs.
+class ProgramExecutor {
+public:
+    explicit ProgramExecutor(const ExecutionLimits& limits, unsigned threads = 0);  // 0: one per hardware thread
+
+    std::vector<RunResult> run(const std::vector<ExecutionJob>& jobs);  // in the order of the jobs
+    unsigned size() const;  // threads running programs, the caller's included
+
+private:
+    ExecutionLimits limits;
+    std::unique_ptr<ThreadPool> pool;  // none with a single thread
+
+    RunResult runOne(const ExecutionJob& job);
+};
+
+#endif
@@ -1,249 +1,575 @@
-#include "icg.h"
-#include <iostream>
-using namespace std;
-
-IntermediateCodeGenerator::IntermediateCodeGenerator() {
-    tempCount = 0;
-    labelCount = 0;
-}
-
-vector<Instruction> IntermediateCodeGenerator::getICG() {
-    return instructions;
-}
-
-string IntermediateCodeGenerator::newTemp() {
-    return "t" + to_string(tempCount++);
-}
-
-string IntermediateCodeGenerator::newLabel() {
-    return "L" + to_string(labelCount++);
-}
-
-string IntermediateCodeGenerator::evaluateExpression(ParseNode* node) {
-    if (!node) return "";
-
-    // Leaf nodes: identifiers, numbers, strings
-    if (node->type == IDENTIFIER_NODE || node->type == NUMBER_NODE || node->type == STRING_NODE) {
-        return node->value;
-    }
-
-    // Function call nodes
-    if (node->type == FUNCTION_CALL_NODE) {
-    string arg = "";
-    if (!node->children.empty()) {
-        arg = evaluateExpression(node->children[0]);
-        instructions.push_back({"param", arg, "", ""});
-    }
-
-    // ADD THIS BLOCK:
-    if (node->value == "prrint" || node->value == "san") {
-        instructions.push_back({"print", arg, "", ""});
-        return "";
-    }
-
-    instructions.push_back({"call", "", "", node->value});
-    return "";
-}
-
-
-    // Binary expressions
-    if (node->type == EXPRESSION_NODE) {
-        if (node->children.size() >= 3) {
-            string acc = evaluateExpression(node->children[0]);
-            for (size_t i = 2; i < node->children.size(); i += 2) {
-                string op = node->children[i - 1]->value;
-                string next = evaluateExpression(node->children[i]);
-                string temp = newTemp();
-                instructions.push_back({op, acc, next, temp});
-                acc = temp;
-            }
-            return acc;
-        } else if (node->children.size() == 2) {
-            string left = evaluateExpression(node->children[0]);
-            string right = evaluateExpression(node->children[1]);
-            string op = node->value.empty() ? "+" : node->value;
-            string temp = newTemp();
-            instructions.push_back({op, left, right, temp});
-            return temp;
-        } else if (!node->children.empty()) {
-            return evaluateExpression(node->children[0]);
-        }
-    }
-
-    return "";
-}
-
-void IntermediateCodeGenerator::traverse(ParseNode* node) {
-    if (!node) return;
-
-    switch (node->type) {
-        case PROGRAM_NODE:
-            for (auto child : node->children) {
-                traverse(child);
-            }
-            break;
-
-        case STATEMENT_NODE:  
-            for (auto child : node->children) {
-                traverse(child);
-            }
-            break;
-
-        case DECLARATION_NODE: {
-            string id = "";
-            string exprResult = "";
-            for (auto child : node->children) {
-                if (child->type == IDENTIFIER_NODE) {
-                    id = child->value;
-                } else {
-                    exprResult = evaluateExpression(child);
-                }
-            }
-
-            if (id.empty()) {
-                size_t spacePos = node->value.find(' ');
-                if (spacePos != string::npos) {
-                    id = node->value.substr(spacePos + 1);
-                }
-            }
-
-            if (!id.empty() && !exprResult.empty()) {
-                instructions.push_back({"=", exprResult, "", id});
-            }
-            break;
-        }
-
-        case ASSIGNMENT_NODE: {
-    string id = node->value;
-    string expr = evaluateExpression(node->children[0]);
-    if (!expr.empty())
-        instructions.push_back({"=", expr, "", id});
-    break;
-}
-
-
-        case IF_STATEMENT_NODE: {
-            string elseLabel = newLabel();
-            string endLabel = newLabel();
-            string cond = evaluateExpression(node->children[0]);
-
-            instructions.push_back({"ifFalse", cond, "", elseLabel});
-            traverse(node->children[1]); 
-
-            instructions.push_back({"goto", "", "", endLabel});
-            instructions.push_back({"label", "", "", elseLabel});
-
-            if (node->children.size() == 3) {
-                traverse(node->children[2]); 
-            }
-
-            instructions.push_back({"label", "", "", endLabel});
-            break;
-        }
-
-        case LOOP_STATEMENT_NODE: {
-            string startLabel = newLabel();
-            string endLabel = newLabel();
-            labelStack.push_back({startLabel, endLabel});
-
-            instructions.push_back({"label", "", "", startLabel});
-            string cond = evaluateExpression(node->children[0]);
-            instructions.push_back({"ifFalse", cond, "", endLabel});
-
-            traverse(node->children[1]);
-
-            instructions.push_back({"goto", "", "", startLabel});
-            instructions.push_back({"label", "", "", endLabel});
-
-            labelStack.pop_back();
-            break;
-        }
-
-        case BREAK_STATEMENT_NODE:
-            if (!labelStack.empty()) {
-                instructions.push_back({"goto", "", "", labelStack.back().second});
-            }
-            break;
-
-        case CONTINUE_STATEMENT_NODE:
-            if (!labelStack.empty()) {
-                instructions.push_back({"goto", "", "", labelStack.back().first});
-            }
-            break;
-
-        case RETURN_STATEMENT_NODE: {
-            string retVal = "";
-            if (!node->children.empty()) {
-                retVal = evaluateExpression(node->children[0]);
-            }
-            instructions.push_back({"return", retVal, "", ""});
-            break;
-        }
-
-        case FUNCTION_CALL_NODE: {
-    string arg = "";
-    if (!node->children.empty()) {
-        arg = evaluateExpression(node->children[0]);
-    }
-
-    // Generate actual instruction for prrint/san
-    if (node->value == "prrint" || node->value == "san") {
-        instructions.push_back({"print", arg, "", ""});
-    } else {
-        // generic function call
-        instructions.push_back({"param", arg, "", ""});
-        instructions.push_back({"call", "", "", node->value});
-    }
-    break;
-}
-
-
-        case PRINT_STATEMENT_NODE: {
-            string toPrint;
-            if (!node->children.empty()) {
-                toPrint = evaluateExpression(node->children[0]);
-            }
-            instructions.push_back({"print", toPrint, "", ""});
-            break;
-        }
-
-        case SAN_STATEMENT_NODE:
-            instructions.push_back({"print", "\"SAN\"", "", ""});
-            break;
-
-        default:
-            for (auto child : node->children) {
-                traverse(child);
-            }
-            break;
-    }
-}
-
-void IntermediateCodeGenerator::generate(ParseNode* root) {
-    traverse(root);
-}
-
-void IntermediateCodeGenerator::printInstructions() {
-    for (const auto& instr : instructions) {
-        if (instr.op == "label") {
-            cout << instr.result << ":" << endl;
-        } else if (instr.op == "goto") {
-            cout << "goto " << instr.result << endl;
-        } else if (instr.op == "ifFalse") {
-            cout << "ifFalse " << instr.arg1 << " goto " << instr.result << endl;
-        } else if (instr.op == "call") {
-            cout << "call " << instr.result << endl;
-        } else if (instr.op == "return") {
-            cout << "return " << instr.arg1 << endl;
-        } else if (instr.op == "=") {
-            cout << instr.result << " = " << instr.arg1 << endl;
-        } else if (instr.op == "param") {
-            cout << "param " << instr.arg1 << endl;
-        } else if (instr.op == "print") {
-            cout << "print " << instr.arg1 << endl;
-        } else {
-            cout << instr.result << " = " << instr.arg1 << " " << instr.op << " " << instr.arg2 << endl;
-        }
-    }
-}
-
+#include "icg.h"
+#include <iostream>
+#include <algorithm>
+using namespace std;
+
+// Chains shorter than this keep the plain ifFalse lowering.
+static const size_t MIN_SWITCH_CASES = 3;
+
+bool isStringLiteral(const string& token) {
+    return !token.empty() && token[0] == '"';
+}
+
+string literalText(const string& token) {
+    size_t end = token.size() >= 2 && token.back() == '"' ? token.size() - 1 : token.size();
+    return token.substr(1, end - 1);
+}
+
+bool isIntLiteral(const string& token) {
+    size_t digits = !token.empty() && token[0] == '-' ? 1 : 0;
+    if (digits == token.size()) return false;
+    for (size_t i = digits; i < token.size(); ++i) {
+        if (!isdigit(token[i])) return false;
+    }
+    return true;
+}
+
+bool writesResult(const Instruction& instr) {
+    const string& op = instr.op;
+    return !instr.result.empty() && op != "label" && op != "goto" && op != "ifFalse" &&
+           op != "jumptable" && op != "case" && op != "call" && op != "param" &&
+           op != "print" && op != "return" && op != "array" && op != "store" && op != "bounds";
+}
+
+unordered_set<string> findStringNames(const vector<Instruction>& code) {
+    unordered_set<string> names;
+    auto isString = [&](const string& token) { return isStringLiteral(token) || names.count(token); };
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (const auto& instr : code) {
+            bool copy = instr.op == "=" || instr.op == "MOV" || instr.op.empty();
+            if ((!copy && instr.op != "+") || instr.result.empty() || names.count(instr.result)) continue;
+            if (isString(instr.arg1) || (instr.op == "+" && isString(instr.arg2))) {
+                names.insert(instr.result);
+                changed = true;
+            }
+        }
+    }
+    return names;
+}
+
+bool findParallelLoop(const vector<Instruction>& code, int marker, ParallelLoop& loop) {
+    auto isJump = [](const Instruction& instr) {
+        return instr.op == "goto" || instr.op == "ifFalse" || instr.op == "jumptable" || instr.op == "case";
+    };
+    int n = code.size();
+    loop = ParallelLoop();
+    loop.marker = marker;
+    loop.var = code[marker].arg1;
+    for (int i = marker - 1; i >= 0 && code[i].op == "reduce"; --i) {
+        loop.reductions.insert(loop.reductions.begin(), {code[i].arg1, code[i].arg2 == "1" ? 1 : 0});
+    }
+
+    int h = marker + 1;
+    while (h < n && code[h].op != "label") {
+        if (isJump(code[h]) || code[h].op == "return" || code[h].op == "parallel") return false;
+        ++h;
+    }
+    if (h + 2 >= n) return false;
+    const Instruction& test = code[h + 1];
+    const Instruction& branch = code[h + 2];
+    if (test.op != "<" || test.arg1 != loop.var || test.result.empty() ||
+        branch.op != "ifFalse" || branch.arg1 != test.result) {
+        return false;
+    }
+    loop.bound = test.arg2;
+    loop.header = h;
+    loop.body = h + 3;
+
+    unordered_map<string, int> labels;
+    for (int i = 0; i < n; ++i) {
+        if (code[i].op == "label") labels[code[i].result] = i;
+        if (code[i].op == "goto" && code[i].result == code[h].result) loop.backEdge = i;
+    }
+    int b = loop.backEdge;
+    if (b < loop.body + 1 || !labels.count(branch.result)) return false;
+    loop.increment = b - 1;
+    loop.exit = labels[branch.result];
+    const Instruction& step = code[loop.increment];
+    if (step.op != "+" || step.arg1 != loop.var || step.arg2 != "1" || step.result != loop.var ||
+        (loop.exit >= h && loop.exit <= b)) {
+        return false;
+    }
+
+    auto inBody = [&](int i) { return i >= loop.body && i < loop.increment; };
+    for (int i = 0; i < n; ++i) {
+        const Instruction& instr = code[i];
+        if (isJump(instr) && i != h + 2 && i != b) {
+            if (instr.result == code[h].result) return false;
+            auto target = labels.find(instr.result);
+            if (target != labels.end() && inBody(i) != inBody(target->second)) return false;
+        }
+        if (!inBody(i)) continue;
+        const string& op = instr.op;
+        if (op == "return" || op == "print" || op == "read" || op == "call" || op == "param" ||
+            op == "parallel" || op == "reduce") {
+            return false;
+        }
+        bool writes = !isJump(instr) && op != "label" && op != "store" && op != "bounds";
+        if (writes && (instr.result == loop.var || instr.result == loop.bound)) return false;
+    }
+    return true;
+}
+
+IntermediateCodeGenerator::IntermediateCodeGenerator() {
+    tempCount = 0;
+    labelCount = 0;
+}
+
+vector<Instruction> IntermediateCodeGenerator::getICG() {
+    return instructions;
+}
+
+string IntermediateCodeGenerator::newTemp() {
+    return "t" + to_string(tempCount++);
+}
+
+string IntermediateCodeGenerator::newLabel() {
+    return "L" + to_string(labelCount++);
+}
+
+string IntermediateCodeGenerator::checkedIndex(const string& array, ParseNode* index) {
+    string value = evaluateExpression(index);
+    instructions.push_back({"bounds", value, arraySizes[array], array});
+    return value;
+}
+
+string IntermediateCodeGenerator::evaluateExpression(ParseNode* node) {
+    if (!node) return "";
+
+    if (node->type == INDEX_NODE) {
+        string index = checkedIndex(node->value, node->children[0]);
+        string temp = newTemp();
+        instructions.push_back({"load", node->value, index, temp});
+        return temp;
+    }
+
+    // Leaf nodes: identifiers, numbers, strings
+    if (node->type == IDENTIFIER_NODE || node->type == NUMBER_NODE || node->type == STRING_NODE) {
+        return node->value;
+    }
+
+    // Function call nodes
+    if (node->type == FUNCTION_CALL_NODE) {
+    string arg = "";
+    if (!node->children.empty()) {
+        arg = evaluateExpression(node->children[0]);
+        if (node->value != "san") instructions.push_back({"param", arg, "", ""});
+    }
+
+    // san reads an integer into its argument
+    if (node->value == "san") {
+        instructions.push_back({"read", "", "", arg});
+        return "";
+    }
+
+    // ADD THIS BLOCK:
+    if (node->value == "prrint") {
+        instructions.push_back({"print", arg, "", ""});
+        return "";
+    }
+
+    instructions.push_back({"call", "", "", node->value});
+    return "";
+}
+
+
+    // Binary expressions
+    if (node->type == EXPRESSION_NODE) {
+        if (node->children.size() >= 3) {
+            string acc = evaluateExpression(node->children[0]);
+            for (size_t i = 2; i < node->children.size(); i += 2) {
+                string op = node->children[i - 1]->value;
+                string next = evaluateExpression(node->children[i]);
+                string temp = newTemp();
+                instructions.push_back({op, acc, next, temp});
+                acc = temp;
+            }
+            return acc;
+        } else if (node->children.size() == 2) {
+            string left = evaluateExpression(node->children[0]);
+            string right = evaluateExpression(node->children[1]);
+            string op = node->value.empty() ? "+" : node->value;
+            string temp = newTemp();
+            instructions.push_back({op, left, right, temp});
+            return temp;
+        } else if (!node->children.empty()) {
+            return evaluateExpression(node->children[0]);
+        }
+    }
+
+    return "";
+}
+
+// "1" if the body multiplies into the reduction variable, "0" if it adds to
+// it or never updates it.
+string IntermediateCodeGenerator::reductionIdentity(ParseNode* node, const string& name) {
+    if (node->type == ASSIGNMENT_NODE && node->value == name && node->children.size() == 1 &&
+        node->children[0]->type == EXPRESSION_NODE && node->children[0]->value == "*") {
+        return "1";
+    }
+    for (auto* child : node->children) {
+        if (reductionIdentity(child, name) == "1") return "1";
+    }
+    return "0";
+}
+
+// ---- Switch Lowering ----
+//
+// An if/else-if chain whose conditions all compare one variable with distinct
+// integer constants is dispatched in one step: dense key sets become a
+// `jumptable var, min, default` followed by one `case label` entry per key in
+// [min, max], sparse ones a binary search on the key.
+bool IntermediateCodeGenerator::lowerSwitchChain(ParseNode* node) {
+    string var;
+    vector<pair<long long, ParseNode*>> arms;
+    ParseNode* defaultBody = nullptr;
+
+    for (ParseNode* n = node; n; ) {
+        ParseNode* cond = n->children[0];
+        if (cond->type != EXPRESSION_NODE || cond->value != "==" || cond->children.size() != 2) break;
+        ParseNode* id = cond->children[0];
+        ParseNode* key = cond->children[1];
+        if (id->type == NUMBER_NODE) swap(id, key);
+        if (id->type != IDENTIFIER_NODE || key->type != NUMBER_NODE || key->value.size() > 9) break;
+        if (!var.empty() && id->value != var) break;
+        long long k = stoll(key->value);
+        bool duplicate = false;
+        for (const auto& arm : arms) duplicate |= arm.first == k;
+        if (duplicate) break;
+
+        var = id->value;
+        arms.push_back({k, n->children[1]});
+        defaultBody = n->children.size() == 3 ? n->children[2] : nullptr;
+
+        // Continue down `ellse { iif ... }`; anything else ends the chain.
+        n = nullptr;
+        if (defaultBody && defaultBody->children.size() == 1 &&
+            defaultBody->children[0]->type == IF_STATEMENT_NODE) {
+            n = defaultBody->children[0];
+        }
+    }
+    if (arms.size() < MIN_SWITCH_CASES) return false;
+
+    string defaultLabel = newLabel();
+    string endLabel = newLabel();
+    vector<string> armLabels;
+    vector<pair<long long, string>> cases;
+    for (const auto& arm : arms) {
+        armLabels.push_back(newLabel());
+        cases.push_back({arm.first, armLabels.back()});
+    }
+    sort(cases.begin(), cases.end());
+
+    long long lo = cases.front().first, hi = cases.back().first;
+    if (hi - lo + 1 <= 2 * (long long)cases.size()) {
+        instructions.push_back({"jumptable", var, to_string(lo), defaultLabel});
+        size_t next = 0;
+        for (long long k = lo; k <= hi; ++k) {
+            bool hit = cases[next].first == k;
+            instructions.push_back({"case", "", "", hit ? cases[next].second : defaultLabel});
+            if (hit) next++;
+        }
+    } else {
+        emitSearchTree(var, cases, 0, cases.size(), defaultLabel);
+    }
+
+    for (size_t i = 0; i < arms.size(); ++i) {
+        instructions.push_back({"label", "", "", armLabels[i]});
+        traverse(arms[i].second);
+        instructions.push_back({"goto", "", "", endLabel});
+    }
+    instructions.push_back({"label", "", "", defaultLabel});
+    if (defaultBody) traverse(defaultBody);
+    instructions.push_back({"label", "", "", endLabel});
+    return true;
+}
+
+// Binary search over sorted keys; short ranges test each key in turn.
+void IntermediateCodeGenerator::emitSearchTree(const string& var, const vector<pair<long long, string>>& cases,
+                                               size_t lo, size_t hi, const string& defaultLabel) {
+    if (hi - lo <= 3) {
+        for (size_t i = lo; i < hi; ++i) {
+            string temp = newTemp();
+            instructions.push_back({"!=", var, to_string(cases[i].first), temp});
+            instructions.push_back({"ifFalse", temp, "", cases[i].second});
+        }
+        instructions.push_back({"goto", "", "", defaultLabel});
+        return;
+    }
+    size_t mid = (lo + hi) / 2;
+    string temp = newTemp();
+    string upper = newLabel();
+    instructions.push_back({"<", var, to_string(cases[mid].first), temp});
+    instructions.push_back({"ifFalse", temp, "", upper});
+    emitSearchTree(var, cases, lo, mid, defaultLabel);
+    instructions.push_back({"label", "", "", upper});
+    emitSearchTree(var, cases, mid, hi, defaultLabel);
+}
+
+void IntermediateCodeGenerator::traverse(ParseNode* node) {
+    if (!node) return;
+    size_t first = instructions.size();
+
+    switch (node->type) {
+        case PROGRAM_NODE:
+            for (auto child : node->children) {
+                traverse(child);
+            }
+            break;
+
+        case STATEMENT_NODE:  
+            for (auto child : node->children) {
+                traverse(child);
+            }
+            break;
+
+        case DECLARATION_NODE: {
+            // The value is "type name"; the only child, if any, is the initializer.
+            string id = "";
+            string exprResult = "";
+            size_t spacePos = node->value.find(' ');
+            if (spacePos != string::npos) {
+                id = node->value.substr(spacePos + 1);
+            }
+            if (!node->children.empty()) {
+                exprResult = evaluateExpression(node->children[0]);
+            }
+
+            // sttring variables start out empty
+            if (exprResult.empty() && node->value.compare(0, 8, "sttring ") == 0) {
+                exprResult = "\"\"";
+            }
+            // an iteration of a parallel loop must not see the previous one's value
+            if (exprResult.empty() && inParallelLoop) {
+                exprResult = "0";
+            }
+
+            if (!id.empty() && !exprResult.empty()) {
+                instructions.push_back({"=", exprResult, "", id});
+            }
+            break;
+        }
+
+        case ARRAY_DECLARATION_NODE: {
+            string id = node->value.substr(node->value.find(' ') + 1);
+            string size = to_string(stoll(node->children[0]->value));
+            arraySizes[id] = size;
+            arrays.push_back({"array", size, "", id, node->line});
+            break;
+        }
+
+        case ASSIGNMENT_NODE: {
+    string id = node->value;
+    if (node->children.size() == 2) {
+        string index = checkedIndex(id, node->children[1]);
+        string value = evaluateExpression(node->children[0]);
+        instructions.push_back({"store", index, value, id});
+        break;
+    }
+    string expr = evaluateExpression(node->children[0]);
+    if (!expr.empty())
+        instructions.push_back({"=", expr, "", id});
+    break;
+}
+
+
+        case IF_STATEMENT_NODE: {
+            if (lowerSwitchChain(node)) break;
+            string elseLabel = newLabel();
+            string endLabel = newLabel();
+            string cond = evaluateExpression(node->children[0]);
+
+            instructions.push_back({"ifFalse", cond, "", elseLabel});
+            traverse(node->children[1]); 
+
+            instructions.push_back({"goto", "", "", endLabel});
+            instructions.push_back({"label", "", "", elseLabel});
+
+            if (node->children.size() == 3) {
+                traverse(node->children[2]); 
+            }
+
+            instructions.push_back({"label", "", "", endLabel});
+            break;
+        }
+
+        case LOOP_STATEMENT_NODE: {
+            string startLabel = newLabel();
+            string endLabel = newLabel();
+            labelStack.push_back({startLabel, endLabel});
+
+            instructions.push_back({"label", "", "", startLabel});
+            string cond = evaluateExpression(node->children[0]);
+            instructions.push_back({"ifFalse", cond, "", endLabel});
+
+            traverse(node->children[1]);
+
+            instructions.push_back({"goto", "", "", startLabel});
+            instructions.push_back({"label", "", "", endLabel});
+
+            labelStack.pop_back();
+            break;
+        }
+
+        case PARALLEL_LOOP_NODE: {
+            // ploop (i = start; i < bound) redduce (...) { body }, with the
+            // bound evaluated once; `conttinue` goes to the increment.
+            string var = node->children[0]->value;
+            traverse(node->children[0]);
+            string bound = evaluateExpression(node->children[1]->children[1]);
+            for (auto* reduction : node->children[3]->children) {
+                instructions.push_back({"reduce", reduction->value, reductionIdentity(node->children[2], reduction->value), ""});
+            }
+            instructions.push_back({"parallel", var, bound, ""});
+
+            string startLabel = newLabel();
+            string continueLabel = newLabel();
+            string endLabel = newLabel();
+            labelStack.push_back({continueLabel, endLabel});
+
+            instructions.push_back({"label", "", "", startLabel});
+            string cond = newTemp();
+            instructions.push_back({"<", var, bound, cond});
+            instructions.push_back({"ifFalse", cond, "", endLabel});
+
+            inParallelLoop = true;
+            traverse(node->children[2]);
+            inParallelLoop = false;
+
+            instructions.push_back({"label", "", "", continueLabel});
+            instructions.push_back({"+", var, "1", var});
+            instructions.push_back({"goto", "", "", startLabel});
+            instructions.push_back({"label", "", "", endLabel});
+
+            labelStack.pop_back();
+            break;
+        }
+
+        case BREAK_STATEMENT_NODE:
+            if (!labelStack.empty()) {
+                instructions.push_back({"goto", "", "", labelStack.back().second});
+            }
+            break;
+
+        case CONTINUE_STATEMENT_NODE:
+            if (!labelStack.empty()) {
+                instructions.push_back({"goto", "", "", labelStack.back().first});
+            }
+            break;
+
+        case RETURN_STATEMENT_NODE: {
+            string retVal = "";
+            if (!node->children.empty()) {
+                retVal = evaluateExpression(node->children[0]);
+            }
+            instructions.push_back({"return", retVal, "", ""});
+            break;
+        }
+
+        case FUNCTION_CALL_NODE: {
+    string arg = "";
+    if (node->value == "san" && !node->children.empty() && node->children[0]->type == INDEX_NODE) {
+        ParseNode* element = node->children[0];
+        string index = checkedIndex(element->value, element->children[0]);
+        string temp = newTemp();
+        instructions.push_back({"read", "", "", temp});
+        instructions.push_back({"store", index, temp, element->value});
+        break;
+    }
+    if (!node->children.empty()) {
+        arg = evaluateExpression(node->children[0]);
+    }
+
+    // Generate actual instruction for prrint/san
+    if (node->value == "san") {
+        instructions.push_back({"read", "", "", arg});
+    } else if (node->value == "prrint") {
+        instructions.push_back({"print", arg, "", ""});
+    } else {
+        // generic function call
+        instructions.push_back({"param", arg, "", ""});
+        instructions.push_back({"call", "", "", node->value});
+    }
+    break;
+}
+
+
+        case PRINT_STATEMENT_NODE: {
+            string toPrint;
+            if (!node->children.empty()) {
+                toPrint = evaluateExpression(node->children[0]);
+            }
+            instructions.push_back({"print", toPrint, "", ""});
+            break;
+        }
+
+        case SAN_STATEMENT_NODE:
+            if (!node->children.empty()) {
+                instructions.push_back({"read", "", "", evaluateExpression(node->children[0])});
+            }
+            break;
+
+        default:
+            for (auto child : node->children) {
+                traverse(child);
+            }
+            break;
+    }
+
+    // Instructions keep the line of the innermost statement they came from.
+    if (node->line) {
+        for (size_t i = first; i < instructions.size(); ++i) {
+            if (!instructions[i].line) instructions[i].line = node->line;
+        }
+    }
+}
+
+void IntermediateCodeGenerator::generate(ParseNode* root) {
+    traverse(root);
+    instructions.insert(instructions.begin(), arrays.begin(), arrays.end());
+    arrays.clear();
+}
+
+void IntermediateCodeGenerator::printInstructions() {
+    for (const auto& instr : instructions) {
+        if (instr.op == "label") {
+            cout << instr.result << ":" << endl;
+        } else if (instr.op == "goto") {
+            cout << "goto " << instr.result << endl;
+        } else if (instr.op == "ifFalse") {
+            cout << "ifFalse " << instr.arg1 << " goto " << instr.result << endl;
+        } else if (instr.op == "call") {
+            cout << "call " << instr.result << endl;
+        } else if (instr.op == "return") {
+            cout << "return " << instr.arg1 << endl;
+        } else if (instr.op == "=") {
+            cout << instr.result << " = " << instr.arg1 << endl;
+        } else if (instr.op == "param") {
+            cout << "param " << instr.arg1 << endl;
+        } else if (instr.op == "print") {
+            cout << "print " << instr.arg1 << endl;
+        } else if (instr.op == "read") {
+            cout << "read " << instr.result << endl;
+        } else if (instr.op == "array") {
+            cout << "array " << instr.result << "[" << instr.arg1 << "]" << endl;
+        } else if (instr.op == "bounds") {
+            cout << "bounds " << instr.arg1 << " < " << instr.arg2 << " for " << instr.result << endl;
+        } else if (instr.op == "load") {
+            cout << instr.result << " = " << instr.arg1 << "[" << instr.arg2 << "]" << endl;
+        } else if (instr.op == "store") {
+            cout << instr.result << "[" << instr.arg1 << "] = " << instr.arg2 << endl;
+        } else if (instr.op == "jumptable") {
+            cout << "jumptable " << instr.arg1 << " - " << instr.arg2 << " else goto " << instr.result << endl;
+        } else if (instr.op == "case") {
+            cout << "  case goto " << instr.result << endl;
+        } else if (instr.op == "parallel") {
+            cout << "parallel " << instr.arg1 << " < " << instr.arg2 << endl;
+        } else if (instr.op == "reduce") {
+            cout << "reduce " << instr.arg1 << " from " << instr.arg2 << endl;
+        } else {
+            cout << instr.result << " = " << instr.arg1 << " " << instr.op << " " << instr.arg2 << endl;
+        }
+    }
+}
+
@@ -1,41 +1,96 @@
-#ifndef ICG_H
-#define ICG_H
-
-#include <string>
-#include <vector>
-#include "parser.h"   
-#include "lexer.h" 
-
-using namespace std;
-
-struct Instruction {
-    string op;
-    string arg1;
-    string arg2;
-    string result;
-};
-
-class IntermediateCodeGenerator {
-private:
-    int tempCount;  
-    int labelCount; 
-
-    
-    vector<pair<string, string>> labelStack;
-
-    string newTemp();
-    string newLabel();
-    string evaluateExpression(ParseNode* node);  
-
-    void traverse(ParseNode* node);  
-
-public:
-    vector<Instruction> instructions;
-    IntermediateCodeGenerator();
-    void generate(ParseNode* root);  
-    void printInstructions();   
-    vector<Instruction> getICG();   
-
-};
-
-#endif
+#ifndef ICG_H
+#define ICG_H
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "parser.h"   
+#include "lexer.h" 
+
+using namespace std;
+
+struct Instruction {
+    string op;
+    string arg1;
+    string arg2;
+    string result;
+    int line = 0;  // source line of the statement it came from, 0 if unknown
+};
+
+// Arrays: `array a, N` declares a's N elements, which start at 0; all
+// declarations come first in the code. `t = load a, i` and `store i, v => a`
+// read and write a[i] without checking i, which the preceding
+// `bounds i, N => a` does: it stops the program unless 0 <= i < N.
+
+// Parallel loops: `reduce s, e` for each reduction variable, e being its
+// identity (0 for sums, 1 for products), then `parallel i, n`, then an
+// ordinary loop over i from its current value while i < n, stepping by one.
+// The markers do nothing when executed, so the loop may always run
+// sequentially; see findParallelLoop.
+
+// String literals keep their quotes in the IR.
+bool isStringLiteral(const string& token);
+string literalText(const string& token);  // the characters between the quotes
+bool isIntLiteral(const string& token);    // digits with an optional leading '-'
+
+// Whether the instruction assigns its result. Jumps, labels, calls, params,
+// prints and returns use that field for something else, as do `array`,
+// `store` and `bounds`, which name an array there.
+bool writesResult(const Instruction& instr);
+
+// Names that hold sttring values: the results of copies and `+` with a string
+// literal or another such name as an operand. Semantic analysis keeps intt
+// and sttring apart, so this recovers the type of every IR value.
+unordered_set<string> findStringNames(const vector<Instruction>& code);
+
+// A loop announced by a `parallel` marker, as indices into the code:
+//
+//     reduce ...; parallel i, n; preheader
+//     header: t = i < n; ifFalse t goto exit
+//     body ...; i = i + 1 (increment); goto header (backEdge)
+struct ParallelLoop {
+    string var, bound;                     // the bound as the header tests it
+    vector<pair<string, int>> reductions;  // variable, identity
+    int marker = -1, header = -1, body = -1, increment = -1, backEdge = -1, exit = -1;
+};
+
+// Matches the loop after the marker at code[marker]. It holds only if
+// control enters the loop through its header alone, the body jumps nowhere
+// outside itself, and it neither writes i or n nor prints, reads or
+// returns; the iterations may then run in any order. Otherwise optimization
+// has reshaped the loop and it must run sequentially.
+bool findParallelLoop(const vector<Instruction>& code, int marker, ParallelLoop& loop);
+
+class IntermediateCodeGenerator {
+private:
+    int tempCount;  
+    int labelCount; 
+    bool inParallelLoop = false;
+
+    
+    vector<pair<string, string>> labelStack;
+    unordered_map<string, string> arraySizes;
+    vector<Instruction> arrays;  // declarations, placed before the code
+
+    string newTemp();
+    string newLabel();
+    string evaluateExpression(ParseNode* node);  
+    string checkedIndex(const string& array, ParseNode* index);
+    string reductionIdentity(ParseNode* node, const string& name);
+    bool lowerSwitchChain(ParseNode* node);
+    void emitSearchTree(const string& var, const vector<pair<long long, string>>& cases,
+                        size_t lo, size_t hi, const string& defaultLabel);
+
+    void traverse(ParseNode* node);  
+
+public:
+    vector<Instruction> instructions;
+    IntermediateCodeGenerator();
+    void generate(ParseNode* root);  
+    void printInstructions();   
+    vector<Instruction> getICG();   
+
+};
+
+#endif
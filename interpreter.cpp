@@ -1,99 +1,574 @@
-#include "interpreter.h"
-#include <iostream>
-#include <cstdlib>
-
-bool Interpreter::isNumber(const std::string& s) {
-    if (s.empty()) return false;
-    for (char c : s)
-        if (!isdigit(c) && c != '-') return false;
-    return true;
-}
-
-int Interpreter::getValue(const std::string& token) {
-    if (isNumber(token)) return std::stoi(token);
-    if (variables.count(token)) return variables[token];
-    return 0; 
-}
-
-void Interpreter::execute(const std::vector<Instruction>& code) {
-    std::vector<std::string> paramStack;
-
-    for (int i = 0; i < code.size(); ++i) {
-        if (code[i].op == "label") {
-            labels[code[i].result] = i;
-        }
-    }
-
-    for (int pc = 0; pc < code.size(); ++pc) {
-        const auto& inst = code[pc];
-
-        if (inst.op == "MOV" || inst.op == "=") {
-            variables[inst.result] = getValue(inst.arg1);
-        }
-        else if (inst.op == "+") {
-            variables[inst.result] = getValue(inst.arg1) + getValue(inst.arg2);
-        }
-        else if (inst.op == "-") {
-            variables[inst.result] = getValue(inst.arg1) - getValue(inst.arg2);
-        }
-        else if (inst.op == "*") {
-            variables[inst.result] = getValue(inst.arg1) * getValue(inst.arg2);
-        }
-        else if (inst.op == "/") {
-            int denominator = getValue(inst.arg2);
-            variables[inst.result] = (denominator != 0) ? getValue(inst.arg1) / denominator : 0;
-        }
-        else if (inst.op == "%") {
-            int denominator = getValue(inst.arg2);
-            variables[inst.result] = (denominator != 0) ? getValue(inst.arg1) % denominator : 0;
-        }
-        else if (inst.op == ">") {
-            variables[inst.result] = getValue(inst.arg1) > getValue(inst.arg2);
-        }
-        else if (inst.op == "<") {
-            variables[inst.result] = getValue(inst.arg1) < getValue(inst.arg2);
-        }
-        else if (inst.op == ">=") {
-            variables[inst.result] = getValue(inst.arg1) >= getValue(inst.arg2);
-        }
-        else if (inst.op == "<=") {
-            variables[inst.result] = getValue(inst.arg1) <= getValue(inst.arg2);
-        }
-        else if (inst.op == "==") {
-            variables[inst.result] = getValue(inst.arg1) == getValue(inst.arg2);
-        }
-        else if (inst.op == "!=") {
-            variables[inst.result] = getValue(inst.arg1) != getValue(inst.arg2);
-        }
-        else if (inst.op == "ifFalse") {
-            if (!getValue(inst.arg1)) {
-                if (labels.count(inst.result))
-                    pc = labels[inst.result] - 1;
-            }
-        }
-        else if (inst.op == "goto") {
-            if (labels.count(inst.result))
-                pc = labels[inst.result] - 1;
-        }
-        else if (inst.op == "param") {
-            if (!inst.arg1.empty())
-                paramStack.push_back(inst.arg1);
-            else
-                paramStack.push_back(inst.result);
-        }
-        else if (inst.op == "call") {
-            if (inst.result == "prrint" && !paramStack.empty()) {
-                std::cout << getValue(paramStack.back()) << std::endl;
-                paramStack.clear();
-            }
-        }
-        else if (inst.op == "print") {
-    if (variables.find(inst.arg1) != variables.end())
-        cout << variables[inst.arg1] << endl;
-    else
-        cout << inst.arg1 << endl;  
-}
-
-
-    }
-}
+#include "interpreter.h"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <climits>
+#include <cstdlib>
+#include <exception>
+
+// The loop is written once for both dispatch modes. With THREADED every
+// handler jumps straight to the next one through a table of label
+// addresses (a GNU extension); otherwise control returns to the switch.
+#if defined(__GNUC__)
+#define THREADED_DISPATCH_AVAILABLE 1
+#else
+#define THREADED_DISPATCH_AVAILABLE 0
+#endif
+
+#if THREADED_DISPATCH_AVAILABLE
+#define DISPATCH()                                              \
+    do {                                                        \
+        if (THREADED) {                                         \
+            inst = &code[pc];                                   \
+            executed++;                                         \
+            if (PROFILING) counters.executions[pc]++;           \
+            goto *targets[inst->op];                            \
+        }                                                       \
+        goto dispatch;                                          \
+    } while (0)
+#define TARGET(op) case op: do_##op
+#else
+#define DISPATCH() goto dispatch
+#define TARGET(op) case op
+#endif
+#define NEXT()      \
+    do {            \
+        ++pc;       \
+        DISPATCH(); \
+    } while (0)
+#define JUMP(target)            \
+    do {                        \
+        jump(pc, target);       \
+        DISPATCH();             \
+    } while (0)
+
+// Ends the timing of the active loops that do not contain IR index `next`.
+static void leaveLoops(ProfileCounters& counters, int next) {
+    auto now = std::chrono::steady_clock::now();
+    while (!counters.activeLoops.empty()) {
+        const ProfileCounters::ActiveLoop& loop = counters.activeLoops.back();
+        if (next >= loop.start && next <= loop.end) break;
+        counters.loopMilliseconds[loop.start] += std::chrono::duration<double, std::milli>(now - loop.since).count();
+        counters.activeLoops.pop_back();
+    }
+}
+
+[[noreturn]] static void outOfBounds(const BytecodeProgram& program, int array, int index) {
+    const ArrayLayout& layout = program.arrays[array];
+    throw RuntimeError(outOfBoundsMessage(index, program.texts[layout.name], layout.size));
+}
+
+// What a run may still use of its ExecutionLimits, LONG_MAX where there is
+// no limit. run() checks instructions at every jump and string memory at
+// every concatenation.
+struct Budget {
+    long instructions;
+    long stringBytes;  // growth of StringValue::allocatedBytes()
+};
+
+[[noreturn]] static void instructionLimit() {
+    throw LimitExceeded(LimitExceeded::INSTRUCTIONS, "Limit Error: the instruction limit was reached");
+}
+
+[[noreturn]] static void stringLimit() {
+    throw LimitExceeded(LimitExceeded::MEMORY, "Limit Error: sttring values went over the memory limit");
+}
+
+[[noreturn]] static void outputLimit() {
+    throw LimitExceeded(LimitExceeded::OUTPUT, "Limit Error: the output limit was reached");
+}
+
+// Chunks per thread a parallel loop is cut into, so that threads that
+// finish early can steal from the others.
+static const int CHUNKS_PER_THREAD = 4;
+
+template <bool THREADED>
+static long runParallel(const BytecodeProgram& program, const ParallelCode& loop, int* slots, char* assigned,
+                        StringValue* strings, int* cells, ProfileCounters& counters, OutputBuffer& out,
+                        InputReader& in, const Budget& budget, ThreadPool* pool);
+
+// Runs from pc until a `return`, the end of the code or, in the iterations
+// of a parallel loop, its OP_PAR_NEXT.
+template <bool PROFILING, bool THREADED>
+static int run(const BytecodeProgram& program, int* slots, char* assigned, StringValue* strings, int* cells,
+               ProfileCounters& counters, OutputBuffer& out, InputReader& in, long& steps, const Budget& budget,
+               ThreadPool* pool = nullptr, int pc = 0) {
+#if THREADED_DISPATCH_AVAILABLE
+    static const void* const targets[] = {
+        &&do_OP_COPY, &&do_OP_ADD, &&do_OP_SUB, &&do_OP_MUL, &&do_OP_DIV, &&do_OP_MOD,
+        &&do_OP_LT, &&do_OP_GT, &&do_OP_LE, &&do_OP_GE, &&do_OP_EQ, &&do_OP_NE,
+        &&do_OP_MARK, &&do_OP_JUMP, &&do_OP_JUMP_IF_FALSE, &&do_OP_JUMP_TABLE,
+        &&do_OP_PARAM, &&do_OP_PRINT_CALL, &&do_OP_PRINT_VAR, &&do_OP_PRINT_TEXT, &&do_OP_READ,
+        &&do_OP_STR_COPY, &&do_OP_STR_CONCAT, &&do_OP_PRINT_STR,
+        &&do_OP_LOAD, &&do_OP_STORE, &&do_OP_BOUNDS, &&do_OP_PARALLEL, &&do_OP_PAR_NEXT,
+        &&do_OP_RETURN, &&do_OP_LABEL, &&do_OP_BAD_LITERAL, &&do_OP_HALT,
+        &&do_OP_JLT, &&do_OP_JGT, &&do_OP_JLE, &&do_OP_JGE, &&do_OP_JEQ, &&do_OP_JNE};
+    static_assert(sizeof(targets) / sizeof(targets[0]) == OP_COUNT, "one target per opcode");
+#endif
+    const BytecodeInstr* code = program.code.data();
+    const BytecodeInstr* inst;
+    const int32_t* source = program.source.data();
+    int pending = -1;  // frame index of the last param, -1 if none
+    long executed = 0;
+    const long maxInstructions = budget.instructions;
+    const long stringBase = StringValue::allocatedBytes();
+    auto printed = [&]() {
+        if (out.truncated()) {
+            steps = executed;
+            outputLimit();
+        }
+    };
+
+    auto jump = [&](int& pc, int target) {
+        if (executed > maxInstructions) {
+            steps = executed;
+            instructionLimit();
+        }
+        if (PROFILING) {
+            if (source[target] <= source[pc]) counters.backEdges[source[target]]++;
+            if (!counters.activeLoops.empty()) leaveLoops(counters, source[target]);
+        }
+        pc = target;
+    };
+
+    for (;;) {
+    dispatch:
+        inst = &code[pc];
+        executed++;
+        if (PROFILING) counters.executions[pc]++;
+        switch (inst->op) {
+        TARGET(OP_COPY): slots[inst->c] = slots[inst->a]; NEXT();
+        TARGET(OP_ADD): slots[inst->c] = (int)((unsigned)slots[inst->a] + (unsigned)slots[inst->b]); NEXT();
+        TARGET(OP_SUB): slots[inst->c] = (int)((unsigned)slots[inst->a] - (unsigned)slots[inst->b]); NEXT();
+        TARGET(OP_MUL): slots[inst->c] = (int)((unsigned)slots[inst->a] * (unsigned)slots[inst->b]); NEXT();
+        TARGET(OP_DIV): {
+            // INT_MIN / -1 would trap; it wraps to INT_MIN on every backend
+            int denominator = slots[inst->b];
+            if (denominator == -1) slots[inst->c] = (int)(0u - (unsigned)slots[inst->a]);
+            else slots[inst->c] = (denominator != 0) ? slots[inst->a] / denominator : 0;
+            NEXT();
+        }
+        TARGET(OP_MOD): {
+            int denominator = slots[inst->b];
+            slots[inst->c] = (denominator != 0 && denominator != -1) ? slots[inst->a] % denominator : 0;
+            NEXT();
+        }
+        TARGET(OP_LT): slots[inst->c] = slots[inst->a] < slots[inst->b]; NEXT();
+        TARGET(OP_GT): slots[inst->c] = slots[inst->a] > slots[inst->b]; NEXT();
+        TARGET(OP_LE): slots[inst->c] = slots[inst->a] <= slots[inst->b]; NEXT();
+        TARGET(OP_GE): slots[inst->c] = slots[inst->a] >= slots[inst->b]; NEXT();
+        TARGET(OP_EQ): slots[inst->c] = slots[inst->a] == slots[inst->b]; NEXT();
+        TARGET(OP_NE): slots[inst->c] = slots[inst->a] != slots[inst->b]; NEXT();
+        TARGET(OP_MARK): assigned[inst->a] = 1; NEXT();
+        TARGET(OP_JUMP): JUMP(inst->c);
+        TARGET(OP_JUMP_IF_FALSE):
+            if (!slots[inst->a]) {
+                if (PROFILING) counters.taken[source[pc]]++;
+                JUMP(inst->c);
+            }
+            if (PROFILING) {
+                counters.notTaken[source[pc]]++;
+                if (!counters.activeLoops.empty()) leaveLoops(counters, source[pc] + 1);
+            }
+            NEXT();
+        TARGET(OP_JUMP_TABLE): {
+            const JumpTable& table = program.tables[inst->b];
+            long long index = (long long)slots[inst->a] - table.min;
+            JUMP((index >= 0 && index < (long long)table.targets.size()) ? table.targets[index] : table.fallback);
+        }
+        TARGET(OP_PARAM): pending = inst->a; NEXT();
+        TARGET(OP_PRINT_CALL):
+            if (pending >= 0) {
+                out.writeInt(slots[pending]);
+                pending = -1;
+                printed();
+            }
+            NEXT();
+        TARGET(OP_PRINT_VAR):
+            if (assigned[inst->a]) out.writeInt(slots[inst->a]);
+            else out.writeLine(program.texts[inst->b]);
+            printed();
+            NEXT();
+        TARGET(OP_PRINT_TEXT): out.writeLine(program.texts[inst->b]); printed(); NEXT();
+        TARGET(OP_READ): slots[inst->c] = in.readInt(); NEXT();
+        TARGET(OP_STR_COPY): strings[inst->c] = strings[inst->a]; NEXT();
+        TARGET(OP_STR_CONCAT):
+            strings[inst->c] = StringValue::concat(strings[inst->a], strings[inst->b]);
+            if (StringValue::allocatedBytes() - stringBase > budget.stringBytes) {
+                steps = executed;
+                stringLimit();
+            }
+            NEXT();
+        TARGET(OP_PRINT_STR): {
+            const StringValue& value = strings[inst->a];
+            out.writeLine(value.data(), value.size());
+            printed();
+            NEXT();
+        }
+        TARGET(OP_LOAD): slots[inst->c] = cells[inst->b + slots[inst->a]]; NEXT();
+        TARGET(OP_STORE): cells[inst->c + slots[inst->a]] = slots[inst->b]; NEXT();
+        TARGET(OP_BOUNDS):
+            if ((uint32_t)slots[inst->a] >= (uint32_t)inst->c) {
+                steps = executed;
+                outOfBounds(program, inst->b, slots[inst->a]);
+            }
+            NEXT();
+        TARGET(OP_PARALLEL): {
+            const ParallelCode& loop = program.loops[inst->c];
+            Budget rest = {maxInstructions - executed, budget.stringBytes};
+            executed += runParallel<THREADED>(program, loop, slots, assigned, strings, cells, counters, out, in, rest,
+                                              pool);
+            if (executed > maxInstructions) {
+                steps = executed;
+                instructionLimit();
+            }
+            pc = loop.exit;
+            DISPATCH();
+        }
+        TARGET(OP_PAR_NEXT):
+            if (slots[inst->a] < slots[inst->b]) {
+                if (executed > maxInstructions) {
+                    steps = executed;
+                    instructionLimit();
+                }
+                pc = inst->c;
+                DISPATCH();
+            }
+            steps = executed;
+            return 0;
+        TARGET(OP_RETURN):
+            steps = executed;
+            return slots[inst->a];
+        TARGET(OP_LABEL):
+            if (PROFILING) {
+                counters.labelHits[inst->a]++;
+                if (inst->b >= 0 && (counters.activeLoops.empty() || counters.activeLoops.back().start != inst->a))
+                    counters.activeLoops.push_back({inst->a, inst->b, std::chrono::steady_clock::now()});
+            }
+            NEXT();
+        TARGET(OP_BAD_LITERAL): std::stoi(program.texts[inst->b]); NEXT();
+        TARGET(OP_HALT):
+            steps = executed;
+            return 0;
+        TARGET(OP_JLT): if (slots[inst->a] < slots[inst->b]) JUMP(inst->c); NEXT();
+        TARGET(OP_JGT): if (slots[inst->a] > slots[inst->b]) JUMP(inst->c); NEXT();
+        TARGET(OP_JLE): if (slots[inst->a] <= slots[inst->b]) JUMP(inst->c); NEXT();
+        TARGET(OP_JGE): if (slots[inst->a] >= slots[inst->b]) JUMP(inst->c); NEXT();
+        TARGET(OP_JEQ): if (slots[inst->a] == slots[inst->b]) JUMP(inst->c); NEXT();
+        TARGET(OP_JNE): if (slots[inst->a] != slots[inst->b]) JUMP(inst->c); NEXT();
+        case OP_COUNT: break;
+        }
+    }
+}
+
+// Runs the iterations of a parallel loop from the loop variable up to the
+// bound and leaves the variable at the bound, as the sequential loop would.
+// With a pool the range is cut into chunks, each run on a copy of the frame
+// with the reduction variables at their identities; the partial results
+// are combined in chunk order, and the error of the first failing chunk is
+// rethrown, so the outcome does not depend on the schedule. The array cells
+// are shared, as each iteration writes only its own elements. Each chunk
+// may use the whole budget left; the caller checks the total. Returns the
+// instructions executed.
+template <bool THREADED>
+static long runParallel(const BytecodeProgram& program, const ParallelCode& loop, int* slots, char* assigned,
+                        StringValue* strings, int* cells, ProfileCounters& counters, OutputBuffer& out,
+                        InputReader& in, const Budget& budget, ThreadPool* pool) {
+    int lo = slots[loop.var], hi = slots[loop.bound];
+    if (lo >= hi) return 0;
+    long long count = (long long)hi - lo;
+    size_t chunks = pool ? (size_t)std::min<long long>(count, CHUNKS_PER_THREAD * (pool->size() + 1)) : 1;
+    long steps = 0;
+    slots[loop.limit] = hi;
+    if (chunks == 1) {
+        run<false, THREADED>(program, slots, assigned, strings, cells, counters, out, in, steps, budget, nullptr,
+                             loop.body);
+        return steps;
+    }
+
+    struct Chunk {
+        std::vector<int> slots;
+        std::vector<char> assigned;
+        long steps = 0;
+        std::exception_ptr error;
+    };
+    std::vector<Chunk> parts(chunks);
+    size_t frameSize = program.frame.size();
+    pool->parallelFor(chunks, 1, [&](size_t begin, size_t end) {
+        for (size_t k = begin; k < end; ++k) {
+            Chunk& part = parts[k];
+            part.slots.assign(slots, slots + frameSize);
+            part.assigned.assign(assigned, assigned + frameSize);
+            for (const auto& reduction : loop.reductions) part.slots[reduction.first] = reduction.second;
+            part.slots[loop.var] = lo + (int)(count * k / chunks);
+            part.slots[loop.limit] = lo + (int)(count * (k + 1) / chunks);
+            try {
+                run<false, THREADED>(program, part.slots.data(), part.assigned.data(), strings, cells, counters, out,
+                                     in, part.steps, budget, nullptr, loop.body);
+            } catch (...) {
+                part.error = std::current_exception();
+            }
+        }
+    });
+    for (const Chunk& part : parts) {
+        if (part.error) std::rethrow_exception(part.error);
+        for (const auto& reduction : loop.reductions) {
+            unsigned total = slots[reduction.first], partial = part.slots[reduction.first];
+            slots[reduction.first] = (int)(reduction.second == 1 ? total * partial : total + partial);
+            assigned[reduction.first] |= part.assigned[reduction.first];
+        }
+        steps += part.steps;
+    }
+    slots[loop.var] = hi;
+    return steps;
+}
+
+#undef DISPATCH
+#undef TARGET
+#undef NEXT
+#undef JUMP
+
+PreparedProgram::PreparedProgram(const std::vector<Instruction>& code, bool profiling)
+    : code(code), profiling(profiling) {
+    BytecodeCompiler compiler;
+    bytecode = compiler.compile(code, profiling);
+}
+
+const BytecodeProgram& PreparedProgram::getBytecode() const {
+    return bytecode;
+}
+
+const std::vector<Instruction>& PreparedProgram::getCode() const {
+    return code;
+}
+
+bool PreparedProgram::isProfiling() const {
+    return profiling;
+}
+
+ExecutionContext::ExecutionContext(std::shared_ptr<const PreparedProgram> program)
+    : program(std::move(program)), input(&noInput) {}
+
+void ExecutionContext::setOutput(std::ostream& out) {
+    output.setStream(out);
+}
+
+void ExecutionContext::setInput(InputReader& in) {
+    input = &in;
+}
+
+void ExecutionContext::setDispatch(DispatchMode mode) {
+    dispatch = mode;
+}
+
+void ExecutionContext::setThreadPool(ThreadPool* pool) {
+    this->pool = pool;
+}
+
+void ExecutionContext::setLimits(const ExecutionLimits& limits) {
+    this->limits = limits;
+}
+
+int ExecutionContext::run() {
+    const BytecodeProgram& bytecode = program->getBytecode();
+    steps = 0;
+    size_t memory = bytecode.frame.size() * (sizeof(int) + sizeof(char)) +
+                    bytecode.strings.size() * sizeof(StringValue) + (size_t)bytecode.cells * sizeof(int);
+    if (limits.memory && memory > limits.memory) {
+        throw LimitExceeded(LimitExceeded::MEMORY, "Limit Error: the program needs " + std::to_string(memory) +
+                                                       " bytes of memory, the limit is " +
+                                                       std::to_string(limits.memory));
+    }
+    Budget budget = {limits.instructions ? limits.instructions : LONG_MAX,
+                     limits.memory ? (long)(limits.memory - memory) : LONG_MAX};
+    output.setLimit(limits.output);
+    frame.assign(bytecode.frame.begin(), bytecode.frame.end());
+    assigned.assign(frame.size(), 0);
+    strings.resize(bytecode.strings.size());
+    for (size_t i = 0; i < strings.size(); ++i) {
+        int text = bytecode.strings[i];
+        strings[i] = text >= 0 ? StringValue::literal(bytecode.texts[text]) : StringValue();
+    }
+    cells.assign(bytecode.cells, 0);
+    bool profiling = program->isProfiling();
+    if (profiling) {
+        size_t size = program->getCode().size();
+        counters.taken.assign(size, 0);
+        counters.notTaken.assign(size, 0);
+        counters.labelHits.assign(size, 0);
+        counters.backEdges.assign(size, 0);
+        counters.executions.assign(bytecode.code.size(), 0);
+        counters.loopMilliseconds.assign(size, 0);
+        counters.activeLoops.clear();
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    bool threaded = THREADED_DISPATCH_AVAILABLE && dispatch == DISPATCH_THREADED;
+    auto runner = profiling ? (threaded ? ::run<true, true> : ::run<true, false>)
+                            : (threaded ? ::run<false, true> : ::run<false, false>);
+    int exitCode;
+    input->tie(&output);
+    try {
+        exitCode = runner(bytecode, frame.data(), assigned.data(), strings.data(), cells.data(), counters, output, *input,
+                          steps, budget, pool, 0);
+    } catch (...) {
+        input->tie(nullptr);
+        output.flush();
+        throw;
+    }
+    input->tie(nullptr);
+    if (profiling) leaveLoops(counters, -1);
+    output.flush();
+    if (output.truncated()) outputLimit();
+    auto end = std::chrono::steady_clock::now();
+    milliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+    return exitCode;
+}
+
+long ExecutionContext::getSteps() const {
+    return steps;
+}
+
+double ExecutionContext::getMilliseconds() const {
+    return milliseconds;
+}
+
+Profile ExecutionContext::getProfile() const {
+    Profile profile;
+    if (!program->isProfiling() || counters.taken.empty()) return profile;
+    const std::vector<Instruction>& code = program->getCode();
+    for (size_t i = 0; i < code.size(); ++i) {
+        if (code[i].op == "ifFalse" && (counters.taken[i] || counters.notTaken[i])) {
+            BranchCounts& counts = profile.branches[Profile::branchKey(code[i])];
+            counts.taken += counters.taken[i];
+            counts.notTaken += counters.notTaken[i];
+        }
+        if (code[i].op == "label" && counters.backEdges[i]) {
+            // An unrolled loop is entered as often as the loop left for its last trips.
+            LoopCounts& counts = profile.loops[Profile::labelKey(code[i].result)];
+            counts.entries = std::max(counts.entries, counters.labelHits[i] - counters.backEdges[i]);
+            counts.trips += counters.backEdges[i] * Profile::tripsPerIteration(code[i].result);
+        }
+    }
+    return profile;
+}
+
+RuntimeProfile ExecutionContext::getRuntimeProfile() const {
+    RuntimeProfile profile;
+    if (!program->isProfiling() || counters.executions.empty()) return profile;
+    const std::vector<Instruction>& code = program->getCode();
+    const BytecodeProgram& bytecode = program->getBytecode();
+
+    // an IR instruction ran as often as the first bytecode lowered from it
+    std::vector<long> executions(code.size(), -1);
+    for (size_t pc = 0; pc < bytecode.code.size(); ++pc) {
+        int i = bytecode.source[pc];
+        if (i < (int)code.size() && executions[i] < 0) executions[i] = counters.executions[pc];
+        const BytecodeInstr& instr = bytecode.code[pc];
+        if (instr.op != OP_LABEL || instr.b < 0 || !counters.labelHits[i]) continue;
+        LoopProfile loop;
+        loop.label = code[i].result;
+        loop.line = code[i].line;
+        loop.entries = counters.labelHits[i] - counters.backEdges[i];
+        loop.trips = counters.backEdges[i];
+        loop.milliseconds = counters.loopMilliseconds[i];
+        profile.loops.push_back(loop);
+    }
+    for (size_t i = 0; i < code.size(); ++i) {
+        if (executions[i] <= 0) continue;
+        InstructionProfile instr;
+        instr.index = i;
+        instr.instruction = code[i];
+        instr.executions = executions[i];
+        instr.taken = counters.taken[i];
+        instr.notTaken = counters.notTaken[i];
+        profile.instructions.push_back(instr);
+        profile.executions += executions[i];
+    }
+    profile.milliseconds = milliseconds;
+    return profile;
+}
+
+void Interpreter::setProfileOutput(const std::string& path) {
+    profilePath = path;
+}
+
+void Interpreter::setProfiling(bool enabled) {
+    profiling = enabled;
+}
+
+const RuntimeProfile& Interpreter::getRuntimeProfile() const {
+    return runtimeProfile;
+}
+
+void Interpreter::setDispatch(DispatchMode mode) {
+    dispatch = mode;
+}
+
+void Interpreter::setInput(InputReader& in) {
+    input = &in;
+}
+
+void Interpreter::setThreads(unsigned threads) {
+    this->threads = threads;
+}
+
+void Interpreter::setLimits(const ExecutionLimits& limits) {
+    this->limits = limits;
+}
+
+int Interpreter::execute(const std::vector<Instruction>& code) {
+    return execute(std::make_shared<const PreparedProgram>(code, profiling || !profilePath.empty()));
+}
+
+int Interpreter::execute(const std::shared_ptr<const PreparedProgram>& program) {
+    ExecutionContext context(program);
+    context.setDispatch(dispatch);
+    context.setLimits(limits);
+    if (input) context.setInput(*input);
+    parallelLoops = program->getBytecode().loops.size();
+    unsigned workers = threads > 0 ? threads : std::thread::hardware_concurrency();
+    if (parallelLoops && workers > 1) {
+        if (!pool || pool->size() != workers - 1) pool.reset(new ThreadPool(workers - 1));  // the calling thread works too
+        context.setThreadPool(pool.get());
+    }
+    int exitCode = context.run();
+    bytecodeSize = program->getBytecode().code.size();
+    frameSize = program->getBytecode().frame.size();
+    stringFrameSize = program->getBytecode().strings.size();
+    arrayCells = program->getBytecode().cells;
+    superinstructions = program->getBytecode().superinstructions;
+    steps = context.getSteps();
+    milliseconds = context.getMilliseconds();
+    runtimeProfile = program->isProfiling() ? context.getRuntimeProfile() : RuntimeProfile();
+
+    if (!profilePath.empty()) {
+        if (!program->isProfiling())
+            std::cerr << "Program was not prepared for profiling; no profile written to " << profilePath << std::endl;
+        else if (!context.getProfile().save(profilePath))
+            std::cerr << "Could not write profile to " << profilePath << std::endl;
+    }
+    return exitCode;
+}
+
+void Interpreter::printStatistics() {
+    std::cout << "\n--- Interpreter ---\n";
+    std::cout << std::left << std::setw(22) << "bytecode" << bytecodeSize << " instructions\n";
+    std::cout << std::setw(22) << "superinstructions" << superinstructions << "\n";
+    std::cout << std::setw(22) << "frame" << frameSize << " slots\n";
+    if (stringFrameSize) std::cout << std::setw(22) << "string frame" << stringFrameSize << " slots\n";
+    if (arrayCells) std::cout << std::setw(22) << "arrays" << arrayCells << " cells\n";
+    if (parallelLoops) {
+        std::cout << std::setw(22) << "parallel loops" << parallelLoops << " on "
+                  << (pool ? pool->size() + 1 : 1) << " threads\n";
+    }
+    bool threaded = THREADED_DISPATCH_AVAILABLE && dispatch == DISPATCH_THREADED;
+    std::cout << std::setw(22) << "dispatch" << (threaded ? "threaded" : "switch") << "\n";
+    std::cout << std::setw(22) << "executed" << steps << " instructions\n";
+    std::cout << std::setw(22) << "time" << std::fixed << std::setprecision(3) << milliseconds << " ms\n";
+    double perSecond = milliseconds > 0 ? steps / (milliseconds / 1000) : 0;
+    std::cout << std::setw(22) << "throughput" << std::setprecision(1) << perSecond / 1e6
+              << " M instructions/s\n";
+    std::cout << std::right << std::defaultfloat;
+}
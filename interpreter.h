@@ -1,25 +1,159 @@
-#ifndef INTERPRETER_H
-#define INTERPRETER_H
-
-#include <vector>
-#include <string>
-#include <unordered_map>
-#include "lexer.h"
-#include "parser.h"
-#include "semantic.h"
-#include "icg.h"
-#include "optimizer.h"
-#include "codegen.h"
-
-class Interpreter {
-public:
-    void execute(const std::vector<Instruction>& code);
-
-private:
-    std::unordered_map<std::string, int> variables;
-    std::unordered_map<std::string, int> labels;
-    int getValue(const std::string& token);
-    bool isNumber(const std::string& s);
-};
-
-#endif
+#ifndef INTERPRETER_H
+#define INTERPRETER_H
+
+#include <chrono>
+#include <memory>
+#include <ostream>
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include "lexer.h"
+#include "parser.h"
+#include "semantic.h"
+#include "icg.h"
+#include "optimizer.h"
+#include "codegen.h"
+#include "profile.h"
+#include "bytecode.h"
+#include "runtime_io.h"
+#include "runtime_string.h"
+#include "thread_pool.h"
+
+// Threaded dispatch needs computed goto; without compiler support the
+// interpreter always uses the switch.
+enum DispatchMode { DISPATCH_SWITCH, DISPATCH_THREADED };
+
+// Only filled when the program was prepared for profiling.
+struct ProfileCounters {
+    struct ActiveLoop {
+        int start, end;  // IR indices of the start label and the last jump back to it
+        std::chrono::steady_clock::time_point since;
+    };
+    std::vector<long> taken, notTaken, labelHits, backEdges;  // per IR instruction
+    std::vector<long> executions;                             // per bytecode instruction
+    std::vector<double> loopMilliseconds;                     // per IR start label
+    std::vector<ActiveLoop> activeLoops;                      // innermost last
+};
+
+// Bounds on one run of a program; 0 means no bound. Memory counts the
+// frame, string frame and array cells, which are checked before the run
+// starts, and what sttring values allocate while it runs. A run that goes
+// over a limit throws LimitExceeded. The instruction count may pass its
+// limit by a loop body's worth before the next jump notices, and output is
+// cut at its limit but noticed at the next print.
+struct ExecutionLimits {
+    long instructions = 0;  // bytecode instructions executed
+    size_t memory = 0;      // bytes
+    size_t output = 0;      // bytes, including newlines
+};
+
+// A run stopped because it went over one of its ExecutionLimits.
+class LimitExceeded : public RuntimeError {
+public:
+    enum Kind { INSTRUCTIONS, MEMORY, OUTPUT };
+
+    LimitExceeded(Kind kind, const std::string& message) : RuntimeError(message), kind(kind) {}
+
+    Kind kind;
+};
+
+// A program lowered once to bytecode (see BytecodeCompiler), together with
+// the IR it came from. Nothing in it changes after construction, so one
+// instance may be shared by any number of ExecutionContexts on any threads
+// without locking.
+class PreparedProgram {
+public:
+    // With profiling, labels are kept and superinstructions are not formed,
+    // so that runs can count executions, branches and loop trips per IR
+    // instruction and time each loop.
+    explicit PreparedProgram(const std::vector<Instruction>& code, bool profiling = false);
+
+    const BytecodeProgram& getBytecode() const;
+    const std::vector<Instruction>& getCode() const;
+    bool isProfiling() const;
+
+private:
+    std::vector<Instruction> code;
+    BytecodeProgram bytecode;
+    bool profiling;
+};
+
+// The mutable state of running a PreparedProgram: the frame, string frame
+// and array cells, the output buffer, the input, the limits and the
+// counters. Every run() starts from a fresh copy of the program's initial
+// frame, so nothing leaks from one run into the next; the buffers are kept
+// between runs to avoid reallocating them. Output is flushed when the run
+// ends. A context belongs to one thread at a time.
+class ExecutionContext {
+public:
+    explicit ExecutionContext(std::shared_ptr<const PreparedProgram> program);
+
+    void setOutput(std::ostream& out);  // std::cout by default
+    void setInput(InputReader& in);     // `san` reads 0 without one
+    void setDispatch(DispatchMode mode);
+    void setThreadPool(ThreadPool* pool);  // runs parallel loops on it; without one they run sequentially
+    void setLimits(const ExecutionLimits& limits);
+
+    // Runs until the end of the code or a `return`; yields the returned value, or 0.
+    // Throws RuntimeError when an array index is out of bounds, and
+    // LimitExceeded when the run goes over one of its limits.
+    int run();
+
+    long getSteps() const;           // bytecode instructions executed by the last run
+    double getMilliseconds() const;  // time spent in the last run
+    Profile getProfile() const;      // of the last run; empty unless the program was prepared for profiling
+    RuntimeProfile getRuntimeProfile() const;  // likewise
+
+private:
+    std::shared_ptr<const PreparedProgram> program;
+    std::vector<int> frame;
+    std::vector<char> assigned;
+    std::vector<StringValue> strings;
+    std::vector<int> cells;
+    ProfileCounters counters;
+    OutputBuffer output;
+    InputReader noInput{std::string()};
+    InputReader* input;
+    DispatchMode dispatch = DISPATCH_THREADED;
+    ThreadPool* pool = nullptr;
+    ExecutionLimits limits;
+    long steps = 0;
+    double milliseconds = 0;
+};
+
+// Runs three-address code by preparing it and executing it in a new context
+// each time; execute() on a PreparedProgram skips the lowering.
+class Interpreter {
+public:
+    // Runs until the end of the code or a `return`; yields the returned value, or 0.
+    int execute(const std::vector<Instruction>& code);
+    int execute(const std::shared_ptr<const PreparedProgram>& program);
+    void setProfileOutput(const std::string& path);  // write a Profile after each run
+    void setProfiling(bool enabled);                 // collect a RuntimeProfile of each run
+    void setDispatch(DispatchMode mode);
+    void setInput(InputReader& in);
+    void setThreads(unsigned threads);               // for parallel loops, 0: one per hardware thread
+    void setLimits(const ExecutionLimits& limits);   // of every run; none by default
+    void printStatistics();                          // of the last execute()
+    const RuntimeProfile& getRuntimeProfile() const; // of the last execute() of a profiling program
+
+private:
+    std::string profilePath;
+    bool profiling = false;
+    RuntimeProfile runtimeProfile;
+    DispatchMode dispatch = DISPATCH_THREADED;
+    InputReader* input = nullptr;
+    unsigned threads = 0;
+    ExecutionLimits limits;
+    std::unique_ptr<ThreadPool> pool;  // created for the first program with parallel loops
+    size_t parallelLoops = 0;
+    size_t bytecodeSize = 0;
+    int superinstructions = 0;
+    size_t frameSize = 0;
+    size_t stringFrameSize = 0;
+    size_t arrayCells = 0;
+    long steps = 0;           // bytecode instructions executed
+    double milliseconds = 0;  // spent running, without the lowering
+};
+
+#endif
@@ -0,0 +1,169 @@
+#include "jit.h"
+#include "encoder.h"
+#include "x86gen.h"
+#include <algorithm>
+#include <cstring>
+#include <sys/mman.h>
+#include <unistd.h>
+
+using namespace std;
+
+// Chunks per thread a parallel loop is cut into, as in the interpreter.
+static const long long CHUNKS_PER_THREAD = 4;
+
+// The context the host functions are called with.
+struct JitIO {
+    OutputBuffer& output;
+    InputReader& input;
+    string failure;  // set by a failed bounds check
+    ThreadPool* pool;
+    long localsSize;
+};
+
+static void jitPrintInt(void* context, int value) {
+    static_cast<JitIO*>(context)->output.writeInt(value);
+}
+
+static void jitPrintString(void* context, const char* text, size_t length) {
+    static_cast<JitIO*>(context)->output.writeLine(text, length);
+}
+
+static int jitReadInt(void* context) {
+    return static_cast<JitIO*>(context)->input.readInt();
+}
+
+static void jitFail(void* context, int index, const char* suffix, size_t length) {
+    static_cast<JitIO*>(context)->failure = OUT_OF_BOUNDS_PREFIX + to_string(index) + string(suffix, length);
+}
+
+// Each chunk runs on its own copy of the variables at the start of the
+// frame; the failure of the first chunk in order is the loop's, as in the
+// interpreter.
+static ParallelResult jitParallel(void* context, ParallelChunk chunk, void* frame, int lo, int hi) {
+    JitIO& io = *static_cast<JitIO*>(context);
+    long long count = (long long)hi - lo;
+    size_t chunks = io.pool ? (size_t)min(count, CHUNKS_PER_THREAD * (io.pool->size() + 1)) : 1;
+    vector<ParallelResult> results(chunks);
+    auto body = [&](size_t begin, size_t end) {
+        vector<uint64_t> locals((io.localsSize + 7) / 8);
+        for (size_t k = begin; k < end; ++k) {
+            memcpy(locals.data(), frame, io.localsSize);
+            results[k] = chunk(locals.data(), frame, lo + (int)(count * k / chunks),
+                               lo + (int)(count * (k + 1) / chunks));
+        }
+    };
+    if (io.pool) io.pool->parallelFor(chunks, 1, body);
+    else body(0, chunks);
+    for (const auto& result : results) {
+        if (result.failure) return result;
+    }
+    return ParallelResult{0, 0};
+}
+
+JitCompiler::~JitCompiler() {
+    release();
+}
+
+void JitCompiler::release() {
+    if (memory) munmap(memory, mappedSize);
+    memory = nullptr;
+    entry = nullptr;
+    mappedSize = codeSize = 0;
+}
+
+bool JitCompiler::compile(const vector<Instruction>& code) {
+    release();
+    errors.clear();
+    if (!findStringNames(code).empty()) {
+        errors.push_back("sttring values are only supported by the interpreter");
+        return false;
+    }
+
+    X86Generator generator(TARGET_JIT);
+    MachineProgram program = generator.generate(code);
+    frameSize = generator.getFrameSize();
+    localsSize = generator.getLocalsSize();
+    parallelLoops = generator.getParallelLoops();
+    X86Encoder encoder;
+    if (!encoder.encode(program.text)) {
+        errors.push_back("Could not encode the program");
+        encoder.printErrors();
+        return false;
+    }
+
+    // Layout: code, then the string constants it addresses rip-relative.
+    const vector<uint8_t>& text = encoder.getCode();
+    vector<uint8_t> image(text.begin(), text.end());
+    unordered_map<string, size_t> symbols = encoder.getLabels();
+    for (const auto& str : program.strings) {
+        symbols[str.first] = image.size();
+        image.insert(image.end(), str.second.begin(), str.second.end());
+    }
+    for (const auto& relocation : encoder.getRelocations()) {
+        auto symbol = symbols.find(relocation.symbol);
+        if (symbol == symbols.end()) {
+            errors.push_back("Undefined symbol " + relocation.symbol);
+            continue;
+        }
+        int32_t value = (int32_t)((long long)symbol->second + relocation.addend - (long long)relocation.offset);
+        memcpy(&image[relocation.offset], &value, sizeof(value));
+    }
+    if (!errors.empty()) return false;
+
+    size_t page = sysconf(_SC_PAGESIZE);
+    size_t size = (image.size() + page - 1) / page * page;
+    void* mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED) {
+        errors.push_back("mmap failed: " + string(strerror(errno)));
+        return false;
+    }
+    memcpy(mapping, image.data(), image.size());
+    if (mprotect(mapping, size, PROT_READ | PROT_EXEC) != 0) {
+        errors.push_back("mprotect failed: " + string(strerror(errno)));
+        munmap(mapping, size);
+        return false;
+    }
+    memory = mapping;
+    mappedSize = size;
+    codeSize = text.size();
+    entry = reinterpret_cast<Entry>(static_cast<uint8_t*>(memory) + symbols[program.entry]);
+    return true;
+}
+
+int JitCompiler::run(ostream& out, InputReader* in) {
+    if (!entry) return 0;
+    vector<uint64_t> frame((frameSize + 7) / 8 + 1, 0);
+    unsigned workers = threads > 0 ? threads : thread::hardware_concurrency();
+    if (parallelLoops && workers > 1 && (!pool || pool->size() != workers - 1)) {
+        pool.reset(new ThreadPool(workers - 1));  // the calling thread works too
+    }
+    OutputBuffer output(out);
+    InputReader noInput((string()));
+    JitIO io{output, in ? *in : noInput, string(), parallelLoops && workers > 1 ? pool.get() : nullptr, localsSize};
+    void* header[] = {&io, reinterpret_cast<void*>(&jitPrintInt), reinterpret_cast<void*>(&jitPrintString),
+                      reinterpret_cast<void*>(&jitReadInt), reinterpret_cast<void*>(&jitFail),
+                      reinterpret_cast<void*>(&jitParallel)};
+    memcpy(reinterpret_cast<uint8_t*>(frame.data()) + JIT_CONTEXT, header, sizeof(header));
+    io.input.tie(&output);
+    int result = entry(frame.data());
+    io.input.tie(nullptr);
+    output.flush();
+    if (!io.failure.empty()) throw RuntimeError(io.failure);
+    return result;
+}
+
+void JitCompiler::setThreads(unsigned threads) {
+    this->threads = threads;
+}
+
+size_t JitCompiler::getCodeSize() const {
+    return codeSize;
+}
+
+void JitCompiler::printErrors() {
+    for (const auto& error : errors) cerr << "JIT error: " << error << endl;
+}
+
+bool JitCompiler::hasErrors() const {
+    return !errors.empty();
+}
@@ -0,0 +1,50 @@
+#ifndef JIT_H
+#define JIT_H
+
+#include "icg.h"
+#include "runtime_io.h"
+#include "thread_pool.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Compiles optimized IR straight to x86-64 machine code in memory and runs
+// it, as an alternative to the interpreter with the same output. The code is
+// written into a private mapping that only becomes executable, and stops
+// being writable, once it is complete. Parallel loops run on a thread pool.
+class JitCompiler {
+public:
+    JitCompiler() = default;
+    JitCompiler(const JitCompiler&) = delete;
+    JitCompiler& operator=(const JitCompiler&) = delete;
+    ~JitCompiler();
+
+    bool compile(const vector<Instruction>& code);
+    // Returns the program's return value. `san` reads 0 without an input.
+    // Throws RuntimeError when an array index is out of bounds.
+    int run(ostream& out = cout, InputReader* in = nullptr);
+    void setThreads(unsigned threads);  // for parallel loops, 0: one per hardware thread
+    size_t getCodeSize() const;
+    void printErrors();
+    bool hasErrors() const;
+
+private:
+    typedef int (*Entry)(void* frame);
+
+    void* memory = nullptr;
+    size_t mappedSize = 0;
+    size_t codeSize = 0;
+    Entry entry = nullptr;
+    long frameSize = 0;
+    long localsSize = 0;
+    int parallelLoops = 0;
+    unsigned threads = 0;
+    unique_ptr<ThreadPool> pool;  // created for the first program with parallel loops
+    vector<string> errors;
+
+    void release();
+};
+
+#endif
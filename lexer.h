@@ -1,21 +1,22 @@
-#ifndef LEXER_H
-#define LEXER_H
-
-#include <string>
-#include <vector>
-using namespace std;
-
-enum TokenType {
-    KEYWORD, IDENTIFIER, NUMBER, STRING_LITERAL,
-    OPERATOR, DELIMITER, UNKNOWN
-};
-
-struct Token {
-    TokenType type;
-    string value;
-};
-
-vector<Token> tokenize(const string& sourceCode);
-void printTokens(const vector<Token>& tokens);
-
-#endif
+#ifndef LEXER_H
+#define LEXER_H
+
+#include <string>
+#include <vector>
+using namespace std;
+
+enum TokenType {
+    KEYWORD, IDENTIFIER, NUMBER, STRING_LITERAL,
+    OPERATOR, DELIMITER, UNKNOWN
+};
+
+struct Token {
+    TokenType type;
+    string value;
+    int line = 0;  // where the token starts, from 1
+};
+
+vector<Token> tokenize(const string& sourceCode);
+void printTokens(const vector<Token>& tokens);
+
+#endif
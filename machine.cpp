@@ -0,0 +1,142 @@
+#include "machine.h"
+#include <iomanip>
+#include <sstream>
+
+using namespace std;
+
+MachineOperand regOperand(int reg) {
+    MachineOperand operand;
+    operand.kind = MachineOperand::REG;
+    operand.base = reg;
+    return operand;
+}
+
+MachineOperand immOperand(long long value) {
+    MachineOperand operand;
+    operand.kind = MachineOperand::IMM;
+    operand.value = value;
+    return operand;
+}
+
+MachineOperand memOperand(int base, long long displacement) {
+    MachineOperand operand;
+    operand.kind = MachineOperand::MEM;
+    operand.base = base;
+    operand.value = displacement;
+    return operand;
+}
+
+MachineOperand memOperand(int base, int index, int scale, long long displacement) {
+    MachineOperand operand = memOperand(base, displacement);
+    operand.index = index;
+    operand.scale = scale;
+    return operand;
+}
+
+MachineOperand ripOperand(const string& symbol, long long displacement) {
+    MachineOperand operand = memOperand(NO_REGISTER, displacement);
+    operand.symbol = symbol;
+    return operand;
+}
+
+MachineOperand symbolOperand(const string& symbol) {
+    MachineOperand operand;
+    operand.kind = MachineOperand::SYMBOL;
+    operand.symbol = symbol;
+    return operand;
+}
+
+string registerName(int reg, char width) {
+    static const char* legacy[] = {"ax", "cx", "dx", "bx", "sp", "bp", "si", "di"};
+    static const char* low[] = {"al", "cl", "dl", "bl", "spl", "bpl", "sil", "dil"};
+    if (reg >= R8) {
+        string name = "%r" + to_string(reg);
+        if (width == 'l') return name + "d";
+        if (width == 'b') return name + "b";
+        return name;
+    }
+    if (width == 'b') return string("%") + low[reg];
+    return string(width == 'l' ? "%e" : "%r") + legacy[reg];
+}
+
+string formatOperand(const MachineOperand& operand, char width) {
+    switch (operand.kind) {
+    case MachineOperand::REG:
+        return registerName(operand.base, width);
+    case MachineOperand::IMM:
+        return "$" + to_string(operand.value);
+    case MachineOperand::SYMBOL:
+        return operand.symbol;
+    case MachineOperand::MEM: {
+        string text;
+        if (!operand.symbol.empty()) {
+            text = operand.symbol;
+            if (operand.value > 0) text += "+" + to_string(operand.value);
+            else if (operand.value < 0) text += to_string(operand.value);
+            return text + "(%rip)";
+        }
+        if (operand.value != 0) text = to_string(operand.value);
+        text += "(" + registerName(operand.base, 'q');
+        if (operand.index != NO_REGISTER)
+            text += "," + registerName(operand.index, 'q') + "," + to_string(operand.scale);
+        return text + ")";
+    }
+    default:
+        return "";
+    }
+}
+
+// Register widths follow the mnemonic's size suffix; the exceptions are the
+// extending moves, setcc (byte) and jumps/calls through a register (quad).
+static void operandWidths(const string& op, char& srcWidth, char& dstWidth) {
+    if (op == "movzbl") { srcWidth = 'b'; dstWidth = 'l'; return; }
+    if (op == "movslq") { srcWidth = 'l'; dstWidth = 'q'; return; }
+    if (op.compare(0, 3, "set") == 0) { srcWidth = dstWidth = 'b'; return; }
+    if (op[0] == 'j' || op == "call") { srcWidth = dstWidth = 'q'; return; }
+    char suffix = op.back();
+    srcWidth = dstWidth = (suffix == 'b' || suffix == 'l' || suffix == 'q') ? suffix : 'q';
+}
+
+string formatInstruction(const MachineInstr& instr) {
+    if (instr.op == "label") return instr.dst.symbol + ":";
+    if (instr.op == ".long") return "    .long " + instr.dst.symbol + " - " + instr.src.symbol;
+
+    char srcWidth, dstWidth;
+    operandWidths(instr.op, srcWidth, dstWidth);
+    string text = "    " + instr.op;
+    if (instr.src.kind != MachineOperand::NONE)
+        text += " " + formatOperand(instr.src, srcWidth) + ",";
+    if (instr.dst.kind != MachineOperand::NONE) {
+        bool indirect = (instr.op[0] == 'j' || instr.op == "call") && instr.dst.kind != MachineOperand::SYMBOL;
+        text += " " + string(indirect ? "*" : "") + formatOperand(instr.dst, dstWidth);
+    }
+    return text;
+}
+
+static string escapeString(const string& bytes) {
+    ostringstream out;
+    for (unsigned char c : bytes) {
+        if (c == '"' || c == '\\') out << '\\' << c;
+        else if (c >= 32 && c < 127) out << c;
+        else out << '\\' << oct << setw(3) << setfill('0') << (int)c << dec;
+    }
+    return out.str();
+}
+
+string printGas(const MachineProgram& program) {
+    ostringstream out;
+    out << "    .text\n    .globl " << program.entry << "\n";
+    for (const auto& instr : program.text) out << formatInstruction(instr) << "\n";
+    if (!program.strings.empty()) {
+        out << "\n    .section .rodata\n";
+        for (const auto& str : program.strings)
+            out << str.first << ":\n    .ascii \"" << escapeString(str.second) << "\"\n";
+    }
+    if (!program.bss.empty()) {
+        out << "\n    .bss\n    .balign 16\n";
+        for (const auto& block : program.bss)
+            out << block.first << ":\n    .zero " << block.second << "\n";
+    }
+    out << "\n    .section .note.GNU-stack,\"\",@progbits\n";
+    return out.str();
+}
@@ -0,0 +1,56 @@
+#ifndef MACHINE_H
+#define MACHINE_H
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// x86-64 general purpose registers, numbered as in the instruction encoding.
+enum MachineRegister {
+    NO_REGISTER = -1,
+    RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI,
+    R8, R9, R10, R11, R12, R13, R14, R15
+};
+
+struct MachineOperand {
+    enum Kind { NONE, REG, IMM, MEM, SYMBOL };
+    Kind kind = NONE;
+    int base = NO_REGISTER;   // REG: the register; MEM: base (NO_REGISTER: rip-relative)
+    int index = NO_REGISTER;  // MEM index register
+    int scale = 1;
+    long long value = 0;      // IMM: the value; MEM: displacement
+    string symbol;            // SYMBOL: the name; MEM: rip-relative symbol
+};
+
+MachineOperand regOperand(int reg);
+MachineOperand immOperand(long long value);
+MachineOperand memOperand(int base, long long displacement = 0);
+MachineOperand memOperand(int base, int index, int scale, long long displacement = 0);
+MachineOperand ripOperand(const string& symbol, long long displacement = 0);
+MachineOperand symbolOperand(const string& symbol);
+
+// One instruction in AT&T order, "op src, dst"; instructions with a single
+// operand keep it in dst. op is the GAS mnemonic including its size suffix.
+// Two pseudo ops exist: "label" defines dst's symbol and ".long" emits the
+// 32-bit difference dst - src, used for jump tables.
+struct MachineInstr {
+    string op;
+    MachineOperand src, dst;
+};
+
+// A complete program: code, read-only strings and zeroed data. Execution
+// starts at the `entry` label.
+struct MachineProgram {
+    vector<MachineInstr> text;
+    vector<pair<string, string>> strings;  // label, bytes
+    vector<pair<string, long>> bss;        // label, size in bytes
+    string entry = "_start";
+};
+
+string registerName(int reg, char width);  // width: 'b', 'l' or 'q'
+string formatOperand(const MachineOperand& operand, char width);
+string formatInstruction(const MachineInstr& instr);
+string printGas(const MachineProgram& program);
+
+#endif
@@ -0,0 +1,106 @@
+//g++ -std=gnu++17 main_batch.cpp compiler.cpp lexer.cpp parser.cpp semantic.cpp icg.cpp optimizer.cpp verifier.cpp evaluator.cpp profile.cpp thread_pool.cpp codegen.cpp runtime_io.cpp -pthread -o batch.exe
+
+// .\batch.exe [-O0|-O1|-O2|-O3] [--threads=N] [--quiet] FILE...
+//
+// Compiles every FILE to pseudo-assembly, several at once, and reports each
+// file's errors followed by the throughput of the whole batch. A file holds a
+// program, optionally followed by a line with `#` and input, which is ignored.
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "compiler.h"
+#include "thread_pool.h"
+using namespace std;
+
+struct BatchResult {
+    bool readable = false;
+    bool compiled = false;
+    size_t lines = 0;
+    size_t instructions = 0;
+    vector<string> errors;
+};
+
+static void compileFile(const string& file, const OptimizerOptions& options, BatchResult& result) {
+    ifstream in(file);
+    if (!in) return;
+    result.readable = true;
+    stringstream text;
+    text << in.rdbuf();
+    InputReader reader(text.str());
+    vector<string> lines;
+    string code = readSource(reader, &lines);
+    result.lines = lines.size();
+
+    Compiler compiler(options);
+    result.compiled = compiler.compile(code);
+    result.errors = compiler.getErrors();
+    result.instructions = compiler.getOptimized().size();
+}
+
+int main(int argc, char* argv[]) {
+    OptimizerOptions options;
+    unsigned threads = 0;
+    bool quiet = false;
+    vector<string> files;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg.size() == 3 && arg.compare(0, 2, "-O") == 0 && arg[2] >= '0' && arg[2] <= '3') {
+            options.level = arg[2] - '0';
+        } else if (arg.rfind("--threads=", 0) == 0) {
+            threads = atoi(arg.c_str() + 10);
+        } else if (arg == "--quiet") {
+            quiet = true;
+        } else if (arg.rfind("--", 0) == 0) {
+            cerr << "Unknown option: " << arg << endl;
+            return 1;
+        } else {
+            files.push_back(arg);
+        }
+    }
+    // Parallelism comes from compiling files side by side; each compilation runs on one thread.
+    options.threads = 1;
+
+    unsigned workers = threads > 0 ? threads : max(1u, thread::hardware_concurrency());
+    unique_ptr<ThreadPool> pool;
+    if (workers > 1) pool.reset(new ThreadPool(workers - 1));  // the calling thread works too
+
+    vector<BatchResult> results(files.size());
+    auto start = chrono::steady_clock::now();
+    auto body = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) compileFile(files[i], options, results[i]);
+    };
+    if (pool) pool->parallelFor(files.size(), 1, body);
+    else body(0, files.size());
+    double milliseconds = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    size_t lines = 0, failed = 0;
+    for (size_t i = 0; i < files.size(); ++i) {
+        const BatchResult& result = results[i];
+        lines += result.lines;
+        if (!result.readable) {
+            cout << files[i] << ": cannot be read\n";
+        } else if (!result.compiled) {
+            cout << files[i] << ": not compiled\n";
+            for (const string& error : result.errors) cout << "  " << error << "\n";
+        } else if (!quiet) {
+            cout << files[i] << ": ok, " << result.lines << " lines, " << result.instructions << " instructions\n";
+        }
+        if (!result.compiled) failed++;
+    }
+
+    double seconds = max(milliseconds, 1e-3) / 1000;
+    cout << "\n" << files.size() << " files, " << lines << " lines on " << workers
+         << (workers == 1 ? " thread in " : " threads in ") << fixed << setprecision(3) << milliseconds << " ms: "
+         << setprecision(0) << files.size() / seconds << " files/s, " << lines / seconds << " lines/s"
+         << defaultfloat;
+    if (failed) cout << ", " << failed << " not compiled";
+    cout << "\n";
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,97 @@
+//g++ -std=gnu++17 main_executor.cpp executor.cpp compiler.cpp lexer.cpp parser.cpp semantic.cpp icg.cpp optimizer.cpp verifier.cpp evaluator.cpp profile.cpp thread_pool.cpp codegen.cpp bytecode.cpp runtime_io.cpp runtime_string.cpp interpreter.cpp -pthread -o executor.exe
+
+// .\executor.exe [-O0|-O1|-O2|-O3] [--threads=N] [--max-instructions=N] [--max-memory=BYTES]
+//                [--max-output=BYTES] [--show-output] FILE...
+//
+// Runs every FILE at once, each under the same limits, and reports how each
+// run ended. A file holds a program, optionally followed by a line with `#`
+// and the input its `san` calls read.
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "compiler.h"
+#include "executor.h"
+using namespace std;
+
+int main(int argc, char* argv[]) {
+    OptimizerOptions options;
+    ExecutionLimits limits;
+    unsigned threads = 0;
+    bool showOutput = false;
+    vector<string> files;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg.size() == 3 && arg.compare(0, 2, "-O") == 0 && arg[2] >= '0' && arg[2] <= '3') {
+            options.level = arg[2] - '0';
+        } else if (arg.rfind("--threads=", 0) == 0) {
+            threads = atoi(arg.c_str() + 10);
+        } else if (arg.rfind("--max-instructions=", 0) == 0) {
+            limits.instructions = atol(arg.c_str() + 19);
+        } else if (arg.rfind("--max-memory=", 0) == 0) {
+            limits.memory = strtoul(arg.c_str() + 13, nullptr, 10);
+        } else if (arg.rfind("--max-output=", 0) == 0) {
+            limits.output = strtoul(arg.c_str() + 13, nullptr, 10);
+        } else if (arg == "--show-output") {
+            showOutput = true;
+        } else if (arg.rfind("--", 0) == 0) {
+            cerr << "Unknown option: " << arg << endl;
+            return 1;
+        } else {
+            files.push_back(arg);
+        }
+    }
+
+    // --- Compilation, one file after another ---
+    vector<ExecutionJob> jobs;
+    int failed = 0;
+    for (const string& file : files) {
+        ifstream in(file);
+        if (!in) {
+            cout << file << ": cannot be read\n";
+            failed++;
+            continue;
+        }
+        stringstream text;
+        text << in.rdbuf();
+        InputReader reader(text.str());
+        string code = readSource(reader), line, input;
+        while (reader.readLine(line)) input += line + "\n";
+
+        Compiler compiler(options);
+        if (!compiler.compile(code, STAGE_OPTIMIZER)) {
+            cout << file << ": not compiled\n";
+            for (const string& error : compiler.getErrors()) cout << "  " << error << "\n";
+            failed++;
+            continue;
+        }
+        auto program = make_shared<const PreparedProgram>(compiler.getOptimized());
+        jobs.push_back({file, program, input});
+    }
+
+    // --- Execution, all at once ---
+    ProgramExecutor executor(limits, threads);
+    auto start = chrono::steady_clock::now();
+    vector<RunResult> results = executor.run(jobs);
+    double milliseconds = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    int ok = 0;
+    for (const RunResult& result : results) {
+        cout << result.name << ": " << runStatusName(result.status) << ", " << result.steps << " instructions, "
+             << fixed << setprecision(3) << result.milliseconds << " ms" << defaultfloat << "\n";
+        if (!result.error.empty()) cout << "  " << result.error << "\n";
+        if (showOutput) cout << result.output;
+        if (result.status == RUN_OK) ok++;
+    }
+    cout << "\n" << results.size() << " programs on " << executor.size()
+         << (executor.size() == 1 ? " thread in " : " threads in ") << fixed
+         << setprecision(3) << milliseconds << " ms: " << ok << " finished, " << results.size() - ok
+         << " stopped" << defaultfloat;
+    if (failed) cout << ", " << failed << " not compiled";
+    cout << "\n";
+    return ok == (int)results.size() && !failed ? 0 : 1;
+}
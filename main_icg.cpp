@@ -1,49 +1,34 @@
-#include "lexer.h"
-#include "utils.h"
-#include "parser.h"
-#include "semantic.h"
-#include "icg.h"
-#include <iostream>
-
-using namespace std;
-
-int main() {
-    cout << "Enter your source code (end with # on a new line):\n";
-    string line, code;
-    while (getline(cin, line)) {
-        if (line == "#") break;
-        code += line + "\n";
-    }
-
-    vector<Token> tokens = tokenize(code);
-    cout << "\n--- Tokens ---\n";
-    printTokens(tokens);
-
-    Parser parser(tokens);
-    ParseNode* root = parser.parse();
-
-    if (!root) {
-        cout << "\n--- Syntax Error ---\n";
-        cout << "Parsing failed. Stopping compilation.\n";
-        return 1;
-    }
-
-    cout << "\n--- Parse Tree ---\n";
-    parser.printParseTree(root);
-
-    SemanticAnalyzer sema;
-    sema.analyze(root);
-    sema.printErrors();
-
-    if (sema.hasErrors()) {
-        cout << "\nCompilation stopped due to semantic errors.\n";
-        return 1;
-    }
-
-    IntermediateCodeGenerator icg;
-    icg.generate(root);
-    cout << "\n--- Intermediate Code ---\n";
-    icg.printInstructions();
-
-    return 0;
-}
+#include "compiler.h"
+#include <iostream>
+
+using namespace std;
+
+int main() {
+    cout << "Enter your source code (end with # on a new line):\n";
+    InputReader input;
+    Compiler compiler;
+    compiler.compile(readSource(input), STAGE_ICG);
+
+    cout << "\n--- Tokens ---\n";
+    printTokens(compiler.getTokens());
+
+    if (!compiler.getParseTree()) {
+        compiler.getParser().printErrors();
+        return 1;
+    }
+
+    cout << "\n--- Parse Tree ---\n";
+    compiler.getParser().printParseTree(compiler.getParseTree());
+
+    compiler.getSemantic().printErrors();
+
+    if (compiler.hasErrors()) {
+        cout << "\nCompilation stopped due to semantic errors.\n";
+        return 1;
+    }
+
+    cout << "\n--- Intermediate Code ---\n";
+    compiler.getICG().printInstructions();
+
+    return 0;
+}
@@ -1,21 +1,16 @@
-// main_lexer.cpp
-#include "lexer.h"
-#include <iostream>
-#include <fstream>
-using namespace std;
-
-int main() {
-    string sourceCode;
-    cout << "Enter your source code (end with # on a new line):" << endl;
-    string line;
-    while (getline(cin, line)) {
-        if (line == "#") break;
-        sourceCode += line + "\n";
-    }
-
-    vector<Token> tokens = tokenize(sourceCode);
-    cout << "\n--- Tokens ---\n";
-    printTokens(tokens);
-
-    return 0;
-}
+// main_lexer.cpp
+#include "compiler.h"
+#include <iostream>
+using namespace std;
+
+int main() {
+    cout << "Enter your source code (end with # on a new line):" << endl;
+    InputReader input;
+    Compiler compiler;
+    compiler.compile(readSource(input), STAGE_LEXER);
+
+    cout << "\n--- Tokens ---\n";
+    printTokens(compiler.getTokens());
+
+    return 0;
+}
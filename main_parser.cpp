@@ -1,31 +1,28 @@
-// main_syntax.cpp
-#include "lexer.h"
-#include "parser.h"
-#include <iostream>
-#include <sstream>
-
-using namespace std;
-
-int main() {
-    cout << "Enter your source code (end with # on a new line):\n";
-    string line, sourceCode;
-    while (getline(cin, line)) {
-        if (line == "#") break;
-        sourceCode += line + "\n";
-    }
-
-    // Lexical Analysis
-    vector<Token> tokens = tokenize(sourceCode);
-    cout << "\n--- Tokens ---\n";
-    printTokens(tokens);
-
-    // Syntax Analysis
-    cout << "\n--- Syntax Analysis ---\n";
-    Parser parser(tokens);
-    ParseNode* root = parser.parse();
-
-    cout << "\n--- Parse Tree ---\n";
-    parser.printParseTree(root);
-
-    return 0;
-}
+// main_syntax.cpp
+#include "compiler.h"
+#include <iostream>
+
+using namespace std;
+
+int main() {
+    cout << "Enter your source code (end with # on a new line):\n";
+    InputReader input;
+    Compiler compiler;
+    compiler.compile(readSource(input), STAGE_PARSER);
+
+    // Lexical Analysis
+    cout << "\n--- Tokens ---\n";
+    printTokens(compiler.getTokens());
+
+    // Syntax Analysis
+    cout << "\n--- Syntax Analysis ---\n";
+    if (compiler.hasErrors()) {
+        compiler.getParser().printErrors();
+        return 1;
+    }
+
+    cout << "\n--- Parse Tree ---\n";
+    compiler.getParser().printParseTree(compiler.getParseTree());
+
+    return 0;
+}
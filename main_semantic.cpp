@@ -1,31 +1,23 @@
-// main_semantic.cpp
-#include <iostream>
-#include "lexer.h"
-#include "parser.h"
-#include "semantic.h"
-
-int main() {
-    cout << "Enter your source code (end with # on a new line):\n";
-    string line, code;
-    while (getline(cin, line)) {
-        if (line == "#") break;
-        code += line + "\n";
-    }
-
-    vector<Token> tokens = tokenize(code);
-    cout << "\n--- Tokens ---\n";
-    printTokens(tokens);
-
-    Parser parser(tokens);
-    ParseNode* root = parser.parse();
-
-    if (root) {
-        cout << "\n--- Parse Tree ---\n";
-        parser.printParseTree(root);
-        SemanticAnalyzer sema;
-        sema.analyze(root);
-        sema.printErrors();
-    }
-
-    return 0;
-}
+// main_semantic.cpp
+#include <iostream>
+#include "compiler.h"
+
+int main() {
+    cout << "Enter your source code (end with # on a new line):\n";
+    InputReader input;
+    Compiler compiler;
+    compiler.compile(readSource(input), STAGE_SEMANTIC);
+
+    cout << "\n--- Tokens ---\n";
+    printTokens(compiler.getTokens());
+
+    if (compiler.getParseTree()) {
+        cout << "\n--- Parse Tree ---\n";
+        compiler.getParser().printParseTree(compiler.getParseTree());
+        compiler.getSemantic().printErrors();
+    } else {
+        compiler.getParser().printErrors();
+    }
+
+    return 0;
+}
@@ -1,55 +1,1406 @@
-#include "icg.h"
-#include "optimizer.h"
-#include <sstream>
-#include <unordered_map>
-#include <iostream>
-
-bool Optimizer::isNumber(const string& s) {
-    if (s.empty()) return false;
-    for (char c : s) {
-        if (!isdigit(c)) return false;
-    }
-    return true;
-}
-
-void Optimizer::constantFolding(vector<Instruction>& instructions) {
-    for (auto& instr : instructions) {
-        if (isNumber(instr.arg1) && isNumber(instr.arg2)) {
-            int a = stoi(instr.arg1);
-            int b = stoi(instr.arg2);
-            int res = 0;
-
-            if (instr.op == "+") res = a + b;
-            else if (instr.op == "-") res = a - b;
-            else if (instr.op == "*") res = a * b;
-            else if (instr.op == "/") res = b != 0 ? a / b : 0;
-            else continue;
-
-            instr.arg1 = to_string(res);
-            instr.op = "";
-            instr.arg2 = "";
-        }
-    }
-}
-
-void Optimizer::constantPropagation(vector<Instruction>& instructions) {
-    unordered_map<string, string> constants;
-
-    for (auto& instr : instructions) {
-        if (instr.op.empty() && isNumber(instr.arg1)) {
-            constants[instr.result] = instr.arg1;
-        } else {
-            if (constants.count(instr.arg1)) instr.arg1 = constants[instr.arg1];
-            if (constants.count(instr.arg2)) instr.arg2 = constants[instr.arg2];
-        }
-    }
-}
-
-vector<Instruction> Optimizer::optimize(const vector<Instruction>& icgInstructions) {
-    vector<Instruction> optimized = icgInstructions;
-
-    constantFolding(optimized);
-    constantPropagation(optimized);
-
-    return optimized;
-}
+#include "icg.h"
+#include "optimizer.h"
+#include "verifier.h"
+#include "evaluator.h"
+#include <sstream>
+#include <unordered_map>
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <iomanip>
+#include <iostream>
+
+// Largest unroll factor chosen from a profiled trip count.
+static const int MAX_PROFILE_UNROLL = 16;
+// An arm is cold when the other side of its branch ran this many times more often.
+static const long COLD_RATIO = 8;
+
+Optimizer::Optimizer(const OptimizerOptions& options) : options(options) {
+    if (!options.profilePath.empty()) {
+        hasProfile = profile.load(options.profilePath);
+        if (!hasProfile) cerr << "Could not read profile " << options.profilePath << endl;
+    }
+    unsigned threads = options.threads > 0 ? options.threads : thread::hardware_concurrency();
+    if (options.level >= 1 && threads > 1) pool.reset(new ThreadPool(threads - 1));  // the calling thread works too
+    buildPipeline();
+}
+
+bool Optimizer::isNumber(const string& s) {
+    return !s.empty() && s[0] != '-' && isIntLiteral(s);
+}
+
+bool Optimizer::isJump(const Instruction& instr) {
+    return instr.op == "goto" || instr.op == "ifFalse" ||
+           instr.op == "jumptable" || instr.op == "case";
+}
+
+string Optimizer::newLabel() {
+    return "L" + to_string(labelCount++);
+}
+
+// A new label standing in for `origin`, named after it so that profiles
+// attribute its counts to the original (see Profile).
+string Optimizer::newLabel(const string& origin, const string& tag) {
+    return Profile::labelKey(origin) + "_" + tag + to_string(labelCount++);
+}
+
+string Optimizer::newTemp() {
+    return "t" + to_string(tempCount++);
+}
+
+// ---- Basic Blocks ----
+
+// Splits the code into basic blocks as [start, end) ranges. A block starts at
+// a label or after a jump; a jumptable keeps its case entries.
+vector<pair<int, int>> Optimizer::splitBlocks(const vector<Instruction>& instructions) {
+    vector<pair<int, int>> blocks;
+    int n = instructions.size();
+    int start = 0;
+    for (int i = 0; i < n; ++i) {
+        if (instructions[i].op == "label" && i > start) {
+            blocks.push_back({start, i});
+            start = i;
+        }
+        if (isJump(instructions[i]) && (i + 1 == n || instructions[i + 1].op != "case")) {
+            blocks.push_back({start, i + 1});
+            start = i + 1;
+        }
+    }
+    if (start < n) blocks.push_back({start, n});
+    return blocks;
+}
+
+// ---- Local Optimization ----
+// Everything in this section works on one basic block at a time and only
+// reads shared state, so blocks can be optimized concurrently.
+
+// Blocks per task handed to the thread pool, and the least number of blocks
+// worth distributing at all.
+static const size_t BLOCKS_PER_TASK = 32;
+static const size_t PARALLEL_MIN_BLOCKS = 128;
+
+static bool isName(const string& s) {
+    return !s.empty() && s[0] != '"' && !isIntLiteral(s);
+}
+
+static bool isCopy(const string& op) {
+    return op == "" || op == "=";
+}
+
+static bool isBinary(const string& op) {
+    return op == "+" || op == "-" || op == "*" || op == "/" || op == "%" ||
+           op == "<" || op == ">" || op == "<=" || op == ">=" || op == "==" || op == "!=";
+}
+
+static bool isCommutative(const string& op) {
+    return op == "+" || op == "*" || op == "==" || op == "!=";
+}
+
+// Folds a binary operation on two integer literals into a constant copy,
+// with the interpreter's semantics (division by zero yields 0). Results that
+// do not fit an int are left alone.
+static bool foldInstruction(Instruction& instr) {
+    if (!isBinary(instr.op) || !isIntLiteral(instr.arg1) || !isIntLiteral(instr.arg2)) return false;
+    if (instr.arg1.size() > 10 || instr.arg2.size() > 10) return false;
+    long long a = stoll(instr.arg1), b = stoll(instr.arg2);
+    long long res;
+    const string& op = instr.op;
+    if (op == "+") res = a + b;
+    else if (op == "-") res = a - b;
+    else if (op == "*") res = a * b;
+    else if (op == "/") res = b != 0 ? a / b : 0;
+    else if (op == "%") res = b != 0 ? a % b : 0;
+    else if (op == "<") res = a < b;
+    else if (op == ">") res = a > b;
+    else if (op == "<=") res = a <= b;
+    else if (op == ">=") res = a >= b;
+    else if (op == "==") res = a == b;
+    else res = a != b;
+    if (res < INT_MIN || res > INT_MAX) return false;
+
+    instr.op = "";
+    instr.arg1 = to_string(res);
+    instr.arg2 = "";
+    return true;
+}
+
+// Local value numbering. Forwards literals and copies into later operands,
+// folds constants and turns a recomputation of an expression whose operands
+// are unchanged into a copy of the earlier result. Every definition bumps the
+// name's version; a remembered value is only valid while the versions it was
+// recorded with are current. Reads added or removed by forwarding are
+// tallied in useDelta. stringNames holds the names with sttring values, whose
+// `+` concatenates and so keeps its operand order.
+static bool numberValues(vector<Instruction>& block, unordered_map<string, int>& useDelta,
+                         const unordered_set<string>& stringNames) {
+    struct Value { string source; int version; };
+    struct Holder { string name; int version; };
+    unordered_map<string, int> version;
+    unordered_map<string, Value> values;
+    unordered_map<string, Holder> available;
+    bool changed = false;
+
+    auto versionOf = [&](const string& name) {
+        auto it = version.find(name);
+        return it == version.end() ? 0 : it->second;
+    };
+    auto lookup = [&](const string& name) -> const string* {
+        auto it = values.find(name);
+        if (it == values.end()) return nullptr;
+        const Value& value = it->second;
+        if (isName(value.source) && versionOf(value.source) != value.version) return nullptr;
+        return &value.source;
+    };
+    auto forward = [&](string& arg, bool literalOnly) {
+        const string* source = lookup(arg);
+        if (!source || (literalOnly && !isIntLiteral(*source))) return;
+        useDelta[arg]--;
+        if (isName(*source)) useDelta[*source]++;
+        arg = *source;
+        changed = true;
+    };
+    auto define = [&](const string& name) {
+        version[name]++;
+        values.erase(name);
+    };
+    auto isString = [&](const string& token) { return isStringLiteral(token) || stringNames.count(token); };
+
+    for (auto& instr : block) {
+        const string& op = instr.op;
+        if (isCopy(op) || isBinary(op)) {
+            forward(instr.arg1, false);
+            if (isBinary(op)) forward(instr.arg2, false);
+        } else if (op == "ifFalse" || op == "jumptable" || op == "bounds") {
+            forward(instr.arg1, false);
+        } else if (op == "load") {
+            forward(instr.arg2, false);
+        } else if (op == "store") {
+            forward(instr.arg1, false);
+            forward(instr.arg2, false);
+        } else if (op == "print") {
+            // print shows the name itself when it was never assigned
+            forward(instr.arg1, true);
+        }
+        if (foldInstruction(instr)) changed = true;
+        if (!writesResult(instr)) continue;
+
+        const string result = instr.result;
+        if (isCopy(instr.op)) {
+            string source = instr.arg1;
+            define(result);
+            if (source != result && (isIntLiteral(source) || isName(source)))
+                values[result] = {source, versionOf(source)};
+            continue;
+        }
+        if (!isBinary(instr.op)) {
+            define(result);
+            continue;
+        }
+
+        string a = instr.arg1, b = instr.arg2;
+        if (isCommutative(instr.op) && b < a && !(instr.op == "+" && (isString(a) || isString(b)))) swap(a, b);
+        string key = instr.op + " " + a + "#" + to_string(versionOf(a)) + " " +
+                     b + "#" + to_string(versionOf(b));
+        auto it = available.find(key);
+        if (it != available.end() && it->second.name != result &&
+            versionOf(it->second.name) == it->second.version) {
+            string holder = it->second.name;
+            useDelta[instr.arg1]--;
+            useDelta[instr.arg2]--;
+            useDelta[holder]++;
+            instr = {"=", holder, "", result, instr.line};
+            define(result);
+            values[result] = {holder, versionOf(holder)};
+            changed = true;
+            continue;
+        }
+        define(result);
+        available[key] = {result, versionOf(result)};
+    }
+    return changed;
+}
+
+// Algebraic identities, self copies, branches on constants, dead
+// assignments, and merging "t = expr; x = t" into "x = expr" when that copy
+// is t's only use.
+static bool peephole(vector<Instruction>& block, const unordered_map<string, int>& uses,
+                     const unordered_map<string, int>& useDelta) {
+    auto useCount = [&](const string& name) {
+        auto it = uses.find(name);
+        auto delta = useDelta.find(name);
+        return (it == uses.end() ? 0 : it->second) + (delta == useDelta.end() ? 0 : delta->second);
+    };
+    vector<Instruction> out;
+    out.reserve(block.size());
+    bool changed = false;
+
+    for (auto instr : block) {
+        const string& op = instr.op;
+        if (op == "+" || op == "-" || op == "*" || op == "/") {
+            bool commutes = op == "+" || op == "*";
+            string unit = op == "+" || op == "-" ? "0" : "1";
+            if (instr.arg2 == unit || (commutes && instr.arg1 == unit)) {
+                instr = {"=", instr.arg2 == unit ? instr.arg1 : instr.arg2, "", instr.result, instr.line};
+                changed = true;
+            } else if (op == "*" && (instr.arg1 == "0" || instr.arg2 == "0")) {
+                instr = {"=", "0", "", instr.result, instr.line};
+                changed = true;
+            }
+        }
+
+        bool selfCopy = isCopy(instr.op) && instr.arg1 == instr.result;
+        bool dead = (isCopy(instr.op) || isBinary(instr.op) || instr.op == "load") && useCount(instr.result) == 0;
+        if (selfCopy || dead) {
+            changed = true;
+            continue;
+        }
+        if (instr.op == "ifFalse" && isIntLiteral(instr.arg1)) {
+            changed = true;
+            if (instr.arg1.find_first_not_of("-0") != string::npos) continue;
+            instr = {"goto", "", "", instr.result, instr.line};
+        }
+        if (instr.op == "=" && !out.empty()) {
+            Instruction& prev = out.back();
+            if (prev.result == instr.arg1 && writesResult(prev) &&
+                (isCopy(prev.op) || isBinary(prev.op) || prev.op == "load") && useCount(instr.arg1) == 1) {
+                prev.result = instr.result;
+                changed = true;
+                continue;
+            }
+        }
+        out.push_back(instr);
+    }
+    if (changed) block.swap(out);
+    return changed;
+}
+
+// Runs the local passes on every basic block, spread over the thread pool
+// when there are enough blocks. Blocks are optimized independently against
+// use counts taken up front and reassembled in their original order, so the
+// result does not depend on the number of threads.
+bool Optimizer::localOptimization(vector<Instruction>& instructions) {
+    unordered_map<string, int> uses;
+    for (const auto& instr : instructions) {
+        if (instr.op == "label" || instr.op == "goto" || instr.op == "case" || instr.op == "call") continue;
+        if (isName(instr.arg1)) uses[instr.arg1]++;
+        if (isName(instr.arg2)) uses[instr.arg2]++;
+        if (instr.op == "param" && instr.arg1.empty()) uses[instr.result]++;
+    }
+
+    unordered_set<string> stringNames = findStringNames(instructions);
+    vector<pair<int, int>> ranges = splitBlocks(instructions);
+    vector<vector<Instruction>> blocks(ranges.size());
+    vector<char> changed(ranges.size(), 0);
+    auto optimizeBlocks = [&](size_t begin, size_t end) {
+        for (size_t b = begin; b < end; ++b) {
+            vector<Instruction>& block = blocks[b];
+            block.assign(instructions.begin() + ranges[b].first, instructions.begin() + ranges[b].second);
+            unordered_map<string, int> useDelta;
+            bool blockChanged = numberValues(block, useDelta, stringNames);
+            blockChanged |= peephole(block, uses, useDelta);
+            changed[b] = blockChanged;
+        }
+    };
+    if (pool && ranges.size() >= PARALLEL_MIN_BLOCKS) {
+        pool->parallelFor(ranges.size(), BLOCKS_PER_TASK, optimizeBlocks);
+    } else {
+        optimizeBlocks(0, ranges.size());
+    }
+
+    if (find(changed.begin(), changed.end(), 1) == changed.end()) return false;
+    vector<Instruction> result;
+    result.reserve(instructions.size());
+    for (auto& block : blocks) {
+        for (auto& instr : block) result.push_back(move(instr));
+    }
+    instructions.swap(result);
+    return true;
+}
+
+// ---- Constant Propagation ----
+
+// Replaces uses of a name by the integer literal it is assigned, when that
+// assignment is the name's only definition and dominates the use. Dominators
+// come from the Cooper-Harvey-Kennedy iteration over the basic blocks.
+bool Optimizer::constantPropagation(vector<Instruction>& instructions) {
+    int n = instructions.size();
+    unordered_map<string, int> defCount;
+    unordered_map<string, int> constantDef;
+    for (int i = 0; i < n; ++i) {
+        const auto& instr = instructions[i];
+        if (!writesResult(instr)) continue;
+        defCount[instr.result]++;
+        if (isCopy(instr.op) && isIntLiteral(instr.arg1)) constantDef[instr.result] = i;
+    }
+    for (auto it = constantDef.begin(); it != constantDef.end();) {
+        it = defCount[it->first] > 1 ? constantDef.erase(it) : next(it);
+    }
+    if (constantDef.empty()) return false;
+
+    vector<pair<int, int>> blocks = splitBlocks(instructions);
+    int blockCount = blocks.size();
+    vector<int> blockOf(n);
+    unordered_map<string, int> labelBlock;
+    for (int b = 0; b < blockCount; ++b) {
+        for (int i = blocks[b].first; i < blocks[b].second; ++i) blockOf[i] = b;
+        if (instructions[blocks[b].first].op == "label") labelBlock[instructions[blocks[b].first].result] = b;
+    }
+
+    vector<vector<int>> succs(blockCount), preds(blockCount);
+    for (int b = 0; b < blockCount; ++b) {
+        bool fallsThrough = true;
+        for (int i = blocks[b].first; i < blocks[b].second; ++i) {
+            const auto& instr = instructions[i];
+            if (!isJump(instr)) continue;
+            if (labelBlock.count(instr.result)) succs[b].push_back(labelBlock[instr.result]);
+            if (instr.op != "ifFalse") fallsThrough = false;
+        }
+        if (fallsThrough && b + 1 < blockCount) succs[b].push_back(b + 1);
+        for (int s : succs[b]) preds[s].push_back(b);
+    }
+
+    // reverse postorder from the entry block
+    vector<int> order;
+    vector<int> rpoIndex(blockCount, -1);
+    vector<char> visited(blockCount, 0);
+    vector<pair<int, size_t>> stack = {{0, 0}};
+    visited[0] = 1;
+    while (!stack.empty()) {
+        auto& top = stack.back();
+        if (top.second < succs[top.first].size()) {
+            int s = succs[top.first][top.second++];
+            if (!visited[s]) {
+                visited[s] = 1;
+                stack.push_back({s, 0});
+            }
+        } else {
+            order.push_back(top.first);
+            stack.pop_back();
+        }
+    }
+    reverse(order.begin(), order.end());
+    for (int k = 0; k < (int)order.size(); ++k) rpoIndex[order[k]] = k;
+
+    vector<int> idom(blockCount, -1);
+    idom[0] = 0;
+    auto intersect = [&](int a, int b) {
+        while (a != b) {
+            while (rpoIndex[a] > rpoIndex[b]) a = idom[a];
+            while (rpoIndex[b] > rpoIndex[a]) b = idom[b];
+        }
+        return a;
+    };
+    for (bool moved = true; moved;) {
+        moved = false;
+        for (int k = 1; k < (int)order.size(); ++k) {
+            int b = order[k];
+            int dom = -1;
+            for (int p : preds[b]) {
+                if (idom[p] == -1) continue;
+                dom = dom == -1 ? p : intersect(p, dom);
+            }
+            if (dom != idom[b]) {
+                idom[b] = dom;
+                moved = true;
+            }
+        }
+    }
+
+    // preorder intervals on the dominator tree: a dominates b iff b's
+    // interval lies inside a's
+    vector<vector<int>> children(blockCount);
+    for (int b : order) {
+        if (b != 0) children[idom[b]].push_back(b);
+    }
+    vector<int> enter(blockCount, -1), leave(blockCount, -1);
+    int clock = 0;
+    vector<pair<int, size_t>> walk = {{0, 0}};
+    enter[0] = clock++;
+    while (!walk.empty()) {
+        auto& top = walk.back();
+        if (top.second < children[top.first].size()) {
+            int child = children[top.first][top.second++];
+            enter[child] = clock++;
+            walk.push_back({child, 0});
+        } else {
+            leave[top.first] = clock++;
+            walk.pop_back();
+        }
+    }
+    auto dominates = [&](int def, int use) {
+        int a = blockOf[def], b = blockOf[use];
+        if (enter[b] == -1) return false;
+        if (a == b) return def < use;
+        return enter[a] < enter[b] && leave[b] < leave[a];
+    };
+
+    bool changed = false;
+    auto replace = [&](string& arg, int use) {
+        auto it = constantDef.find(arg);
+        if (it == constantDef.end() || !dominates(it->second, use)) return;
+        arg = instructions[it->second].arg1;
+        changed = true;
+    };
+    for (int i = 0; i < n; ++i) {
+        auto& instr = instructions[i];
+        if (instr.op == "label" || instr.op == "goto" || instr.op == "case" || instr.op == "call") continue;
+        bool marker = instr.op == "parallel" || instr.op == "reduce";  // arg1 names a variable
+        if (!instr.arg1.empty() && !marker) replace(instr.arg1, i);
+        if (!instr.arg2.empty()) replace(instr.arg2, i);
+    }
+    return changed;
+}
+
+vector<Loop> Optimizer::findLoops(const vector<Instruction>& instructions) {
+    unordered_map<string, int> labelIndex;
+    unordered_map<string, vector<int>> jumpsTo;
+    for (int i = 0; i < (int)instructions.size(); ++i) {
+        const auto& instr = instructions[i];
+        if (instr.op == "label") labelIndex[instr.result] = i;
+        else if (isJump(instr)) jumpsTo[instr.result].push_back(i);
+    }
+
+    // A jump to an earlier label is a back edge; the loop extends to the last one.
+    vector<Loop> candidates;
+    for (const auto& entry : jumpsTo) {
+        auto it = labelIndex.find(entry.first);
+        if (it == labelIndex.end()) continue;
+        int last = *max_element(entry.second.begin(), entry.second.end());
+        if (last > it->second) {
+            candidates.push_back({entry.first, it->second, last, -1, 1});
+        }
+    }
+    sort(candidates.begin(), candidates.end(),
+         [](const Loop& a, const Loop& b) { return a.start < b.start; });
+
+    vector<Loop> loops;
+    vector<int> open;
+    for (auto& loop : candidates) {
+        // Only the start label may be the target of a jump from outside.
+        bool singleEntry = true;
+        for (int i = loop.start + 1; i <= loop.end && singleEntry; ++i) {
+            if (instructions[i].op != "label") continue;
+            for (int src : jumpsTo[instructions[i].result]) {
+                if (src < loop.start || src > loop.end) {
+                    singleEntry = false;
+                    break;
+                }
+            }
+        }
+        if (!singleEntry) continue;
+
+        while (!open.empty() && loops[open.back()].end < loop.start) open.pop_back();
+        if (!open.empty()) {
+            if (loop.end > loops[open.back()].end) continue;  // overlaps, not nested
+            loop.parent = open.back();
+            loop.depth = loops[open.back()].depth + 1;
+        }
+        open.push_back(loops.size());
+        loops.push_back(loop);
+    }
+    return loops;
+}
+
+// ---- Loop-Invariant Code Motion ----
+//
+// Side-effect-free instructions whose operands are not modified inside a loop
+// are moved into a preheader placed just before the loop's start label. The
+// hoisted instruction must be the only definition of its result and must
+// dominate every use, all of which lie inside the loop. Division is only
+// hoisted when it runs before the loop's first branch, or by a non-zero constant.
+bool Optimizer::loopInvariantCodeMotion(vector<Instruction>& instructions) {
+    auto isLiteral = [](const string& s) {
+        return s.empty() || s[0] == '"' || isIntLiteral(s);
+    };
+    auto isHoistable = [](const string& op) {
+        return op == "" || op == "=" || op == "+" || op == "-" || op == "*" ||
+               op == "/" || op == "%" || op == "<" || op == ">" || op == "<=" ||
+               op == ">=" || op == "==" || op == "!=";
+    };
+
+    bool hoistedAny = false;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        vector<Loop> loops = findLoops(instructions);
+        if (loops.empty()) break;
+
+        int n = instructions.size();
+        unordered_map<string, int> defCount, firstUse, lastUse;
+        unordered_map<string, vector<int>> jumpsTo;
+        vector<int> labelsBefore(n + 1, 0);
+        for (int i = 0; i < n; ++i) {
+            const auto& instr = instructions[i];
+            labelsBefore[i + 1] = labelsBefore[i] + (instr.op == "label");
+            if (isJump(instr)) jumpsTo[instr.result].push_back(i);
+            if (writesResult(instr)) defCount[instr.result]++;
+            if (instr.op == "label" || instr.op == "goto") continue;
+            for (const string* arg : {&instr.arg1, &instr.arg2}) {
+                if (isLiteral(*arg)) continue;
+                if (!firstUse.count(*arg)) firstUse[*arg] = i;
+                lastUse[*arg] = i;
+            }
+        }
+
+        // Innermost loops first, so values can climb one level per round.
+        vector<int> order(loops.size());
+        for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+        stable_sort(order.begin(), order.end(),
+                    [&](int a, int b) { return loops[a].depth > loops[b].depth; });
+
+        vector<bool> hoisted(n, false);
+        vector<vector<Instruction>> preheader(n);
+        for (int li : order) {
+            const Loop& loop = loops[li];
+            unordered_map<string, int> defsInLoop;
+            int branchFree = loop.end;
+            for (int i = loop.start + 1; i <= loop.end; ++i) {
+                const auto& instr = instructions[i];
+                if (writesResult(instr)) defsInLoop[instr.result]++;
+                if (branchFree == loop.end && (instr.op == "label" || isJump(instr))) branchFree = i;
+            }
+
+            // earliestJump[k]: first jump source landing in (start + k, end]; an
+            // instruction at i dominates the rest of the loop if that is after i.
+            vector<int> earliestJump(loop.end - loop.start + 2, n);
+            for (int i = loop.end; i > loop.start; --i) {
+                int k = i - loop.start;
+                earliestJump[k] = earliestJump[k + 1];
+                if (instructions[i].op != "label") continue;
+                for (int src : jumpsTo[instructions[i].result]) {
+                    earliestJump[k] = min(earliestJump[k], src);
+                }
+            }
+
+            auto invariant = [&](const string& arg) {
+                return isLiteral(arg) || defsInLoop[arg] == 0;
+            };
+
+            for (int i = loop.start + 1; i < loop.end; ++i) {
+                const auto& instr = instructions[i];
+                if (hoisted[i] || !isHoistable(instr.op) || instr.result.empty()) continue;
+                if (defCount[instr.result] != 1) continue;
+                if (!invariant(instr.arg1) || !invariant(instr.arg2)) continue;
+                if (firstUse.count(instr.result)) {
+                    int first = firstUse[instr.result], last = lastUse[instr.result];
+                    if (first <= i || last > loop.end) continue;
+                    bool dominatesUses = labelsBefore[last + 1] == labelsBefore[i + 1] ||
+                                         earliestJump[i - loop.start + 1] > i;
+                    if (!dominatesUses) continue;
+                }
+                if ((instr.op == "/" || instr.op == "%") && i > branchFree &&
+                    !(isNumber(instr.arg2) && instr.arg2.find_first_not_of('0') != string::npos)) continue;
+
+                hoisted[i] = true;
+                preheader[loop.start].push_back(instr);
+                defsInLoop[instr.result]--;
+                changed = true;
+            }
+        }
+        if (!changed) break;
+        hoistedAny = true;
+
+        // Jumps to the loop from outside must also pass through the preheader.
+        vector<string> entryLabel(n);
+        for (const auto& loop : loops) {
+            if (preheader[loop.start].empty()) continue;
+            for (int src : jumpsTo[loop.label]) {
+                if (src >= loop.start && src <= loop.end) continue;
+                if (entryLabel[loop.start].empty()) entryLabel[loop.start] = newLabel();
+                instructions[src].result = entryLabel[loop.start];
+            }
+        }
+
+        vector<Instruction> result;
+        result.reserve(n);
+        for (int i = 0; i < n; ++i) {
+            if (!entryLabel[i].empty()) result.push_back({"label", "", "", entryLabel[i]});
+            result.insert(result.end(), preheader[i].begin(), preheader[i].end());
+            if (!hoisted[i]) result.push_back(instructions[i]);
+        }
+        instructions.swap(result);
+    }
+    return hoistedAny;
+}
+
+// ---- Bounds-Check Elimination ----
+//
+// Removes `bounds i, N` checks that cannot fail. Within a block that is a
+// literal i in [0, N) or an i already checked against at most N and not
+// assigned since. Across iterations it is an i that is the induction
+// variable of an enclosing loop in the shape loopUnrolling recognizes,
+//
+//     S: t = i < n; ifFalse t goto E; ...check...; i = i + c; ...; goto S
+//
+// with a literal n <= N (n < N for `<=`). The check must come after the test
+// on every path: every write to i in the loop is an increment by a literal
+// c >= 0 placed after the check, and no jump other than those between the
+// test and the increments lands between S and the check. i enters the loop
+// as a non-negative literal: the one assigned last in the block falling into
+// S when nothing outside the loop jumps to S, otherwise every one assigned
+// outside the loop. With the increments i then never drops below 0 and,
+// bounded by the test, never wraps around.
+bool Optimizer::boundsCheckElimination(vector<Instruction>& instructions) {
+    static const long long MAX_INCREMENT = 1 << 30;
+    int n = instructions.size();
+    vector<bool> removed(n, false);
+    auto literal = [](const string& s, long long& value) {
+        if (!isIntLiteral(s) || s.size() > 10) return false;
+        value = stoll(s);
+        return true;
+    };
+
+    bool anyLeft = false;
+    for (const auto& range : splitBlocks(instructions)) {
+        unordered_map<string, long long> checked;  // index -> smallest size it passed
+        for (int i = range.first; i < range.second; ++i) {
+            const Instruction& instr = instructions[i];
+            long long size, index;
+            if (instr.op != "bounds") {
+                if (writesResult(instr)) checked.erase(instr.result);
+                continue;
+            }
+            if (!literal(instr.arg2, size)) continue;
+            if (literal(instr.arg1, index)) {
+                removed[i] = index >= 0 && index < size;
+            } else {
+                auto it = checked.find(instr.arg1);
+                if (it != checked.end() && it->second <= size) removed[i] = true;
+                else checked[instr.arg1] = size;
+            }
+            anyLeft |= !removed[i];
+        }
+    }
+
+    vector<Loop> loops = findLoops(instructions);
+    if (anyLeft && !loops.empty()) {
+        unordered_map<string, int> labelIndex;
+        unordered_map<string, vector<int>> defs, jumpsTo;
+        vector<int> jumps;
+        for (int i = 0; i < n; ++i) {
+            const Instruction& instr = instructions[i];
+            if (instr.op == "label") labelIndex[instr.result] = i;
+            if (writesResult(instr)) defs[instr.result].push_back(i);
+            if (isJump(instr)) {
+                jumps.push_back(i);
+                jumpsTo[instr.result].push_back(i);
+            }
+        }
+
+        // What each loop's test guarantees: var < limit up to index `until`.
+        struct Induction {
+            string var;
+            long long limit;
+            int until = -1;
+        };
+        vector<Induction> induction(loops.size());
+        for (size_t li = 0; li < loops.size(); ++li) {
+            const Loop& loop = loops[li];
+            int start = loop.start;
+            if (start + 2 >= loop.end) continue;
+            const Instruction& cond = instructions[start + 1];
+            const Instruction& exit = instructions[start + 2];
+            if (exit.op != "ifFalse" || exit.arg1 != cond.result) continue;
+            static const unordered_map<string, string> flipped = {{">", "<"}, {">=", "<="}};
+            string var = cond.arg1, bound = cond.arg2, rel = cond.op;
+            if (flipped.count(rel)) {
+                swap(var, bound);
+                rel = flipped.at(rel);
+            }
+            long long limit;
+            if ((rel != "<" && rel != "<=") || !isName(var) || !literal(bound, limit)) continue;
+            if (rel == "<=") limit++;
+
+            bool entered = true;  // only by falling into S
+            for (int j : jumpsTo[instructions[start].result]) entered &= j > start && j <= loop.end;
+            int entry = -1;
+            for (int j = start - 1; entered && j >= 0; --j) {
+                const Instruction& prior = instructions[j];
+                if (prior.op == "label" || isJump(prior)) break;
+                if (writesResult(prior) && prior.result == var) {
+                    entry = j;
+                    break;
+                }
+            }
+
+            int firstDef = loop.end + 1;
+            long long increments = 0;
+            bool valid = true;
+            for (int d : defs[var]) {
+                const Instruction& instr = instructions[d];
+                long long c = -1;
+                if (d <= start || d > loop.end) {
+                    if (entry < 0 || d == entry) valid &= isCopy(instr.op) && literal(instr.arg1, c) && c >= 0;
+                    continue;
+                }
+                // i = i + c, or t = i + c; i = t
+                const Instruction* add = &instr;
+                if (isCopy(instr.op) && d - 1 > start && instructions[d - 1].result == instr.arg1 &&
+                    writesResult(instructions[d - 1])) add = &instructions[d - 1];
+                if (add->op == "+" && add->arg1 == var) literal(add->arg2, c);
+                else if (add->op == "+" && add->arg2 == var) literal(add->arg1, c);
+                valid &= c >= 0;
+                increments += max(c, 0LL);
+                firstDef = min(firstDef, add == &instr ? d : d - 1);
+            }
+            if (!valid || increments > MAX_INCREMENT) continue;
+
+            // The test covers the code up to the first increment, less any
+            // part that a jump from elsewhere, the exit included, lands in.
+            int until = firstDef - 1;
+            if (!labelIndex.count(exit.result)) continue;  // a missing label falls through
+            for (int j : jumps) {
+                if (j > start + 2 && j < firstDef) continue;
+                auto it = labelIndex.find(instructions[j].result);
+                if (it != labelIndex.end() && it->second > start) until = min(until, it->second - 1);
+            }
+            induction[li] = {var, limit, until};
+        }
+
+        for (int i = 0; i < n; ++i) {
+            const Instruction& instr = instructions[i];
+            long long size;
+            if (instr.op != "bounds" || removed[i] || !literal(instr.arg2, size) || size > MAX_INCREMENT) continue;
+            for (size_t li = 0; li < loops.size() && !removed[i]; ++li) {
+                const Induction& bound = induction[li];
+                removed[i] = i > loops[li].start + 2 && i <= bound.until &&
+                             bound.var == instr.arg1 && bound.limit <= size;
+            }
+        }
+    }
+
+    if (find(removed.begin(), removed.end(), true) == removed.end()) return false;
+    vector<Instruction> result;
+    result.reserve(n);
+    for (int i = 0; i < n; ++i) {
+        if (!removed[i]) result.push_back(instructions[i]);
+    }
+    instructions.swap(result);
+    return true;
+}
+
+// ---- Jump Threading ----
+//
+// Cleans up the branch chains left by if/else and loop lowering: jumps whose
+// target block is just another jump go straight to the final target, and an
+// `ifFalse c` whose outcome is already known on the incoming path (c is false
+// on the taken edge of an earlier `ifFalse c`, true on its fall-through until
+// c is reassigned or control merges) is skipped. Adjacent labels are merged,
+// jumps to the next instruction and code after an unconditional jump are
+// deleted, and labels nothing jumps to are dropped.
+bool Optimizer::jumpThreading(vector<Instruction>& instructions) {
+    bool changedAny = false;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        int n = instructions.size();
+        unordered_map<string, int> labelIndex;
+        for (int i = 0; i < n; ++i) {
+            if (instructions[i].op == "label") labelIndex[instructions[i].result] = i;
+        }
+        // First non-label instruction of the block starting at a label.
+        auto blockHead = [&](const string& label) {
+            auto it = labelIndex.find(label);
+            if (it == labelIndex.end()) return n;
+            int i = it->second;
+            while (i < n && instructions[i].op == "label") ++i;
+            return i;
+        };
+
+        // Thread jumps through blocks that only jump again. `knownTrue` holds
+        // conditions that are non-zero on the straight-line path being scanned.
+        vector<pair<int, string>> newLabels;  // label to insert before an index
+        unordered_map<int, string> labelBefore;
+        unordered_map<string, bool> knownTrue;
+        for (int i = 0; i < n; ++i) {
+            Instruction& instr = instructions[i];
+            if (instr.op == "label") {
+                knownTrue.clear();
+                continue;
+            }
+            if (isJump(instr)) {
+                string target = instr.result;
+                bool conditionFalse = instr.op == "ifFalse";
+                for (int hops = 0; hops < n; ++hops) {
+                    int head = blockHead(target);
+                    if (head >= n) break;
+                    const Instruction& next = instructions[head];
+                    if (next.op == "goto") {
+                        if (next.result == target) break;  // self loop
+                        target = next.result;
+                    } else if (next.op == "ifFalse" && conditionFalse && next.arg1 == instr.arg1) {
+                        target = next.result;
+                    } else if (next.op == "ifFalse" && instr.op == "goto" && knownTrue.count(next.arg1)) {
+                        // Never taken on this path: continue after it.
+                        if (head + 1 < n && instructions[head + 1].op == "label") {
+                            target = instructions[head + 1].result;
+                        } else {
+                            if (!labelBefore.count(head + 1)) {
+                                labelBefore[head + 1] = newLabel();
+                                newLabels.push_back({head + 1, labelBefore[head + 1]});
+                            }
+                            target = labelBefore[head + 1];
+                            break;
+                        }
+                    } else {
+                        break;
+                    }
+                    if (target == instr.result) break;
+                }
+                if (target != instr.result) {
+                    instr.result = target;
+                    changed = true;
+                }
+                if (instr.op == "goto") knownTrue.clear();
+                else if (instr.op == "ifFalse") knownTrue[instr.arg1] = true;
+                continue;
+            }
+            if (writesResult(instr)) knownTrue.erase(instr.result);
+        }
+        if (!newLabels.empty()) {
+            vector<Instruction> result;
+            result.reserve(n + newLabels.size());
+            for (int i = 0; i < n; ++i) {
+                if (labelBefore.count(i)) result.push_back({"label", "", "", labelBefore[i]});
+                result.push_back(instructions[i]);
+            }
+            if (labelBefore.count(n)) result.push_back({"label", "", "", labelBefore[n]});
+            instructions.swap(result);
+            n = instructions.size();
+        }
+
+        // Merge runs of adjacent labels into the first one.
+        unordered_map<string, string> rename;
+        for (int i = 1; i < n; ++i) {
+            if (instructions[i].op == "label" && instructions[i - 1].op == "label") {
+                const string& first = instructions[i - 1].result;
+                rename[instructions[i].result] = rename.count(first) ? rename[first] : first;
+            }
+        }
+        for (auto& instr : instructions) {
+            if (isJump(instr) && rename.count(instr.result)) instr.result = rename[instr.result];
+        }
+
+        // Drop jumps to the next instruction and code that cannot be reached.
+        unordered_map<string, int> references;
+        vector<Instruction> result;
+        result.reserve(n);
+        for (int i = 0; i < n; ++i) {
+            const Instruction& instr = instructions[i];
+            if (instr.op == "label" && rename.count(instr.result)) {
+                changed = true;
+                continue;
+            }
+            if (instr.op == "goto" || instr.op == "ifFalse") {
+                int j = i + 1;
+                while (j < n && instructions[j].op == "label" && instructions[j].result != instr.result) ++j;
+                if (j < n && instructions[j].op == "label") {
+                    changed = true;
+                    continue;
+                }
+            }
+            result.push_back(instr);
+            if (instr.op == "goto") {
+                while (i + 1 < n && instructions[i + 1].op != "label") {
+                    ++i;
+                    changed = true;
+                }
+            }
+        }
+        for (const auto& instr : result) {
+            if (isJump(instr)) references[instr.result]++;
+        }
+        instructions.clear();
+        for (auto& instr : result) {
+            if (instr.op == "label" && !references.count(instr.result)) {
+                changed = true;
+                continue;
+            }
+            instructions.push_back(instr);
+        }
+        changedAny |= changed;
+    }
+    return changedAny;
+}
+
+// Loops that may run in parallel keep their shape; see findParallelLoop.
+static vector<ParallelLoop> parallelLoops(const vector<Instruction>& instructions) {
+    vector<ParallelLoop> loops;
+    for (int i = 0; i < (int)instructions.size(); ++i) {
+        ParallelLoop loop;
+        if (instructions[i].op == "parallel" && findParallelLoop(instructions, i, loop)) loops.push_back(loop);
+    }
+    return loops;
+}
+
+// ---- Loop Unrolling ----
+//
+// Recognizes counted loops in the shape the ICG produces for
+// `loop (i < n) { ...; i = i + c; }`:
+//
+//     S: t = i < n; ifFalse t goto E; body; t' = i + c; i = t'; goto S
+//
+// where n is a literal or loop invariant, c a literal step and the body has
+// no other exit and no other write to i. Loops with a known initial value and
+// a trip count small enough that the whole loop fits in unrollLimit
+// instructions are replaced by that many copies of the body. Otherwise the
+// body is unrolled unrollFactor times (shrunk to fit unrollLimit) ahead of the
+// original loop, which runs the remaining iterations. Loops that may run in
+// parallel are left alone.
+bool Optimizer::loopUnrolling(vector<Instruction>& instructions) {
+    auto isLiteral = [](const string& s) {
+        return s.empty() || s[0] == '"' || isIntLiteral(s);
+    };
+    auto compare = [](const string& rel, long long a, long long b) {
+        if (rel == "<") return a < b;
+        if (rel == "<=") return a <= b;
+        if (rel == ">") return a > b;
+        return a >= b;
+    };
+
+    vector<Loop> loops = findLoops(instructions);
+    vector<bool> hasInner(loops.size(), false);
+    for (const auto& loop : loops) {
+        if (loop.parent >= 0) hasInner[loop.parent] = true;
+    }
+    unordered_set<string> parallel;
+    for (const auto& loop : parallelLoops(instructions)) parallel.insert(instructions[loop.header].result);
+    unordered_map<string, int> useCount;
+    for (const auto& instr : instructions) {
+        if (instr.op == "label" || instr.op == "goto") continue;
+        if (!instr.arg1.empty()) useCount[instr.arg1]++;
+        if (!instr.arg2.empty()) useCount[instr.arg2]++;
+    }
+
+    bool changed = false;
+    // Later loops first, so rewriting one leaves the indices of the rest valid.
+    for (int li = (int)loops.size() - 1; li >= 0; --li) {
+        const Loop& loop = loops[li];
+        if (hasInner[li] || unrolledLoops.count(loop.label) || parallel.count(loop.label)) continue;
+        int start = loop.start, end = loop.end;
+        if (end - start < 5 || instructions[end].op != "goto") continue;
+
+        // Header: t = i REL n; ifFalse t goto E
+        const Instruction& cond = instructions[start + 1];
+        const Instruction& exit = instructions[start + 2];
+        if (exit.op != "ifFalse" || exit.arg1 != cond.result || useCount[cond.result] != 1) continue;
+        static const unordered_map<string, string> flipped = {
+            {"<", ">"}, {"<=", ">="}, {">", "<"}, {">=", "<="}};
+        if (!flipped.count(cond.op)) continue;
+        string var = cond.arg1, bound = cond.arg2, rel = cond.op;
+        if (isLiteral(var)) {
+            swap(var, bound);
+            rel = flipped.at(rel);
+        }
+        if (isLiteral(var)) continue;
+
+        // Increment: t' = i + c; i = t'   or   i = i + c
+        int incStart = end - 1;
+        const Instruction* step = &instructions[end - 1];
+        if (step->op == "=" && step->result == var && useCount[step->arg1] == 1) {
+            incStart = end - 2;
+            step = &instructions[end - 2];
+            if (step->result != instructions[end - 1].arg1) continue;
+        } else if (step->result != var) {
+            continue;
+        }
+        if (step->op != "+" && step->op != "-") continue;
+        string amount;
+        if (step->arg1 == var && isNumber(step->arg2)) amount = step->arg2;
+        else if (step->op == "+" && step->arg2 == var && isNumber(step->arg1)) amount = step->arg1;
+        if (amount.empty() || amount.size() > 9) continue;
+        long long c = stoll(amount) * (step->op == "-" ? -1 : 1);
+        if (c == 0 || ((rel == "<" || rel == "<=") != (c > 0))) continue;
+        if (incStart <= start + 3) continue;
+
+        // The body must stay inside the loop and leave i, n and t alone.
+        int bodyStart = start + 3;
+        unordered_set<string> bodyLabels;
+        for (int i = bodyStart; i < incStart; ++i) {
+            if (instructions[i].op == "label") bodyLabels.insert(instructions[i].result);
+        }
+        bool simple = true;
+        for (int i = bodyStart; i < incStart && simple; ++i) {
+            const Instruction& instr = instructions[i];
+            if (isJump(instr) && !bodyLabels.count(instr.result)) simple = false;
+            if (writesResult(instr) &&
+                (instr.result == var || instr.result == bound || instr.result == cond.result)) simple = false;
+        }
+        if (!simple) continue;
+        if (incStart == end - 2 && (instructions[incStart].result == bound)) continue;
+
+        int bodySize = end - bodyStart;  // body plus increment
+        auto copyBody = [&](vector<Instruction>& out) {
+            unordered_map<string, string> renamed;
+            for (const string& label : bodyLabels) renamed[label] = newLabel(label, "");
+            for (int i = bodyStart; i < end; ++i) {
+                Instruction instr = instructions[i];
+                if ((instr.op == "label" || isJump(instr)) && renamed.count(instr.result)) {
+                    instr.result = renamed[instr.result];
+                }
+                out.push_back(instr);
+            }
+        };
+
+        // Full unrolling needs the initial value from straight-line code before S.
+        long long trips = -1;
+        if (isNumber(bound) && bound.size() <= 9) {
+            for (int i = start - 1; i >= 0; --i) {
+                const Instruction& instr = instructions[i];
+                if (instr.op == "label" || isJump(instr)) break;
+                if (!writesResult(instr) || instr.result != var) continue;
+                if ((instr.op == "=" || instr.op.empty()) && isLiteral(instr.arg1) &&
+                    instr.arg1[0] != '"' && instr.arg1.size() <= 10) {
+                    long long v = stoll(instr.arg1), n = stoll(bound), count = 0;
+                    long long maxTrips = options.unrollLimit / bodySize;
+                    while (compare(rel, v, n) && count <= maxTrips) {
+                        v += c;
+                        count++;
+                    }
+                    if (count <= maxTrips) trips = count;
+                }
+                break;
+            }
+        }
+
+        vector<Instruction> replacement;
+        if (trips >= 0) {
+            for (long long k = 0; k < trips; ++k) copyBody(replacement);
+        } else {
+            // A measured trip count overrides the default factor: unroll by the
+            // largest power of two that whole iterations usually cover.
+            int factor = options.unrollFactor;
+            auto measured = profile.loops.find(Profile::labelKey(loop.label));
+            if (hasProfile && measured != profile.loops.end() && measured->second.entries > 0) {
+                long average = measured->second.trips / measured->second.entries;
+                factor = 1;
+                while (factor < MAX_PROFILE_UNROLL && factor * 2 <= average) factor *= 2;
+            }
+            factor = min(factor, options.unrollLimit / bodySize);
+            if (factor < 2) continue;
+
+            // All `factor` iterations run iff the last one would: i + (factor-1)c REL n.
+            string limit = newTemp(), check = newTemp();
+            string header = newLabel(loop.label, "x" + to_string(factor) + "_");
+            long long offset = (factor - 1) * c;
+            int line = cond.line;
+            replacement.push_back({offset > 0 ? "-" : "+", bound, to_string(offset > 0 ? offset : -offset), limit, line});
+            replacement.push_back({"label", "", "", header, line});
+            replacement.push_back({rel, var, limit, check, line});
+            replacement.push_back({"ifFalse", check, "", loop.label, line});
+            for (int k = 0; k < factor; ++k) copyBody(replacement);
+            replacement.push_back({"goto", "", "", header, line});
+            replacement.insert(replacement.end(), instructions.begin() + start,
+                               instructions.begin() + end + 1);
+            unrolledLoops.insert(header);
+        }
+        unrolledLoops.insert(loop.label);
+
+        instructions.erase(instructions.begin() + start, instructions.begin() + end + 1);
+        instructions.insert(instructions.begin() + start, replacement.begin(), replacement.end());
+        changed = true;
+    }
+    return changed;
+}
+
+// ---- Partial Evaluation ----
+//
+// Runs the program in a PartialEvaluator until it needs the outside world,
+// exhausts its step budget or has produced enough output. The executed prefix
+// is replaced by its printed output and the final values of the variables the
+// rest of the program reads, followed by a jump to where evaluation stopped.
+// The prefix itself stays only if later code can jump back into it.
+bool Optimizer::partialEvaluation(vector<Instruction>& instructions) {
+    PartialEvaluator evaluator(options.evalBudget, options.evalOutputLimit);
+    evaluator.evaluate(instructions);
+    int n = instructions.size();
+    int stop = evaluator.getStopIndex();
+    if (evaluator.getSteps() == 0) return false;
+
+    unordered_set<string> prefixLabels;
+    for (int i = 0; i < stop; ++i) {
+        if (instructions[i].op == "label") prefixLabels.insert(instructions[i].result);
+    }
+    bool keepPrefix = false;
+    for (int i = stop; i < n && !keepPrefix; ++i) {
+        keepPrefix = isJump(instructions[i]) && prefixLabels.count(instructions[i].result);
+    }
+
+    unordered_set<string> referenced;
+    for (int i = keepPrefix ? 0 : stop; i < n; ++i) {
+        const Instruction& instr = instructions[i];
+        referenced.insert(instr.arg1);
+        referenced.insert(instr.arg2);
+        if (instr.op == "param") referenced.insert(instr.result);
+    }
+
+    // array declarations stay at the start
+    vector<Instruction> result;
+    for (int i = 0; i < stop; ++i) {
+        if (instructions[i].op == "array") result.push_back(instructions[i]);
+    }
+    for (const string& line : evaluator.getOutput()) {
+        result.push_back({"print", line, "", ""});
+    }
+    for (const auto& var : evaluator.getVariables()) {
+        if (referenced.count(var.first)) {
+            result.push_back({"=", to_string(var.second), "", var.first});
+        }
+    }
+    if (keepPrefix) {
+        string resume = newLabel();
+        result.push_back({"goto", "", "", resume});
+        for (int i = 0; i < stop; ++i) {
+            if (instructions[i].op != "array") result.push_back(instructions[i]);
+        }
+        result.push_back({"label", "", "", resume});
+    }
+    // Only worth it if fewer instructions run than were evaluated.
+    if ((long)result.size() - (keepPrefix ? stop : 0) >= evaluator.getSteps()) return false;
+
+    result.insert(result.end(), instructions.begin() + stop, instructions.end());
+    instructions.swap(result);
+    return true;
+}
+
+// ---- Profile-Guided Block Layout ----
+//
+// Uses the branch counts of an interpreter profile to keep the hot side of
+// each `ifFalse` on the fall-through path. A cold else arm is moved behind the
+// end of the program; a cold then arm is moved there too after inverting the
+// comparison that feeds the branch, so the else arm (or the code after the
+// iif) follows directly. Moved arms end with a jump back to where they would
+// have continued, and the main code jumps over them at its end unless it
+// ends in a jump or `return`. Branches in loops that may run in parallel
+// stay in place.
+bool Optimizer::blockLayout(vector<Instruction>& instructions) {
+    static const unordered_map<string, string> inverse = {
+        {"<", ">="}, {">=", "<"}, {">", "<="}, {"<=", ">"}, {"==", "!="}, {"!=", "=="}};
+    if (!hasProfile) return false;
+
+    int n = instructions.size();
+    unordered_map<string, int> labelIndex, useCount;
+    for (int i = 0; i < n; ++i) {
+        const auto& instr = instructions[i];
+        if (instr.op == "label") labelIndex[instr.result] = i;
+        if (instr.op == "label" || instr.op == "goto") continue;
+        if (!instr.arg1.empty()) useCount[instr.arg1]++;
+        if (!instr.arg2.empty()) useCount[instr.arg2]++;
+    }
+
+    vector<bool> moved(n, false);
+    vector<bool> parallel(n, false);
+    for (const auto& loop : parallelLoops(instructions)) {
+        fill(parallel.begin() + loop.header, parallel.begin() + loop.backEdge + 1, true);
+    }
+    vector<Instruction> cold;
+    auto moveOut = [&](int from, int to, const string& entry, const string& resume) {
+        if (!entry.empty()) cold.push_back({"label", "", "", entry});
+        for (int i = from; i < to; ++i) {
+            cold.push_back(instructions[i]);
+            moved[i] = true;
+        }
+        cold.push_back({"goto", "", "", resume});
+    };
+    auto anyMoved = [&](int from, int to) {
+        for (int i = from; i < to; ++i) if (moved[i]) return true;
+        return false;
+    };
+
+    for (int i = 0; i < n; ++i) {
+        Instruction& branch = instructions[i];
+        if (moved[i] || parallel[i] || branch.op != "ifFalse") continue;
+        auto counts = profile.branches.find(Profile::branchKey(branch));
+        if (counts == profile.branches.end()) continue;
+        long taken = counts->second.taken, notTaken = counts->second.notTaken;
+        auto target = labelIndex.find(branch.result);
+        if (target == labelIndex.end() || target->second <= i) continue;
+        int elseStart = target->second;
+
+        // `goto X` right before the else label, with X further down, marks an else arm.
+        int join = -1;
+        if (instructions[elseStart - 1].op == "goto") {
+            auto it = labelIndex.find(instructions[elseStart - 1].result);
+            if (it != labelIndex.end() && it->second > elseStart) join = it->second;
+        }
+
+        if (join >= 0 && taken * COLD_RATIO <= notTaken && !anyMoved(elseStart, join)) {
+            // The then arm now falls through into X; its goto is cleaned up later.
+            moveOut(elseStart, join, "", instructions[join].result);
+            continue;
+        }
+
+        Instruction* cond = i > 0 ? &instructions[i - 1] : nullptr;
+        if (notTaken * COLD_RATIO <= taken && cond && cond->result == branch.arg1 &&
+            inverse.count(cond->op) && useCount[cond->result] == 1) {
+            int thenEnd = join >= 0 ? elseStart - 1 : elseStart;
+            if (thenEnd <= i + 1 || anyMoved(i + 1, elseStart)) continue;
+            string entry = newLabel();
+            const string& resume = join >= 0 ? instructions[join].result : branch.result;
+            moveOut(i + 1, thenEnd, entry, resume);
+            if (join >= 0) moved[elseStart - 1] = true;
+            cond->op = inverse.at(cond->op);
+            branch.result = entry;
+        }
+    }
+    if (cold.empty()) return false;
+
+    vector<Instruction> result;
+    result.reserve(n + cold.size() + 2);
+    for (int i = 0; i < n; ++i) {
+        if (!moved[i]) result.push_back(instructions[i]);
+    }
+    // No jump over the moved arms is needed when the main code cannot fall into them.
+    bool fallsThrough = result.empty() || (result.back().op != "return" && result.back().op != "goto");
+    string exitLabel = fallsThrough ? newLabel() : "";
+    if (fallsThrough) result.push_back({"goto", "", "", exitLabel});
+    result.insert(result.end(), cold.begin(), cold.end());
+    if (fallsThrough) result.push_back({"label", "", "", exitLabel});
+    instructions.swap(result);
+    return true;
+}
+
+// ---- Pass Manager ----
+
+void Optimizer::buildPipeline() {
+    pipeline.clear();
+    auto add = [&](Pass pass, const string& name) {
+        PassStatistics stats;
+        stats.name = name;
+        pipeline.push_back({pass, stats});
+    };
+    if (options.level >= 1) {
+        add(&Optimizer::localOptimization, "local-optimization");
+        add(&Optimizer::constantPropagation, "constant-propagation");
+    }
+    if (options.level >= 2) {
+        add(&Optimizer::loopInvariantCodeMotion, "licm");
+        add(&Optimizer::boundsCheckElimination, "bounds-check-elim");
+    }
+    if (options.level >= 3) {
+        add(&Optimizer::loopUnrolling, "loop-unroll");
+    }
+    if (options.level >= 2) {
+        add(&Optimizer::jumpThreading, "jump-threading");
+    }
+
+    finalPasses.clear();
+    auto addFinal = [&](Pass pass, const string& name) {
+        PassStatistics stats;
+        stats.name = name;
+        finalPasses.push_back({pass, stats});
+    };
+    if (options.level >= 2 && hasProfile) {
+        addFinal(&Optimizer::blockLayout, "block-layout");
+    }
+    if (options.level >= 3 && options.evalBudget > 0) {
+        addFinal(&Optimizer::partialEvaluation, "partial-evaluation");
+    }
+}
+
+bool Optimizer::runPass(pair<Pass, PassStatistics>& pass, vector<Instruction>& instructions) {
+    PassStatistics& stats = pass.second;
+    long before = instructions.size();
+
+    auto start = chrono::steady_clock::now();
+    bool changed = (this->*pass.first)(instructions);
+    auto end = chrono::steady_clock::now();
+
+    stats.runs++;
+    if (changed) stats.changed++;
+    stats.milliseconds += chrono::duration<double, milli>(end - start).count();
+    stats.instructionDelta += (long)instructions.size() - before;
+
+    if (options.verify && !verify(instructions, "after pass '" + stats.name + "'")) return false;
+    return changed;
+}
+
+// Records the verifier's complaints about `instructions`, if any.
+bool Optimizer::verify(const vector<Instruction>& instructions, const string& where) {
+    IRVerifier verifier;
+    if (verifier.verify(instructions)) return true;
+    errors.push_back("IR verification failed " + where);
+    const vector<string>& found = verifier.getErrors();
+    errors.insert(errors.end(), found.begin(), found.end());
+    return false;
+}
+
+// Rerun the pipeline until no pass changes anything, since each pass can
+// expose work for the others (propagation creates folding candidates).
+void Optimizer::runPipeline(vector<Instruction>& instructions) {
+    for (int round = 0; round < options.maxIterations; ++round) {
+        iterations++;
+        bool changed = false;
+        for (auto& pass : pipeline) {
+            changed |= runPass(pass, instructions);
+            if (!errors.empty()) return;
+        }
+        if (!changed) break;
+    }
+}
+
+vector<Instruction> Optimizer::optimize(const vector<Instruction>& icgInstructions) {
+    vector<Instruction> optimized = icgInstructions;
+
+    labelCount = 0;
+    tempCount = 0;
+    unrolledLoops.clear();
+    for (const auto& instr : optimized) {
+        if (instr.op == "label" && instr.result.size() > 1 && instr.result[0] == 'L' &&
+            isNumber(instr.result.substr(1))) {
+            labelCount = max(labelCount, stoi(instr.result.substr(1)) + 1);
+        }
+        if (writesResult(instr) && instr.result.size() > 1 && instr.result[0] == 't' &&
+            isNumber(instr.result.substr(1))) {
+            tempCount = max(tempCount, stoi(instr.result.substr(1)) + 1);
+        }
+    }
+
+    errors.clear();
+    iterations = 0;
+    if (options.verify && !verify(optimized, "on optimizer input")) return optimized;
+
+    runPipeline(optimized);
+    for (auto& pass : finalPasses) {
+        if (!errors.empty()) break;
+        if (runPass(pass, optimized)) runPipeline(optimized);
+    }
+
+    return optimized;
+}
+
+vector<PassStatistics> Optimizer::getStatistics() const {
+    vector<PassStatistics> stats;
+    for (const auto& pass : pipeline) stats.push_back(pass.second);
+    for (const auto& pass : finalPasses) stats.push_back(pass.second);
+    return stats;
+}
+
+int Optimizer::getIterations() const {
+    return iterations;
+}
+
+bool Optimizer::hasErrors() const {
+    return !errors.empty();
+}
+
+const vector<string>& Optimizer::getErrors() const {
+    return errors;
+}
+
+void Optimizer::printStatistics() {
+    cout << "\n--- Optimizer Statistics (-O" << options.level << ", "
+         << iterations << " iteration" << (iterations == 1 ? "" : "s") << ") ---\n";
+    cout << left << setw(24) << "pass" << right << setw(6) << "runs" << setw(9) << "changed"
+         << setw(12) << "time(ms)" << setw(10) << "delta" << "\n";
+    double total = 0;
+    for (const auto& stats : getStatistics()) {
+        cout << left << setw(24) << stats.name << right << setw(6) << stats.runs
+             << setw(9) << stats.changed << setw(12) << fixed << setprecision(3)
+             << stats.milliseconds << setw(10) << showpos << stats.instructionDelta
+             << noshowpos << "\n";
+        total += stats.milliseconds;
+    }
+    cout << left << setw(39) << "total" << right << setw(12) << total << "\n";
+    cout.unsetf(ios::fixed);
+}
@@ -1,19 +1,95 @@
-#ifndef OPTIMIZER_H
-#define OPTIMIZER_H
-
-#include "icg.h"
-#include <vector>
-
-using namespace std;
-
-class Optimizer {
-public:
-    vector<Instruction> optimize(const vector<Instruction>& icgInstructions);
-
-private:
-    void constantFolding(vector<Instruction>& instructions);
-    void constantPropagation(vector<Instruction>& instructions);
-    bool isNumber(const string& s);
-};
-
-#endif
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include "icg.h"
+#include "profile.h"
+#include "thread_pool.h"
+#include <memory>
+#include <vector>
+#include <unordered_set>
+
+using namespace std;
+
+// A natural loop in the instruction stream: the region from a start label
+// to the last jump back to it, entered only through the start label.
+struct Loop {
+    string label;   // start label, target of the back edge
+    int start;      // index of the start label
+    int end;        // index of the last back-edge jump
+    int parent;     // index of the enclosing loop, -1 if outermost
+    int depth;      // nesting depth, 1 for outermost loops
+};
+
+// Pass pipeline selection. Level 0 runs nothing, 1 the block-local passes
+// and constant propagation, 2 adds the loop and control-flow passes and
+// bounds-check elimination, 3 adds loop unrolling and compile-time
+// evaluation of the input-independent part of the program.
+struct OptimizerOptions {
+    int level = 2;
+    int maxIterations = 8;   // cap on rounds of the fixed-point loop
+    bool verify = false;     // run the IR verifier after every pass
+    int unrollFactor = 4;    // copies of the body per unrolled iteration
+    int unrollLimit = 64;    // max instructions an unrolled loop body may grow to
+    long evalBudget = 1000000;     // compile-time evaluation steps, 0 disables
+    size_t evalOutputLimit = 4096; // lines of output evaluation may precompute
+    string profilePath;            // interpreter profile for block layout and unrolling
+    int threads = 0;               // workers for block-local passes, 0: one per hardware thread
+};
+
+struct PassStatistics {
+    string name;
+    int runs = 0;
+    int changed = 0;               // runs that modified the code
+    double milliseconds = 0;
+    long instructionDelta = 0;     // net instructions added (negative: removed)
+};
+
+class Optimizer {
+public:
+    Optimizer(const OptimizerOptions& options = OptimizerOptions());
+    vector<Instruction> optimize(const vector<Instruction>& icgInstructions);
+    vector<PassStatistics> getStatistics() const;
+    void printStatistics();
+    int getIterations() const;
+    bool hasErrors() const;
+    const vector<string>& getErrors() const;  // IR verification failures, which stop optimization
+
+private:
+    typedef bool (Optimizer::*Pass)(vector<Instruction>&);
+
+    OptimizerOptions options;
+    vector<pair<Pass, PassStatistics>> pipeline;
+    vector<pair<Pass, PassStatistics>> finalPasses;  // run once after the fixed point
+    int iterations = 0;
+    Profile profile;
+    bool hasProfile = false;
+    int labelCount = 0;
+    int tempCount = 0;
+    unordered_set<string> unrolledLoops;
+    unique_ptr<ThreadPool> pool;
+    vector<string> errors;
+
+    void buildPipeline();
+    bool verify(const vector<Instruction>& instructions, const string& where);
+    void runPipeline(vector<Instruction>& instructions);
+    bool runPass(pair<Pass, PassStatistics>& pass, vector<Instruction>& instructions);
+
+    bool localOptimization(vector<Instruction>& instructions);
+    bool constantPropagation(vector<Instruction>& instructions);
+    bool loopInvariantCodeMotion(vector<Instruction>& instructions);
+    bool boundsCheckElimination(vector<Instruction>& instructions);
+    bool jumpThreading(vector<Instruction>& instructions);
+    bool loopUnrolling(vector<Instruction>& instructions);
+    bool partialEvaluation(vector<Instruction>& instructions);
+    bool blockLayout(vector<Instruction>& instructions);
+
+    vector<pair<int, int>> splitBlocks(const vector<Instruction>& instructions);
+    vector<Loop> findLoops(const vector<Instruction>& instructions);
+    string newLabel();
+    string newLabel(const string& origin, const string& tag);
+    string newTemp();
+    bool isNumber(const string& s);  // an integer literal without a sign
+    bool isJump(const Instruction& instr);
+};
+
+#endif
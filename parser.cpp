@@ -1,269 +1,350 @@
-#include "parser.h"
-#include <iostream>
-
-using namespace std;
-
-Parser::Parser(const vector<Token>& tokens) : tokens(tokens), current(0) {}
-
-Token Parser::peek() {
-    return tokens[current];
-}
-
-Token Parser::advance() {
-    if (!isAtEnd()) current++;
-    return previous();
-}
-
-Token Parser::previous() {
-    return tokens[current - 1];
-}
-
-bool Parser::isAtEnd() {
-    return current >= tokens.size();
-}
-
-bool Parser::match(TokenType type, string value) {
-    if (isAtEnd()) return false;
-    Token t = peek();
-    if (t.type == type && (value.empty() || t.value == value)) {
-        advance();
-        return true;
-    }
-    return false;
-}
-
-void Parser::error(const string& message) {
-    string err = "Syntax Error: " + message + " at token: '" + peek().value + "'";
-    cerr << err << endl << flush;
-    cout << err << endl; 
-    exit(1);
-}
-
-
-// ---- Recursive Descent Parsing ----
-
-ParseNode* Parser::parse() {
-    return parseProgram();
-}
-
-ParseNode* Parser::parseProgram() {
-    if (match(KEYWORD, "intt") || match(KEYWORD, "sttring")) {
-        // optional return type
-    }
-
-    if (!match(KEYWORD, "mainn")) error("Expected 'mainn'");
-    if (!match(DELIMITER, "(")) error("Expected '(' after 'mainn'");
-    if (!match(DELIMITER, ")")) error("Expected ')' after '('");
-    if (!match(DELIMITER, "{")) error("Expected '{' after mainn()");
-
-    ParseNode* node = new ParseNode{PROGRAM_NODE, "mainn", {}};
-
-    if (!isAtEnd() && peek().value != "}") {
-        node->children.push_back(parseStmtList());
-    }
-
-    if (!match(DELIMITER, "}")) {
-        error("Expected '}' at end of mainn");
-    }
-
-    return node;
-}
-
-
-ParseNode* Parser::parseStmtList() {
-    ParseNode* node = new ParseNode{STATEMENT_NODE, "stmt_list", {}};
-    while (!isAtEnd() && peek().value != "}") {
-        node->children.push_back(parseStmt());
-    }
-    return node;
-}
-
-ParseNode* Parser::parseStmt() {
-    if (match(KEYWORD, "intt") || match(KEYWORD, "sttring")) {
-        string type = previous().value;
-        if (!match(IDENTIFIER)) error("Expected identifier after type");
-        Token id = previous();
-        ParseNode* decl = new ParseNode{DECLARATION_NODE, type + " " + id.value, {}};
-        if (match(OPERATOR, "=")) {
-            decl->children.push_back(parseExpr());
-        }
-        if (!match(DELIMITER, ";")) error("Expected ';' after declaration");
-        return decl;
-    }
-
-    if (match(IDENTIFIER)) {
-        Token id = previous();
-        if (match(OPERATOR, "=")) {
-            ParseNode* rhs = parseExpr();
-            ParseNode* assign = new ParseNode{ASSIGNMENT_NODE, id.value, {}};
-            assign->children.push_back(rhs);
-
-            if (!match(DELIMITER, ";")) error("Expected ';' after assignment");
-            return assign;
-        } else {
-            error("Expected '=' after identifier");
-        }
-    }
-
-
-    if (match(KEYWORD, "retturn")) {
-        ParseNode* ret = new ParseNode{RETURN_STATEMENT_NODE, "retturn", {}};
-        if (peek().value != ";") {
-            ret->children.push_back(parseExpr());
-        }
-        if (!match(DELIMITER, ";")) error("Expected ';' after retturn");
-        return ret;
-    }
-
-    if (match(KEYWORD, "prrint") || match(KEYWORD, "san")) {
-        Token func = previous();
-        if (!match(DELIMITER, "(")) error("Expected '(' after function name");
-        ParseNode* call = new ParseNode{FUNCTION_CALL_NODE, func.value, {}};
-        if (peek().type != DELIMITER || peek().value != ")") {
-            call->children.push_back(parseExpr());
-        }
-        if (!match(DELIMITER, ")")) error("Expected ')' after args");
-        if (!match(DELIMITER, ";")) error("Expected ';' after function call");
-        return call;
-    }
-
-    if (match(KEYWORD, "iif")) {
-        ParseNode* ifNode = new ParseNode{IF_STATEMENT_NODE, "iif", {}};
-        if (!match(DELIMITER, "(")) error("Expected '(' after iif");
-        ifNode->children.push_back(parseExpr());
-        if (!match(DELIMITER, ")")) error("Expected ')' after condition");
-        if (!match(DELIMITER, "{")) error("Expected '{' after iif()");
-        ifNode->children.push_back(parseStmtList());
-        if (!match(DELIMITER, "}")) error("Expected '}' after if body");
-        if (match(KEYWORD, "ellse")) {
-            if (!match(DELIMITER, "{")) error("Expected '{' after ellse");
-            ifNode->children.push_back(parseStmtList());
-            if (!match(DELIMITER, "}")) error("Expected '}' after else body");
-        }
-        return ifNode;
-    }
-
-    if (match(KEYWORD, "loop")) {
-        ParseNode* loopNode = new ParseNode{LOOP_STATEMENT_NODE, "loop", {}};
-        if (!match(DELIMITER, "(")) error("Expected '(' after 'loop'");
-        loopNode->children.push_back(parseExpr());
-        if (!match(DELIMITER, ")")) error("Expected ')' after loop condition");
-        if (!match(DELIMITER, "{")) error("Expected '{' after loop condition");
-        loopNode->children.push_back(parseStmtList());
-        if (!match(DELIMITER, "}")) error("Expected '}' after loop body");
-        return loopNode;
-    }
-
-    if (match(KEYWORD, "brreak")) {
-        ParseNode* breakNode = new ParseNode{BREAK_STATEMENT_NODE, "brreak", {}};
-        if (!match(DELIMITER, ";")) error("Expected ';' after 'brreak'");
-        return breakNode;
-    }
-
-    if (match(KEYWORD, "conttinue")) {
-        ParseNode* continueNode = new ParseNode{CONTINUE_STATEMENT_NODE, "conttinue", {}};
-        if (!match(DELIMITER, ";")) error("Expected ';' after 'conttinue'");
-        return continueNode;
-    }
-
-    error("Unknown or invalid statement");
-    return nullptr;
-}
-
-
-// --- Expression Parsing ---
-
-ParseNode* Parser::parseExpr() {
-    return parseLogic();  
-}
-
-ParseNode* Parser::parseLogic() {
-    ParseNode* node = parseComparison();
-    while (match(OPERATOR, "&&") || match(OPERATOR, "||")) {
-        string op = previous().value;
-        ParseNode* newNode = new ParseNode{EXPRESSION_NODE, op, {node}};
-        newNode->children.push_back(parseComparison());
-        node = newNode;
-    }
-    return node;
-}
-
-ParseNode* Parser::parseComparison() {
-    ParseNode* node = parseTerm();
-    while (match(OPERATOR, "==") || match(OPERATOR, "!=") ||
-           match(OPERATOR, "<") || match(OPERATOR, "<=") ||
-           match(OPERATOR, ">") || match(OPERATOR, ">=")) {
-        string op = previous().value;
-        ParseNode* newNode = new ParseNode{EXPRESSION_NODE, op, {node}};
-        newNode->children.push_back(parseTerm());
-        node = newNode;
-    }
-    return node;
-}
-
-ParseNode* Parser::parseTerm() {
-    ParseNode* node = parseFactor();
-    while (match(OPERATOR, "+") || match(OPERATOR, "-")) {
-        string op = previous().value;
-        ParseNode* newNode = new ParseNode{EXPRESSION_NODE, op, {node}};
-        newNode->children.push_back(parseFactor());
-        node = newNode;
-    }
-    return node;
-}
-
-ParseNode* Parser::parseFactor() {
-    ParseNode* node = parsePrimary();
-    while (match(OPERATOR, "*") || match(OPERATOR, "/")) {
-        string op = previous().value;
-        ParseNode* newNode = new ParseNode{EXPRESSION_NODE, op, {node}};
-        newNode->children.push_back(parsePrimary());
-        node = newNode;
-    }
-    return node;
-}
-
-ParseNode* Parser::parsePrimary() {
-    Token t = peek();
-
-    if (match(NUMBER)) {
-        return new ParseNode{NUMBER_NODE, previous().value, {}};
-    }
-
-    if (match(STRING_LITERAL)) {
-        return new ParseNode{EXPRESSION_NODE, previous().value, {}};
-    }
-
-    if (match(IDENTIFIER)) {
-        return new ParseNode{IDENTIFIER_NODE, previous().value, {}};
-    }
-
-    if (match(DELIMITER, "(")) {
-        ParseNode* node = parseExpr();
-        if (!match(DELIMITER, ")")) error("Expected ')' after expression");
-        return node;
-    }
-
-    error("Invalid factor");
-    return nullptr;
-}
-
-
-// --- Parse Tree Printer ---
-
-void Parser::printParseTree(ParseNode* node, int level) {
-    if (!node) return;
-
-    for (int i = 0; i < level; ++i)
-        cout << "  ";
-
-    cout << nodeTypeToString(node->type);
-
-    if (!node->value.empty())
-        cout << ": " << node->value;
-
-    cout << endl;
-
-    for (ParseNode* child : node->children)
-        printParseTree(child, level + 1);
-}
+#include "parser.h"
+#include <iostream>
+
+using namespace std;
+
+Parser::Parser(const vector<Token>& tokens) : tokens(tokens), current(0) {}
+
+Token Parser::peek() {
+    if (isAtEnd()) return Token{UNKNOWN, "", tokens.empty() ? 1 : tokens.back().line};
+    return tokens[current];
+}
+
+Token Parser::advance() {
+    if (!isAtEnd()) current++;
+    return previous();
+}
+
+Token Parser::previous() {
+    return tokens[current - 1];
+}
+
+bool Parser::isAtEnd() {
+    return current >= tokens.size();
+}
+
+bool Parser::match(TokenType type, string value) {
+    if (isAtEnd()) return false;
+    Token t = peek();
+    if (t.type == type && (value.empty() || t.value == value)) {
+        advance();
+        return true;
+    }
+    return false;
+}
+
+// Unwinds to parse(), which records the message.
+struct Parser::SyntaxError {
+    string message;
+};
+
+void Parser::error(const string& message) {
+    throw SyntaxError{"Syntax Error: " + message + " at token: '" + peek().value + "'"};
+}
+
+ParseNode* Parser::make(ParseNode node) {
+    nodes.emplace_back(new ParseNode(std::move(node)));
+    return nodes.back().get();
+}
+
+void Parser::printErrors() {
+    for (const string& err : errors) {
+        cerr << err << endl << flush;
+        cout << err << endl;
+    }
+}
+
+bool Parser::hasErrors() const {
+    return !errors.empty();
+}
+
+const vector<string>& Parser::getErrors() const {
+    return errors;
+}
+
+
+// ---- Recursive Descent Parsing ----
+
+ParseNode* Parser::parse() {
+    try {
+        return parseProgram();
+    } catch (const SyntaxError& e) {
+        errors.push_back(e.message);
+        return nullptr;
+    }
+}
+
+ParseNode* Parser::parseProgram() {
+    if (match(KEYWORD, "intt") || match(KEYWORD, "sttring")) {
+        // optional return type
+    }
+
+    if (!match(KEYWORD, "mainn")) error("Expected 'mainn'");
+    if (!match(DELIMITER, "(")) error("Expected '(' after 'mainn'");
+    if (!match(DELIMITER, ")")) error("Expected ')' after '('");
+    if (!match(DELIMITER, "{")) error("Expected '{' after mainn()");
+
+    ParseNode* node = make({PROGRAM_NODE, "mainn", {}});
+
+    if (!isAtEnd() && peek().value != "}") {
+        node->children.push_back(parseStmtList());
+    }
+
+    if (!match(DELIMITER, "}")) {
+        error("Expected '}' at end of mainn");
+    }
+
+    return node;
+}
+
+
+ParseNode* Parser::parseStmtList() {
+    ParseNode* node = make({STATEMENT_NODE, "stmt_list", {}});
+    while (!isAtEnd() && peek().value != "}") {
+        int line = peek().line;
+        node->children.push_back(parseStmt());
+        node->children.back()->line = line;
+    }
+    return node;
+}
+
+ParseNode* Parser::parseStmt() {
+    if (match(KEYWORD, "intt") || match(KEYWORD, "sttring")) {
+        string type = previous().value;
+        if (!match(IDENTIFIER)) error("Expected identifier after type");
+        Token id = previous();
+        if (match(DELIMITER, "[")) {
+            // fixed size array: the only child is the element count
+            if (!match(NUMBER)) error("Expected array size");
+            ParseNode* decl = make({ARRAY_DECLARATION_NODE, type + " " + id.value, {}});
+            decl->children.push_back(make({NUMBER_NODE, previous().value, {}}));
+            if (!match(DELIMITER, "]")) error("Expected ']' after array size");
+            if (!match(DELIMITER, ";")) error("Expected ';' after declaration");
+            return decl;
+        }
+        ParseNode* decl = make({DECLARATION_NODE, type + " " + id.value, {}});
+        if (match(OPERATOR, "=")) {
+            decl->children.push_back(parseExpr());
+        }
+        if (!match(DELIMITER, ";")) error("Expected ';' after declaration");
+        return decl;
+    }
+
+    if (match(IDENTIFIER)) {
+        Token id = previous();
+        ParseNode* index = nullptr;
+        if (match(DELIMITER, "[")) {
+            index = parseExpr();
+            if (!match(DELIMITER, "]")) error("Expected ']' after index");
+        }
+        if (match(OPERATOR, "=")) {
+            ParseNode* rhs = parseExpr();
+            ParseNode* assign = make({ASSIGNMENT_NODE, id.value, {}});
+            assign->children.push_back(rhs);
+            if (index) assign->children.push_back(index);  // an element of an array
+
+            if (!match(DELIMITER, ";")) error("Expected ';' after assignment");
+            return assign;
+        } else {
+            error("Expected '=' after identifier");
+        }
+    }
+
+
+    if (match(KEYWORD, "retturn")) {
+        ParseNode* ret = make({RETURN_STATEMENT_NODE, "retturn", {}});
+        if (peek().value != ";") {
+            ret->children.push_back(parseExpr());
+        }
+        if (!match(DELIMITER, ";")) error("Expected ';' after retturn");
+        return ret;
+    }
+
+    if (match(KEYWORD, "prrint") || match(KEYWORD, "san")) {
+        Token func = previous();
+        if (!match(DELIMITER, "(")) error("Expected '(' after function name");
+        ParseNode* call = make({FUNCTION_CALL_NODE, func.value, {}});
+        if (peek().type != DELIMITER || peek().value != ")") {
+            call->children.push_back(parseExpr());
+        }
+        if (!match(DELIMITER, ")")) error("Expected ')' after args");
+        if (!match(DELIMITER, ";")) error("Expected ';' after function call");
+        return call;
+    }
+
+    if (match(KEYWORD, "iif")) {
+        ParseNode* ifNode = make({IF_STATEMENT_NODE, "iif", {}});
+        if (!match(DELIMITER, "(")) error("Expected '(' after iif");
+        ifNode->children.push_back(parseExpr());
+        if (!match(DELIMITER, ")")) error("Expected ')' after condition");
+        if (!match(DELIMITER, "{")) error("Expected '{' after iif()");
+        ifNode->children.push_back(parseStmtList());
+        if (!match(DELIMITER, "}")) error("Expected '}' after if body");
+        if (match(KEYWORD, "ellse")) {
+            if (!match(DELIMITER, "{")) error("Expected '{' after ellse");
+            ifNode->children.push_back(parseStmtList());
+            if (!match(DELIMITER, "}")) error("Expected '}' after else body");
+        }
+        return ifNode;
+    }
+
+    if (match(KEYWORD, "loop")) {
+        ParseNode* loopNode = make({LOOP_STATEMENT_NODE, "loop", {}});
+        if (!match(DELIMITER, "(")) error("Expected '(' after 'loop'");
+        loopNode->children.push_back(parseExpr());
+        if (!match(DELIMITER, ")")) error("Expected ')' after loop condition");
+        if (!match(DELIMITER, "{")) error("Expected '{' after loop condition");
+        loopNode->children.push_back(parseStmtList());
+        if (!match(DELIMITER, "}")) error("Expected '}' after loop body");
+        return loopNode;
+    }
+
+    if (match(KEYWORD, "ploop")) {
+        // ploop (i = start; condition) redduce (s, ...) { body }: the children
+        // are the start assignment, the condition, the body and the reduction
+        // variables, which may be none
+        ParseNode* loopNode = make({PARALLEL_LOOP_NODE, "ploop", {}});
+        if (!match(DELIMITER, "(")) error("Expected '(' after 'ploop'");
+        if (!match(IDENTIFIER)) error("Expected loop variable after 'ploop ('");
+        ParseNode* start = make({ASSIGNMENT_NODE, previous().value, {}});
+        if (!match(OPERATOR, "=")) error("Expected '=' after loop variable");
+        start->children.push_back(parseExpr());
+        loopNode->children.push_back(start);
+        if (!match(DELIMITER, ";")) error("Expected ';' after loop start");
+        loopNode->children.push_back(parseExpr());
+        if (!match(DELIMITER, ")")) error("Expected ')' after loop condition");
+        ParseNode* reductions = make({REDUCTION_NODE, "redduce", {}});
+        if (match(KEYWORD, "redduce")) {
+            if (!match(DELIMITER, "(")) error("Expected '(' after 'redduce'");
+            do {
+                if (!match(IDENTIFIER)) error("Expected reduction variable");
+                reductions->children.push_back(make({IDENTIFIER_NODE, previous().value, {}}));
+            } while (match(DELIMITER, ","));
+            if (!match(DELIMITER, ")")) error("Expected ')' after reduction variables");
+        }
+        if (!match(DELIMITER, "{")) error("Expected '{' after loop condition");
+        loopNode->children.push_back(parseStmtList());
+        if (!match(DELIMITER, "}")) error("Expected '}' after loop body");
+        loopNode->children.push_back(reductions);
+        return loopNode;
+    }
+
+    if (match(KEYWORD, "brreak")) {
+        ParseNode* breakNode = make({BREAK_STATEMENT_NODE, "brreak", {}});
+        if (!match(DELIMITER, ";")) error("Expected ';' after 'brreak'");
+        return breakNode;
+    }
+
+    if (match(KEYWORD, "conttinue")) {
+        ParseNode* continueNode = make({CONTINUE_STATEMENT_NODE, "conttinue", {}});
+        if (!match(DELIMITER, ";")) error("Expected ';' after 'conttinue'");
+        return continueNode;
+    }
+
+    error("Unknown or invalid statement");
+    return nullptr;
+}
+
+
+// --- Expression Parsing ---
+
+ParseNode* Parser::parseExpr() {
+    return parseLogic();  
+}
+
+ParseNode* Parser::parseLogic() {
+    ParseNode* node = parseComparison();
+    while (match(OPERATOR, "&&") || match(OPERATOR, "||")) {
+        string op = previous().value;
+        ParseNode* newNode = make({EXPRESSION_NODE, op, {node}});
+        newNode->children.push_back(parseComparison());
+        node = newNode;
+    }
+    return node;
+}
+
+ParseNode* Parser::parseComparison() {
+    ParseNode* node = parseTerm();
+    while (match(OPERATOR, "==") || match(OPERATOR, "!=") ||
+           match(OPERATOR, "<") || match(OPERATOR, "<=") ||
+           match(OPERATOR, ">") || match(OPERATOR, ">=")) {
+        string op = previous().value;
+        ParseNode* newNode = make({EXPRESSION_NODE, op, {node}});
+        newNode->children.push_back(parseTerm());
+        node = newNode;
+    }
+    return node;
+}
+
+ParseNode* Parser::parseTerm() {
+    ParseNode* node = parseFactor();
+    while (match(OPERATOR, "+") || match(OPERATOR, "-")) {
+        string op = previous().value;
+        ParseNode* newNode = make({EXPRESSION_NODE, op, {node}});
+        newNode->children.push_back(parseFactor());
+        node = newNode;
+    }
+    return node;
+}
+
+ParseNode* Parser::parseFactor() {
+    ParseNode* node = parsePrimary();
+    while (match(OPERATOR, "*") || match(OPERATOR, "/")) {
+        string op = previous().value;
+        ParseNode* newNode = make({EXPRESSION_NODE, op, {node}});
+        newNode->children.push_back(parsePrimary());
+        node = newNode;
+    }
+    return node;
+}
+
+ParseNode* Parser::parsePrimary() {
+    Token t = peek();
+
+    if (match(NUMBER)) {
+        return make({NUMBER_NODE, previous().value, {}});
+    }
+
+    if (match(STRING_LITERAL)) {
+        return make({STRING_NODE, previous().value, {}});
+    }
+
+    if (match(IDENTIFIER)) {
+        string name = previous().value;
+        if (match(DELIMITER, "[")) {
+            ParseNode* node = make({INDEX_NODE, name, {parseExpr()}});
+            if (!match(DELIMITER, "]")) error("Expected ']' after index");
+            return node;
+        }
+        return make({IDENTIFIER_NODE, name, {}});
+    }
+
+    if (match(DELIMITER, "(")) {
+        ParseNode* node = parseExpr();
+        if (!match(DELIMITER, ")")) error("Expected ')' after expression");
+        return node;
+    }
+
+    error("Invalid factor");
+    return nullptr;
+}
+
+
+// --- Parse Tree Printer ---
+
+void Parser::printParseTree(ParseNode* node, int level) {
+    if (!node) return;
+
+    for (int i = 0; i < level; ++i)
+        cout << "  ";
+
+    cout << nodeTypeToString(node->type);
+
+    if (!node->value.empty())
+        cout << ": " << node->value;
+
+    cout << endl;
+
+    for (ParseNode* child : node->children)
+        printParseTree(child, level + 1);
+}
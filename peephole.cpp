@@ -0,0 +1,537 @@
+#include "peephole.h"
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+
+using namespace std;
+
+// Locations tracked by the passes: the registers, the flags, then one per
+// frame slot.
+static const int FLAGS = R15 + 1;
+static const int FIRST_SLOT = FLAGS + 1;
+
+// Each round can expose more dead code to the next one.
+static const int MAX_ROUNDS = 8;
+
+static bool isConditionalJump(const string& op) {
+    return op.size() > 1 && op[0] == 'j' && op != "jmp";
+}
+
+static bool isSetCondition(const string& op) {
+    return op.rfind("set", 0) == 0;
+}
+
+
+static bool sameOperand(const MachineOperand& a, const MachineOperand& b) {
+    return a.kind == b.kind && a.base == b.base && a.index == b.index && a.scale == b.scale &&
+           a.value == b.value && a.symbol == b.symbol;
+}
+
+// Condition code that holds exactly when cc does not.
+static string inverse(const string& cc) {
+    static const unordered_map<string, string> table = {
+        {"e", "ne"}, {"ne", "e"}, {"l", "ge"}, {"ge", "l"}, {"g", "le"}, {"le", "g"},
+        {"b", "ae"}, {"ae", "b"}, {"a", "be"}, {"be", "a"}, {"s", "ns"}, {"ns", "s"}};
+    auto it = table.find(cc);
+    return it == table.end() ? "" : it->second;
+}
+
+// Condition code for the comparison with its operands exchanged.
+static string swapped(const string& cc) {
+    static const unordered_map<string, string> table = {
+        {"e", "e"}, {"ne", "ne"}, {"l", "g"}, {"g", "l"}, {"le", "ge"}, {"ge", "le"},
+        {"b", "a"}, {"a", "b"}, {"be", "ae"}, {"ae", "be"}};
+    auto it = table.find(cc);
+    return it == table.end() ? "" : it->second;
+}
+
+static bool test(const vector<uint64_t>& bits, int location) {
+    return bits[location / 64] >> (location % 64) & 1;
+}
+
+static void set(vector<uint64_t>& bits, int location) {
+    bits[location / 64] |= 1ULL << (location % 64);
+}
+
+static void reset(vector<uint64_t>& bits, int location) {
+    bits[location / 64] &= ~(1ULL << (location % 64));
+}
+
+static bool isFrameAccess(const MachineInstr& instr, const MachineOperand& operand) {
+    char suffix = instr.op.back();
+    return operand.kind == MachineOperand::MEM && operand.base == RBX && operand.index == NO_REGISTER &&
+           operand.symbol.empty() && (suffix == 'l' || suffix == 'b') && instr.op != "call";
+}
+
+bool MachinePeephole::endsBlock(const MachineInstr& instr) const {
+    if (instr.op == "call") {
+        return instr.dst.kind == MachineOperand::SYMBOL &&
+               find(noReturn.begin(), noReturn.end(), instr.dst.symbol) != noReturn.end();
+    }
+    return instr.op[0] == 'j' || instr.op == "ret";
+}
+
+int MachinePeephole::slotOf(const MachineInstr& instr, const MachineOperand& operand) const {
+    if (!isFrameAccess(instr, operand)) return -1;
+    auto it = slotIds.find(operand.value);
+    return it == slotIds.end() ? -1 : it->second;
+}
+
+int MachinePeephole::locationOf(const MachineInstr& instr, const MachineOperand& operand) const {
+    if (operand.kind == MachineOperand::REG) return operand.base;
+    return slotOf(instr, operand);
+}
+
+// Locations an instruction reads and writes. A register written through
+// its low byte counts as written entirely: the backend only ever reads such
+// a register back through that byte.
+MachinePeephole::Effects MachinePeephole::effects(const MachineInstr& instr) const {
+    Effects e;
+    const string& op = instr.op;
+    auto address = [&](const MachineOperand& operand) {
+        if (operand.kind != MachineOperand::MEM) return;
+        if (operand.base != NO_REGISTER) e.uses.push_back(operand.base);
+        if (operand.index != NO_REGISTER) e.uses.push_back(operand.index);
+    };
+    auto read = [&](const MachineOperand& operand) {
+        if (operand.kind == MachineOperand::REG) e.uses.push_back(operand.base);
+        address(operand);
+        int slot = slotOf(instr, operand);
+        if (slot >= 0) e.uses.push_back(slot);
+    };
+    auto write = [&](const MachineOperand& operand) {
+        if (operand.kind == MachineOperand::REG) e.defs.push_back(operand.base);
+        if (operand.kind != MachineOperand::MEM) return;
+        address(operand);
+        int slot = slotOf(instr, operand);
+        if (slot >= 0) e.defs.push_back(slot);
+        else e.sideEffect = true;
+    };
+    auto readAll = [&]() {
+        for (int r = RAX; r <= R15; ++r) e.uses.push_back(r);
+    };
+
+    if (op == "label" || op == ".long") return e;
+    if (op == "ret") {
+        readAll();
+        e.sideEffect = true;
+    } else if (op == "syscall") {
+        e.uses = {RAX, RDI, RSI, RDX};
+        e.defs = {RAX, RCX, R11};
+        e.sideEffect = true;
+    } else if (op == "cltd") {
+        e.uses = {RAX};
+        e.defs = {RDX};
+    } else if (op == "pushq" || op == "popq") {
+        e.uses.push_back(RSP);
+        if (op == "pushq") read(instr.dst);
+        else write(instr.dst);
+        e.defs.push_back(RSP);
+        e.sideEffect = true;
+    } else if (op == "jmp" || isConditionalJump(op)) {
+        read(instr.dst);
+        if (op != "jmp") e.uses.push_back(FLAGS);
+        e.sideEffect = true;
+    } else if (op == "call") {
+        // runtime functions take their arguments in rdi, rsi and rdx and,
+        // apart from the frameCalls, leave the frame alone; host functions
+        // may also clobber r10
+        read(instr.dst);
+        e.uses.insert(e.uses.end(), {RDI, RSI, RDX, RBX, RSP});
+        e.defs = {RAX, RCX, RDX, RSI, RDI, R8, R9, R11, FLAGS};
+        if (instr.dst.kind != MachineOperand::SYMBOL) e.defs.push_back(R10);
+        if (find(frameCalls.begin(), frameCalls.end(), instr.dst.symbol) != frameCalls.end()) {
+            for (int slot = FIRST_SLOT; slot < locations; ++slot) {
+                e.uses.push_back(slot);
+                e.defs.push_back(slot);
+            }
+        }
+        e.sideEffect = true;
+    } else if (isSetCondition(op)) {
+        e.uses.push_back(FLAGS);
+        write(instr.dst);
+    } else if (op == "leaq") {
+        address(instr.src);
+        write(instr.dst);
+    } else if (op == "movl" || op == "movq" || op == "movb" || op == "movzbl" || op == "movslq") {
+        read(instr.src);
+        write(instr.dst);
+    } else {
+        string name = op.substr(0, op.size() - 1);
+        if (name == "add" || name == "sub" || name == "and" || name == "or" || name == "xor" || name == "imul") {
+            bool zeroing = (name == "xor" || name == "sub") && instr.src.kind == MachineOperand::REG &&
+                           sameOperand(instr.src, instr.dst);
+            if (!zeroing) {
+                read(instr.src);
+                read(instr.dst);
+            }
+            write(instr.dst);
+            e.defs.push_back(FLAGS);
+        } else if (name == "cmp" || name == "test") {
+            read(instr.src);
+            read(instr.dst);
+            e.defs.push_back(FLAGS);
+        } else if (name == "neg" || name == "inc" || name == "dec") {
+            read(instr.dst);
+            write(instr.dst);
+            e.defs.push_back(FLAGS);
+        } else if (name == "idiv" || name == "div") {
+            read(instr.dst);
+            e.uses.insert(e.uses.end(), {RAX, RDX});
+            e.defs = {RAX, RDX, FLAGS};
+            e.sideEffect = true;
+        } else {
+            for (int location = 0; location < locations; ++location) e.uses.push_back(location);
+            e.sideEffect = true;
+            e.unknown = true;
+        }
+    }
+    return e;
+}
+
+// Live locations after each instruction, by backward dataflow over the
+// basic blocks. Code falling off the end, or jumping to a label outside the
+// text, may use any register.
+vector<MachinePeephole::Bits> MachinePeephole::liveOut(const vector<MachineInstr>& text,
+                                                       const vector<Effects>& all) const {
+    size_t n = text.size(), words = (locations + 63) / 64;
+    unordered_map<string, int> labels;
+    vector<string> tableTargets;
+    vector<int> starts;
+    for (size_t i = 0; i < n; ++i) {
+        if (text[i].op == "label") labels[text[i].dst.symbol] = i;
+        if (text[i].op == ".long") tableTargets.push_back(text[i].dst.symbol);
+        if (i == 0 || text[i].op == "label" || endsBlock(text[i - 1])) starts.push_back(i);
+    }
+    int blocks = starts.size();
+    vector<int> blockOf(n);
+    for (int b = 0; b < blocks; ++b) {
+        size_t end = b + 1 < blocks ? starts[b + 1] : n;
+        for (size_t i = starts[b]; i < end; ++i) blockOf[i] = b;
+    }
+
+    Bits registers(words, 0);
+    for (int r = RAX; r <= R15; ++r) set(registers, r);
+    vector<vector<int>> successors(blocks);
+    vector<Bits> exitLive(blocks, Bits(words, 0));
+    for (int b = 0; b < blocks; ++b) {
+        size_t last = (b + 1 < blocks ? starts[b + 1] : n) - 1;
+        const MachineInstr& instr = text[last];
+        auto jumpTo = [&](const string& symbol) {
+            auto it = labels.find(symbol);
+            if (it != labels.end()) successors[b].push_back(blockOf[it->second]);
+            else exitLive[b] = registers;
+        };
+        auto fallThrough = [&]() {
+            if (b + 1 < blocks) successors[b].push_back(b + 1);
+            else exitLive[b] = registers;
+        };
+        if (instr.op == "jmp") {
+            if (instr.dst.kind == MachineOperand::SYMBOL) jumpTo(instr.dst.symbol);
+            else for (const auto& target : tableTargets) jumpTo(target);
+        } else if (isConditionalJump(instr.op)) {
+            jumpTo(instr.dst.symbol);
+            fallThrough();
+        } else if (!endsBlock(instr)) {
+            fallThrough();
+        }
+    }
+
+    auto transfer = [&](Bits& live, const Effects& e) {
+        for (int d : e.defs) reset(live, d);
+        for (int u : e.uses) set(live, u);
+    };
+    auto blockOut = [&](int b, const vector<Bits>& liveIn) {
+        Bits out = exitLive[b];
+        for (int s : successors[b]) {
+            for (size_t w = 0; w < words; ++w) out[w] |= liveIn[s][w];
+        }
+        return out;
+    };
+
+    vector<Bits> liveIn(blocks, Bits(words, 0));
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (int b = blocks - 1; b >= 0; --b) {
+            Bits live = blockOut(b, liveIn);
+            size_t end = b + 1 < blocks ? starts[b + 1] : n;
+            for (size_t i = end; i-- > (size_t)starts[b];) transfer(live, all[i]);
+            if (live != liveIn[b]) {
+                liveIn[b] = live;
+                changed = true;
+            }
+        }
+    }
+
+    vector<Bits> out(n);
+    for (int b = 0; b < blocks; ++b) {
+        Bits live = blockOut(b, liveIn);
+        size_t end = b + 1 < blocks ? starts[b + 1] : n;
+        for (size_t i = end; i-- > (size_t)starts[b];) {
+            out[i] = live;
+            transfer(live, all[i]);
+        }
+    }
+    return out;
+}
+
+// ---- Forward pass ----
+// Within a basic block, content[l] is the constant, register or slot whose
+// value location l is known to hold, and condition[l] the condition code
+// whose 0/1 value it holds for the current flags.
+
+bool MachinePeephole::forward(vector<MachineInstr>& text, const vector<Bits>& live) {
+    struct Value {
+        MachineOperand operand;
+        int location = -1;  // -1: operand is an immediate
+    };
+    vector<Value> content(locations);
+    vector<bool> known(locations, false);
+    vector<vector<int>> copies(locations);  // location -> locations whose content refers to it
+    vector<string> condition(locations), lowByte(locations);
+    vector<int> conditioned;
+
+    auto clearAll = [&]() {
+        fill(known.begin(), known.end(), false);
+        for (auto& list : copies) list.clear();
+        for (int l : conditioned) condition[l].clear(), lowByte[l].clear();
+        conditioned.clear();
+    };
+    auto forget = [&](int l) {
+        known[l] = false;
+        condition[l].clear();
+        lowByte[l].clear();
+        for (int other : copies[l]) {
+            if (known[other] && content[other].location == l) known[other] = false;
+        }
+        copies[l].clear();
+    };
+    auto root = [&](const MachineOperand& operand, int l) {
+        if (l >= 0 && known[l]) return content[l];
+        Value v;
+        v.operand = operand;
+        v.location = l;
+        return v;
+    };
+    auto same = [&](const Value& a, const Value& b) {
+        if (a.location >= 0 || b.location >= 0) return a.location == b.location;
+        return a.operand.kind == MachineOperand::IMM && b.operand.kind == MachineOperand::IMM &&
+               a.operand.value == b.operand.value;
+    };
+    // a register holding the value, or NO_REGISTER
+    auto registerHolding = [&](const Value& v) {
+        if (v.operand.kind == MachineOperand::REG) return v.operand.base;
+        if (v.location < 0) return (int)NO_REGISTER;
+        for (int r = RAX; r <= R15; ++r) {
+            if (r != RSP && known[r] && content[r].location == v.location) return r;
+        }
+        return (int)NO_REGISTER;
+    };
+    auto flagsLive = [&](size_t i) { return test(live[i], FLAGS); };
+
+    bool changed = false;
+    vector<MachineInstr> result;
+    result.reserve(text.size());
+    for (size_t i = 0; i < text.size(); ++i) {
+        MachineInstr instr = text[i];
+        const string op = instr.op;
+        if (op == "label") {
+            clearAll();
+            result.push_back(instr);
+            continue;
+        }
+        bool word = op.back() == 'l' && op != "call" && op != "movzbl";
+        string name = word ? op.substr(0, op.size() - 1) : "";
+
+        // test of a materialized comparison followed by je/jne: branch on
+        // the comparison's flags instead
+        bool testsZero = (name == "test" && sameOperand(instr.src, instr.dst)) ||
+                         (name == "cmp" && instr.src.kind == MachineOperand::IMM && instr.src.value == 0);
+        if (testsZero && i + 1 < text.size() && (text[i + 1].op == "je" || text[i + 1].op == "jne") &&
+            !flagsLive(i + 1)) {
+            int l = locationOf(instr, instr.dst);
+            string cc = l >= 0 ? condition[l] : "";
+            if (!cc.empty()) {
+                MachineInstr jump = text[++i];
+                jump.op = "j" + (jump.op == "je" ? inverse(cc) : cc);
+                result.push_back(jump);
+                fusedBranches++;
+                changed = true;
+                continue;
+            }
+        }
+
+        // operands: constants become immediates, frame loads come from a
+        // register holding the same value, copies read the original
+        if (name == "mov" || name == "add" || name == "sub" || name == "imul" || name == "and" ||
+            name == "or" || name == "xor" || name == "cmp") {
+            bool zeroing = (name == "xor" || name == "sub") && sameOperand(instr.src, instr.dst);
+            int l = locationOf(instr, instr.src);
+            if (l >= 0 && !zeroing) {
+                Value v = root(instr.src, l);
+                int r = registerHolding(v);
+                if (v.operand.kind == MachineOperand::IMM) {
+                    instr.src = v.operand;
+                    immediates++;
+                    changed = true;
+                } else if (r != NO_REGISTER && r != instr.src.base) {
+                    if (instr.src.kind == MachineOperand::MEM) forwardedLoads++;
+                    instr.src = regOperand(r);
+                    changed = true;
+                }
+            }
+        }
+        if ((name == "cmp" || name == "test") && instr.dst.kind == MachineOperand::MEM) {
+            int l = slotOf(instr, instr.dst);
+            int r = l >= 0 ? registerHolding(root(instr.dst, l)) : NO_REGISTER;
+            if (r != NO_REGISTER) {
+                if (name == "test" && sameOperand(instr.src, instr.dst)) instr.src = regOperand(r);
+                if (instr.src.kind != MachineOperand::MEM) {
+                    instr.dst = regOperand(r);
+                    forwardedLoads++;
+                    changed = true;
+                }
+            }
+        }
+        // a constant left operand: compare the other operand against an
+        // immediate and swap the condition of the single flags reader
+        if (name == "cmp" && instr.dst.kind == MachineOperand::REG && instr.src.kind != MachineOperand::IMM &&
+            i + 1 < text.size() && !flagsLive(i + 1)) {
+            const string& next = text[i + 1].op;
+            size_t prefix = isSetCondition(next) ? 3 : isConditionalJump(next) ? 1 : 0;
+            Value v = root(instr.dst, instr.dst.base);
+            string cc = prefix ? swapped(next.substr(prefix)) : "";
+            if (v.operand.kind == MachineOperand::IMM && !cc.empty()) {
+                instr.dst = instr.src;
+                instr.src = v.operand;
+                text[i + 1].op = next.substr(0, prefix) + cc;
+                immediates++;
+                changed = true;
+            }
+        }
+
+        // assigned-flag bytes are only ever stored as constants
+        bool byteStore = op == "movb" && instr.src.kind == MachineOperand::IMM && slotOf(instr, instr.dst) >= 0;
+        if (byteStore) name = "mov";
+        if (name == "mov") {
+            int s = locationOf(instr, instr.src), d = locationOf(instr, instr.dst);
+            if (sameOperand(instr.src, instr.dst) || (d >= 0 && same(root(instr.src, s), root(instr.dst, d)))) {
+                redundantMoves++;
+                changed = true;
+                continue;
+            }
+        }
+
+        result.push_back(instr);
+        string sourceByte = instr.src.kind == MachineOperand::REG ? lowByte[instr.src.base] : "";
+        Effects e = effects(instr);
+        if (e.unknown || (endsBlock(instr) && !isConditionalJump(op))) {
+            clearAll();
+            continue;
+        }
+        for (int d : e.defs) {
+            if (d == RBX) {
+                clearAll();
+            } else if (d == FLAGS) {
+                for (int l : conditioned) condition[l].clear(), lowByte[l].clear();
+                conditioned.clear();
+            } else {
+                forget(d);
+            }
+        }
+
+        int d = locationOf(instr, instr.dst);
+        if (d < 0) continue;
+        if (name == "mov") {
+            int s = locationOf(instr, instr.src);
+            if (s < 0 && instr.src.kind != MachineOperand::IMM) continue;
+            content[d] = root(instr.src, s);
+            known[d] = true;
+            if (content[d].location >= 0) copies[content[d].location].push_back(d);
+            if (s >= 0 && !condition[s].empty()) {
+                condition[d] = condition[s];
+                conditioned.push_back(d);
+            }
+        } else if ((name == "xor" || name == "sub") && sameOperand(instr.src, instr.dst) &&
+                   instr.src.kind == MachineOperand::REG) {
+            content[d].operand = immOperand(0);
+            content[d].location = -1;
+            known[d] = true;
+        } else if (isSetCondition(op) && instr.dst.kind == MachineOperand::REG) {
+            lowByte[d] = op.substr(3);
+            conditioned.push_back(d);
+        } else if (op == "movzbl" && !sourceByte.empty()) {
+            condition[d] = sourceByte;
+            conditioned.push_back(d);
+        }
+    }
+    text.swap(result);
+    return changed;
+}
+
+// ---- Dead code ----
+
+bool MachinePeephole::removeDead(vector<MachineInstr>& text, const vector<Effects>& all, const vector<Bits>& live) {
+    vector<MachineInstr> result;
+    result.reserve(text.size());
+    for (size_t i = 0; i < text.size(); ++i) {
+        const Effects& e = all[i];
+        bool dead = !e.sideEffect && !e.defs.empty();
+        for (int d : e.defs) {
+            if (test(live[i], d)) dead = false;
+        }
+        if (dead) deadInstructions++;
+        else result.push_back(text[i]);
+    }
+    bool changed = result.size() != text.size();
+    text.swap(result);
+    return changed;
+}
+
+void MachinePeephole::optimize(vector<MachineInstr>& text, const vector<string>& noReturn,
+                               const vector<string>& frameCalls) {
+    this->noReturn = noReturn;
+    this->frameCalls = frameCalls;
+    slotIds.clear();
+    for (const auto& instr : text) {
+        for (const MachineOperand* operand : {&instr.src, &instr.dst}) {
+            if (isFrameAccess(instr, *operand) && !slotIds.count(operand->value)) {
+                int id = FIRST_SLOT + slotIds.size();
+                slotIds[operand->value] = id;
+            }
+        }
+    }
+    locations = FIRST_SLOT + slotIds.size();
+    before = text.size();
+    redundantMoves = forwardedLoads = immediates = fusedBranches = deadInstructions = 0;
+
+    auto analyze = [&](vector<Effects>& all) {
+        all.clear();
+        for (const auto& instr : text) all.push_back(effects(instr));
+        return liveOut(text, all);
+    };
+    vector<Effects> all;
+    for (int round = 0; round < MAX_ROUNDS; ++round) {
+        bool changed = forward(text, analyze(all));
+        vector<Bits> live = analyze(all);
+        changed = removeDead(text, all, live) || changed;
+        if (!changed) break;
+    }
+    after = text.size();
+}
+
+int MachinePeephole::getRemoved() const {
+    return before - after;
+}
+
+void MachinePeephole::printStatistics() {
+    cout << "\n--- Machine Peephole ---\n";
+    cout << left << setw(22) << "instructions" << before << " -> " << after << "\n";
+    cout << setw(22) << "redundant moves" << redundantMoves << "\n";
+    cout << setw(22) << "forwarded loads" << forwardedLoads << "\n";
+    cout << setw(22) << "immediate operands" << immediates << "\n";
+    cout << setw(22) << "fused branches" << fusedBranches << "\n";
+    cout << setw(22) << "dead instructions" << deadInstructions << "\n";
+    cout << setw(22) << "removed" << getRemoved() << "\n";
+    cout << right;
+}
@@ -0,0 +1,61 @@
+#ifndef PEEPHOLE_H
+#define PEEPHOLE_H
+
+#include "machine.h"
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+// Peephole optimization of the x86 backend's machine instructions. A
+// forward pass over each basic block tracks which registers and frame
+// slots hold copies of each other or of constants. It uses them to drop
+// redundant moves, serve frame loads from registers, fold constants into
+// immediate operands and branch on a comparison directly instead of on its
+// materialized 0/1 result. A backward pass then removes instructions whose
+// results are dead according to liveness over the machine code.
+//
+// Frame slots are the memory operands addressed through rbx by 32-bit and
+// byte instructions; every one is assumed to be accessed only through rbx,
+// at a single width, and never to overlap another.
+class MachinePeephole {
+public:
+    // Calls to the noReturn functions end the program; calls to the
+    // frameCalls functions may read and write every frame slot.
+    void optimize(vector<MachineInstr>& text, const vector<string>& noReturn = {},
+                  const vector<string>& frameCalls = {});
+    int getRemoved() const;
+    void printStatistics();
+
+private:
+    typedef vector<uint64_t> Bits;
+
+    struct Effects {
+        vector<int> uses;
+        vector<int> defs;
+        bool sideEffect = false;  // writes other memory, transfers control or may trap
+        bool unknown = false;     // not modelled: reads everything, clobbers anything
+    };
+
+    unordered_map<long long, int> slotIds;  // rbx displacement -> location
+    vector<string> noReturn;
+    vector<string> frameCalls;
+    int locations = 0;
+    int before = 0, after = 0;
+    int redundantMoves = 0;
+    int forwardedLoads = 0;
+    int immediates = 0;
+    int fusedBranches = 0;
+    int deadInstructions = 0;
+
+    bool endsBlock(const MachineInstr& instr) const;
+    int slotOf(const MachineInstr& instr, const MachineOperand& operand) const;
+    int locationOf(const MachineInstr& instr, const MachineOperand& operand) const;
+    Effects effects(const MachineInstr& instr) const;
+    vector<Bits> liveOut(const vector<MachineInstr>& text, const vector<Effects>& all) const;
+    bool forward(vector<MachineInstr>& text, const vector<Bits>& live);
+    bool removeDead(vector<MachineInstr>& text, const vector<Effects>& all, const vector<Bits>& live);
+};
+
+#endif
@@ -0,0 +1,163 @@
+#include "profile.h"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <sstream>
+using namespace std;
+
+string Profile::branchKey(const Instruction& ifFalse) {
+    return labelKey(ifFalse.result) + " " + to_string(ifFalse.line);
+}
+
+string Profile::labelKey(const string& label) {
+    return label.substr(0, label.find('_'));
+}
+
+long Profile::tripsPerIteration(const string& label) {
+    size_t tag = label.find("_x");
+    if (tag == string::npos) return 1;
+    long factor = atol(label.c_str() + tag + 2);
+    return factor > 0 ? factor : 1;
+}
+
+// One record per line:
+//   branch <target label> <source line> <taken> <not taken>
+//   loop <start label> <entries> <trips>
+bool Profile::load(const string& path) {
+    ifstream in(path);
+    if (!in) return false;
+    branches.clear();
+    loops.clear();
+
+    string line;
+    while (getline(in, line)) {
+        istringstream fields(line);
+        string kind;
+        fields >> kind;
+        if (kind == "branch") {
+            string target, line;
+            BranchCounts counts;
+            if (fields >> target >> line >> counts.taken >> counts.notTaken) {
+                branches[target + " " + line] = counts;
+            }
+        } else if (kind == "loop") {
+            string label;
+            LoopCounts counts;
+            if (fields >> label >> counts.entries >> counts.trips) {
+                loops[label] = counts;
+            }
+        }
+    }
+    return true;
+}
+
+bool Profile::save(const string& path) const {
+    ofstream out(path);
+    if (!out) return false;
+    map<string, BranchCounts> sortedBranches(branches.begin(), branches.end());
+    map<string, LoopCounts> sortedLoops(loops.begin(), loops.end());
+    for (const auto& b : sortedBranches) {
+        out << "branch " << b.first << " " << b.second.taken << " " << b.second.notTaken << "\n";
+    }
+    for (const auto& l : sortedLoops) {
+        out << "loop " << l.first << " " << l.second.entries << " " << l.second.trips << "\n";
+    }
+    return true;
+}
+
+// ---- Runtime Profile ----
+
+static string describe(const Instruction& instr) {
+    if (instr.op == "label") return instr.result + ":";
+    string text = instr.op;
+    if (!instr.arg1.empty()) text += " " + instr.arg1;
+    if (!instr.arg2.empty()) text += ", " + instr.arg2;
+    if (!instr.result.empty()) text += " => " + instr.result;
+    return text;
+}
+
+void RuntimeProfile::printReport(ostream& out, const vector<string>& source, size_t limit) const {
+    auto share = [](double part, double whole) { return whole > 0 ? 100 * part / whole : 0.0; };
+    auto lineNumber = [](int line) { return line > 0 ? to_string(line) : string("-"); };
+    auto sourceText = [&](int line) {
+        if (line <= 0 || line > (int)source.size()) return string("(added by the compiler)");
+        const string& text = source[line - 1];
+        size_t start = text.find_first_not_of(" \t");
+        return start == string::npos ? string() : text.substr(start);
+    };
+
+    out << "\n--- Hot Spots ---\n";
+    out << executions << " instructions in " << fixed << setprecision(3) << milliseconds << " ms\n";
+
+    // Labels only mark positions; lines are ranked by the work done on them.
+    map<int, long> perLine;
+    long work = 0;
+    for (const auto& instr : instructions) {
+        if (instr.instruction.op == "label") continue;
+        perLine[instr.instruction.line] += instr.executions;
+        work += instr.executions;
+    }
+    vector<pair<int, long>> lines(perLine.begin(), perLine.end());
+    stable_sort(lines.begin(), lines.end(), [](const pair<int, long>& a, const pair<int, long>& b) {
+        return a.second > b.second;
+    });
+    out << "\n" << setw(6) << "line" << setw(14) << "executions" << setw(8) << "share" << "  source\n";
+    for (size_t i = 0; i < lines.size() && i < limit; ++i) {
+        out << setw(6) << lineNumber(lines[i].first) << setw(14) << lines[i].second << setw(7)
+            << setprecision(1) << share(lines[i].second, work) << "%  " << sourceText(lines[i].first) << "\n";
+    }
+
+    if (!loops.empty()) {
+        vector<LoopProfile> sorted = loops;
+        stable_sort(sorted.begin(), sorted.end(), [](const LoopProfile& a, const LoopProfile& b) {
+            return a.milliseconds > b.milliseconds;
+        });
+        out << "\n" << left << setw(10) << "loop" << right << setw(6) << "line" << setw(10) << "entries"
+            << setw(14) << "trips" << setw(12) << "time ms" << setw(8) << "share" << "\n";
+        for (size_t i = 0; i < sorted.size() && i < limit; ++i) {
+            const LoopProfile& loop = sorted[i];
+            out << left << setw(10) << loop.label << right << setw(6) << lineNumber(loop.line) << setw(10)
+                << loop.entries << setw(14) << loop.trips << setw(12) << setprecision(3) << loop.milliseconds
+                << setw(7) << setprecision(1) << share(loop.milliseconds, milliseconds) << "%\n";
+        }
+    }
+
+    vector<const InstructionProfile*> branches;
+    for (const auto& instr : instructions) {
+        if (instr.instruction.op == "ifFalse") branches.push_back(&instr);
+    }
+    if (!branches.empty()) {
+        stable_sort(branches.begin(), branches.end(), [](const InstructionProfile* a, const InstructionProfile* b) {
+            return a->executions > b->executions;
+        });
+        out << "\n" << setw(6) << "line" << setw(14) << "taken" << setw(14) << "not taken" << "  branch\n";
+        for (size_t i = 0; i < branches.size() && i < limit; ++i) {
+            const InstructionProfile& branch = *branches[i];
+            out << setw(6) << lineNumber(branch.instruction.line) << setw(14) << branch.taken << setw(14)
+                << branch.notTaken << "  " << describe(branch.instruction) << "\n";
+        }
+    }
+    out << defaultfloat;
+}
+
+// One record per line, the instruction text last since it contains spaces:
+//   run <instructions executed> <milliseconds>
+//   instruction <index> <line> <executions> <taken> <not taken> <instruction>
+//   loop <start label> <line> <entries> <trips> <milliseconds>
+bool RuntimeProfile::save(const string& path) const {
+    ofstream out(path);
+    if (!out) return false;
+    out << fixed << setprecision(6);
+    out << "run " << executions << " " << milliseconds << "\n";
+    for (const auto& instr : instructions) {
+        out << "instruction " << instr.index << " " << instr.instruction.line << " " << instr.executions << " "
+            << instr.taken << " " << instr.notTaken << " " << describe(instr.instruction) << "\n";
+    }
+    for (const auto& loop : loops) {
+        out << "loop " << loop.label << " " << loop.line << " " << loop.entries << " " << loop.trips << " "
+            << loop.milliseconds << "\n";
+    }
+    return true;
+}
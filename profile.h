@@ -0,0 +1,74 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include "icg.h"
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+struct BranchCounts {
+    long taken = 0;      // ifFalse jumped (condition was false)
+    long notTaken = 0;
+};
+
+struct LoopCounts {
+    long entries = 0;    // arrivals at the start label from outside the loop
+    long trips = 0;      // back-edge jumps taken
+};
+
+// Execution counts written by the interpreter and read back by the optimizer.
+// Entries are keyed by the labels of the intermediate code, before the
+// optimizer copies anything. A label it derives from another one is named
+// after it: L3_17 is a copy of L3 in an unrolled loop body and L3_x4_18 the
+// start of loop L3 unrolled four times. The counts of a copy add up under
+// the original, so a profile of unrolled code still matches the loops and
+// branches the optimizer looks up before unrolling.
+class Profile {
+public:
+    unordered_map<string, BranchCounts> branches;  // keyed by branchKey()
+    unordered_map<string, LoopCounts> loops;       // keyed by labelKey() of the start label
+
+    static string branchKey(const Instruction& ifFalse);  // target's labelKey() and source line
+    static string labelKey(const string& label);
+    static long tripsPerIteration(const string& label);   // 4 for L3_x4_18, otherwise 1
+    bool load(const string& path);
+    bool save(const string& path) const;
+};
+
+// What a profiling run of the interpreter measured, for finding hot spots:
+// how often each IR instruction ran, which way each `ifFalse` went and how
+// long each loop took from entry to exit, including the loops nested in it.
+// Instructions carry the source line of the statement they came from.
+struct InstructionProfile {
+    int index = 0;            // in the executed code
+    Instruction instruction;
+    long executions = 0;
+    long taken = 0;           // ifFalse only
+    long notTaken = 0;
+};
+
+struct LoopProfile {
+    string label;             // start label
+    int line = 0;
+    long entries = 0;
+    long trips = 0;
+    double milliseconds = 0;
+};
+
+class RuntimeProfile {
+public:
+    vector<InstructionProfile> instructions;  // those that ran, in code order
+    vector<LoopProfile> loops;                // those that were entered
+    long executions = 0;                      // of all instructions
+    double milliseconds = 0;                  // of the whole run
+
+    // The `limit` hottest source lines, loops and branches; source holds
+    // the program's lines, from line 1.
+    void printReport(ostream& out, const vector<string>& source, size_t limit = 10) const;
+    bool save(const string& path) const;
+};
+
+#endif
@@ -0,0 +1,273 @@
+#include "regalloc.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <unordered_set>
+
+using namespace std;
+
+static bool isLiteral(const string& s) {
+    if (s.empty()) return false;
+    for (char c : s) {
+        if (!isdigit(c) && c != '-') return false;
+    }
+    return true;
+}
+
+static bool isName(const string& s) {
+    return !s.empty() && s[0] != '"' && !isLiteral(s);
+}
+
+RegisterAllocator::RegisterAllocator(const vector<int>& registers) : registers(registers) {}
+
+// Names read by each instruction. A param is read again by the call that
+// consumes it, since its value is only taken at the call.
+static vector<vector<string>> collectUses(const vector<Instruction>& code) {
+    vector<vector<string>> uses(code.size());
+    vector<string> params;
+    for (size_t i = 0; i < code.size(); ++i) {
+        const auto& instr = code[i];
+        const string& op = instr.op;
+        if (op == "label" || op == "goto" || op == "case") continue;
+        if (op == "param") {
+            params.push_back(instr.arg1.empty() ? instr.result : instr.arg1);
+        } else if (op == "call") {
+            if (instr.result == "prrint" && !params.empty()) {
+                if (isName(params.back())) uses[i].push_back(params.back());
+                params.clear();
+            }
+            continue;
+        }
+        if (isName(instr.arg1) && op != "load") uses[i].push_back(instr.arg1);  // not the array
+        if (isName(instr.arg2)) uses[i].push_back(instr.arg2);
+        if (op == "param" && instr.arg1.empty() && isName(instr.result)) uses[i].push_back(instr.result);
+    }
+    return uses;
+}
+
+void RegisterAllocator::computeIntervals(const vector<Instruction>& code) {
+    int n = code.size();
+    vector<vector<string>> uses = collectUses(code);
+
+    // Basic blocks: a block ends after a jump or return (a jumptable keeps
+    // its case entries) and before a label.
+    vector<pair<int, int>> blocks;
+    unordered_map<string, int> labelBlock;
+    int start = 0;
+    for (int i = 0; i < n; ++i) {
+        if (code[i].op == "label" && i > start) {
+            blocks.push_back({start, i});
+            start = i;
+        }
+        const string& op = code[i].op;
+        bool ends = op == "goto" || op == "ifFalse" || op == "jumptable" || op == "case" || op == "return";
+        if (ends && (i + 1 == n || code[i + 1].op != "case")) {
+            blocks.push_back({start, i + 1});
+            start = i + 1;
+        }
+    }
+    if (start < n) blocks.push_back({start, n});
+    int blockCount = blocks.size();
+    for (int b = 0; b < blockCount; ++b) {
+        if (code[blocks[b].first].op == "label") labelBlock[code[blocks[b].first].result] = b;
+    }
+
+    vector<vector<int>> succs(blockCount);
+    for (int b = 0; b < blockCount; ++b) {
+        bool fallsThrough = true;
+        for (int i = blocks[b].first; i < blocks[b].second; ++i) {
+            const string& op = code[i].op;
+            if (op == "goto" || op == "ifFalse" || op == "jumptable" || op == "case") {
+                auto target = labelBlock.find(code[i].result);
+                if (target != labelBlock.end()) succs[b].push_back(target->second);
+            }
+            if (op == "goto" || op == "jumptable" || op == "case" || op == "return") fallsThrough = false;
+        }
+        if (fallsThrough && b + 1 < blockCount) succs[b].push_back(b + 1);
+    }
+
+    // Only names read in some block before being written there can be live
+    // across blocks; they are numbered so the dataflow sets are bit vectors.
+    unordered_map<string, int> ids;
+    vector<string> names;
+    for (int b = 0; b < blockCount; ++b) {
+        unordered_set<string> written;
+        for (int i = blocks[b].first; i < blocks[b].second; ++i) {
+            for (const auto& name : uses[i]) {
+                if (!written.count(name) && !ids.count(name)) {
+                    ids[name] = names.size();
+                    names.push_back(name);
+                }
+            }
+            if (writesResult(code[i])) written.insert(code[i].result);
+        }
+    }
+    int words = (names.size() + 63) / 64;
+    typedef vector<uint64_t> Bits;
+    auto set = [](Bits& bits, int v) { bits[v / 64] |= 1ULL << (v % 64); };
+    auto test = [](const Bits& bits, int v) { return (bits[v / 64] >> (v % 64)) & 1; };
+
+    vector<Bits> gen(blockCount, Bits(words)), kill = gen;
+    for (int b = 0; b < blockCount; ++b) {
+        for (int i = blocks[b].first; i < blocks[b].second; ++i) {
+            for (const auto& name : uses[i]) {
+                auto it = ids.find(name);
+                if (it != ids.end() && !test(kill[b], it->second)) set(gen[b], it->second);
+            }
+            auto it = writesResult(code[i]) ? ids.find(code[i].result) : ids.end();
+            if (it != ids.end()) set(kill[b], it->second);
+        }
+    }
+    vector<Bits> liveIn = gen, liveOut(blockCount, Bits(words));
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (int b = blockCount - 1; b >= 0; --b) {
+            Bits out(words);
+            for (int succ : succs[b]) {
+                for (int w = 0; w < words; ++w) out[w] |= liveIn[succ][w];
+            }
+            Bits in(words);
+            for (int w = 0; w < words; ++w) in[w] = gen[b][w] | (out[w] & ~kill[b][w]);
+            if (in != liveIn[b] || out != liveOut[b]) {
+                liveIn[b].swap(in);
+                liveOut[b].swap(out);
+                changed = true;
+            }
+        }
+    }
+
+    // Loop depth of each instruction, from the back edges.
+    vector<int> depth(n + 1, 0);
+    unordered_map<string, int> labelIndex;
+    for (int i = 0; i < n; ++i) {
+        if (code[i].op == "label") labelIndex[code[i].result] = i;
+        const string& op = code[i].op;
+        if (op != "goto" && op != "ifFalse" && op != "jumptable" && op != "case") continue;
+        auto target = labelIndex.find(code[i].result);
+        if (target == labelIndex.end()) continue;
+        depth[target->second]++;
+        depth[i + 1]--;
+    }
+    for (int i = 1; i <= n; ++i) depth[i] += depth[i - 1];
+
+    struct Range { int first, last; double weight; };
+    unordered_map<string, Range> ranges;
+    auto extend = [&](const string& name, int position, double cost) {
+        auto it = ranges.find(name);
+        if (it == ranges.end()) {
+            ranges[name] = {position, position, cost};
+            return;
+        }
+        it->second.first = min(it->second.first, position);
+        it->second.last = max(it->second.last, position);
+        it->second.weight += cost;
+    };
+    for (int b = 0; b < blockCount; ++b) {
+        for (int v = 0; v < (int)names.size(); ++v) {
+            if (test(liveIn[b], v)) extend(names[v], blocks[b].first, 0);
+            if (test(liveOut[b], v)) extend(names[v], blocks[b].second - 1, 0);
+        }
+        for (int i = blocks[b].first; i < blocks[b].second; ++i) {
+            double cost = pow(10.0, min(depth[i], 6));
+            for (const auto& name : uses[i]) extend(name, i, cost);
+            if (writesResult(code[i])) extend(code[i].result, i, cost);
+        }
+    }
+
+    intervals.clear();
+    for (const auto& range : ranges) {
+        intervals.push_back({range.first, range.second.first, range.second.last, range.second.weight});
+    }
+    sort(intervals.begin(), intervals.end(), [](const LiveInterval& a, const LiveInterval& b) {
+        return a.start != b.start ? a.start < b.start : a.name < b.name;
+    });
+
+    spillLoads = spillStores = 0;
+}
+
+void RegisterAllocator::allocate(const vector<Instruction>& code) {
+    computeIntervals(code);
+    assignment.clear();
+
+    vector<int> free(registers.rbegin(), registers.rend());  // back is preferred
+    vector<int> active;  // indices into intervals, by increasing end
+    auto byEnd = [&](int a, int b) { return intervals[a].end < intervals[b].end; };
+
+    for (int current = 0; current < (int)intervals.size(); ++current) {
+        LiveInterval& interval = intervals[current];
+        while (!active.empty() && intervals[active.front()].end < interval.start) {
+            free.push_back(intervals[active.front()].reg);
+            active.erase(active.begin());
+        }
+        if (!free.empty()) {
+            interval.reg = free.back();
+            free.pop_back();
+            active.insert(upper_bound(active.begin(), active.end(), current, byEnd), current);
+            continue;
+        }
+        // Spill whichever of the current and active intervals has the lowest
+        // weight per instruction covered; a tie goes to the one ending last.
+        auto density = [&](int k) {
+            return intervals[k].weight / (intervals[k].end - intervals[k].start + 1);
+        };
+        int victim = current;
+        for (int a : active) {
+            if (density(a) < density(victim) ||
+                (density(a) == density(victim) && intervals[a].end > intervals[victim].end)) victim = a;
+        }
+        if (victim == current) continue;
+        interval.reg = intervals[victim].reg;
+        intervals[victim].reg = NO_REGISTER;
+        active.erase(find(active.begin(), active.end(), victim));
+        active.insert(upper_bound(active.begin(), active.end(), current, byEnd), current);
+    }
+
+    for (const auto& interval : intervals) {
+        if (interval.reg != NO_REGISTER) assignment[interval.name] = interval.reg;
+    }
+
+    // Static count of the frame accesses left for spilled variables.
+    vector<vector<string>> uses = collectUses(code);
+    for (size_t i = 0; i < code.size(); ++i) {
+        for (const auto& name : uses[i]) {
+            if (!assignment.count(name)) spillLoads++;
+        }
+        if (writesResult(code[i]) && !assignment.count(code[i].result)) spillStores++;
+    }
+}
+
+int RegisterAllocator::registerOf(const string& name) const {
+    auto it = assignment.find(name);
+    return it == assignment.end() ? NO_REGISTER : it->second;
+}
+
+vector<int> RegisterAllocator::registersLiveAcross(int position) const {
+    vector<int> live;
+    for (const auto& interval : intervals) {
+        if (interval.start > position) break;
+        if (interval.reg != NO_REGISTER && interval.end > position) live.push_back(interval.reg);
+    }
+    return live;
+}
+
+const vector<LiveInterval>& RegisterAllocator::getIntervals() const {
+    return intervals;
+}
+
+void RegisterAllocator::printStatistics() {
+    int spilled = 0;
+    unordered_set<int> used;
+    for (const auto& interval : intervals) {
+        if (interval.reg == NO_REGISTER) spilled++;
+        else used.insert(interval.reg);
+    }
+    cout << "\n--- Register Allocation ---\n";
+    cout << left << setw(22) << "intervals" << intervals.size() << "\n";
+    cout << setw(22) << "registers used" << used.size() << " of " << registers.size() << "\n";
+    cout << setw(22) << "spilled intervals" << spilled << "\n";
+    cout << setw(22) << "spill loads" << spillLoads << "\n";
+    cout << setw(22) << "spill stores" << spillStores << "\n";
+    cout << right;
+}
@@ -0,0 +1,45 @@
+#ifndef REGALLOC_H
+#define REGALLOC_H
+
+#include "icg.h"
+#include "machine.h"
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+// The instruction range over which a variable is live, from its first to its
+// last live position, with the variable's spill cost.
+struct LiveInterval {
+    string name;
+    int start;
+    int end;
+    double weight;              // uses and definitions, 10x per loop level
+    int reg = NO_REGISTER;      // NO_REGISTER: spilled to its frame slot
+};
+
+// Linear-scan register allocation over the IR. Liveness comes from
+// backward dataflow over the basic blocks, so a variable that is live
+// around a loop's back edge gets one interval covering the whole loop. When
+// no register is free, the interval with the lowest weight among the
+// current and active ones is spilled.
+class RegisterAllocator {
+public:
+    explicit RegisterAllocator(const vector<int>& registers);  // in order of preference
+    void allocate(const vector<Instruction>& code);
+    int registerOf(const string& name) const;                 // NO_REGISTER if spilled
+    vector<int> registersLiveAcross(int position) const;      // live before and after position
+    const vector<LiveInterval>& getIntervals() const;
+    void printStatistics();
+
+private:
+    vector<int> registers;
+    vector<LiveInterval> intervals;
+    unordered_map<string, int> assignment;
+    int spillLoads = 0;    // operand reads served from the frame
+    int spillStores = 0;   // results written to the frame
+
+    void computeIntervals(const vector<Instruction>& code);
+};
+
+#endif
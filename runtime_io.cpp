@@ -0,0 +1,97 @@
+#include "runtime_io.h"
+#include <cerrno>
+#include <unistd.h>
+
+OutputBuffer::OutputBuffer(ostream& out, size_t capacity)
+    : out(&out), buffer(capacity), capacity(capacity) {}
+
+OutputBuffer::~OutputBuffer() {
+    drain();
+}
+
+void OutputBuffer::setStream(ostream& stream) {
+    flush();
+    out = &stream;
+}
+
+void OutputBuffer::setLimit(size_t bytes) {
+    limit = bytes;
+    written = 0;
+    exceeded = false;
+}
+
+void OutputBuffer::drain() {
+    if (length == 0) return;
+    store(buffer.data(), length);
+    length = 0;
+}
+
+bool OutputBuffer::store(const char* data, size_t size) {
+    if (limit && size > limit - written) {
+        out->write(data, limit - written);
+        written = limit;
+        exceeded = true;
+        return false;
+    }
+    out->write(data, size);
+    written += size;
+    return true;
+}
+
+void OutputBuffer::flush() {
+    drain();
+    out->flush();
+}
+
+InputReader::InputReader(int fd, size_t capacity) : fd(fd), buffer(capacity) {}
+
+InputReader::InputReader(const string& text) : fd(-1), buffer(text.begin(), text.end()), length(text.size()) {}
+
+void InputReader::tie(OutputBuffer* output) {
+    tied = output;
+}
+
+bool InputReader::fill() {
+    if (fd < 0) return false;
+    if (tied) tied->flush();
+    ssize_t count;
+    do {
+        count = read(fd, buffer.data(), buffer.size());
+    } while (count < 0 && errno == EINTR);
+    if (count <= 0) return false;
+    position = 0;
+    length = count;
+    return true;
+}
+
+bool InputReader::readLine(string& line) {
+    line.clear();
+    int c = next();
+    if (c < 0) return false;
+    while (c >= 0 && c != '\n') {
+        line += (char)c;
+        c = next();
+    }
+    return true;
+}
+
+int InputReader::readInt() {
+    int c = next();
+    while (c >= 0 && c <= ' ') c = next();
+    bool negative = c == '-';
+    if (negative) c = next();
+    unsigned value = 0;
+    while (c >= '0' && c <= '9') {
+        value = value * 10 + (c - '0');
+        c = next();
+    }
+    return (int)(negative ? 0u - value : value);
+}
+
+string outOfBoundsSuffix(const string& array, long size) {
+    return " is out of bounds for array '" + array + "' of size " + to_string(size);
+}
+
+string outOfBoundsMessage(int index, const string& array, long size) {
+    return OUT_OF_BOUNDS_PREFIX + to_string(index) + outOfBoundsSuffix(array, size);
+}
@@ -0,0 +1,113 @@
+#ifndef RUNTIME_IO_H
+#define RUNTIME_IO_H
+
+#include <charconv>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Output of a running program, one line per print. Lines collect in a large
+// buffer, integers formatted into it with to_chars, and reach the stream
+// only when the buffer fills, on flush() and on destruction; the stream
+// itself is flushed only by flush().
+//
+// With a limit, the stream receives at most that many bytes and the rest
+// is dropped; truncated() tells the program's runner to stop it.
+class OutputBuffer {
+public:
+    explicit OutputBuffer(ostream& out = cout, size_t capacity = 1 << 16);
+    OutputBuffer(const OutputBuffer&) = delete;
+    OutputBuffer& operator=(const OutputBuffer&) = delete;
+    ~OutputBuffer();
+
+    void setStream(ostream& out);  // flushes what was written so far
+    void setLimit(size_t bytes);    // from now on; 0: no limit
+    bool truncated() const { return exceeded; }
+    void flush();
+
+    void writeInt(int value) {
+        if (capacity - length < 12) drain();
+        char* end = to_chars(buffer.data() + length, buffer.data() + capacity, value).ptr;
+        *end++ = '\n';
+        length = end - buffer.data();
+    }
+
+    void writeLine(const char* text, size_t size) {
+        if (capacity - length <= size) {
+            drain();
+            if (capacity <= size) {
+                if (store(text, size)) store("\n", 1);
+                return;
+            }
+        }
+        memcpy(buffer.data() + length, text, size);
+        length += size;
+        buffer[length++] = '\n';
+    }
+
+    void writeLine(const string& text) {
+        writeLine(text.data(), text.size());
+    }
+
+private:
+    ostream* out;
+    vector<char> buffer;
+    size_t capacity;
+    size_t length = 0;
+    size_t limit = 0;
+    size_t written = 0;     // bytes given to the stream since setLimit
+    bool exceeded = false;
+
+    void drain();  // hands the buffer to the stream without flushing it
+    bool store(const char* data, size_t size);  // false when bytes were dropped
+};
+
+// Input of a running program for `san`, read from a file descriptor in
+// large blocks or from a string. A tied OutputBuffer is flushed before each
+// read that may block, so prompts appear before the program waits.
+//
+// readInt() skips whitespace, takes an optional '-' and then digits up to
+// the first other character, which is consumed too. Values wrap like the
+// language's arithmetic. At the end of the input, or when no digit follows,
+// it yields 0.
+class InputReader {
+public:
+    explicit InputReader(int fd = 0, size_t capacity = 1 << 16);
+    explicit InputReader(const string& text);
+
+    void tie(OutputBuffer* output);
+    bool readLine(string& line);  // without the newline; false at the end of the input
+    int readInt();
+
+private:
+    int fd;
+    vector<char> buffer;
+    size_t position = 0, length = 0;
+    OutputBuffer* tied = nullptr;
+
+    bool fill();
+
+    int next() {
+        if (position == length && !fill()) return -1;
+        return (unsigned char)buffer[position++];
+    }
+};
+
+// A running program stopped by an error, such as an array index out of
+// bounds. Thrown once the output printed so far has been flushed.
+class RuntimeError : public runtime_error {
+public:
+    using runtime_error::runtime_error;
+};
+
+// The error for an array index out of bounds, worded alike by every engine.
+// Generated code prints OUT_OF_BOUNDS_PREFIX, the index and then the suffix.
+static const char OUT_OF_BOUNDS_PREFIX[] = "Runtime Error: index ";
+string outOfBoundsSuffix(const string& array, long size);
+string outOfBoundsMessage(int index, const string& array, long size);
+
+#endif
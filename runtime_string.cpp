@@ -0,0 +1,206 @@
+#include "runtime_string.h"
+#include <algorithm>
+#include <new>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+// Results shorter than this are copied rather than linked into a rope.
+static const size_t ROPE_MIN = 256;
+
+static thread_local long allocated = 0;
+
+// The characters follow the header in the same allocation. Values refer to
+// the prefix [0, length) and only ever append past `used`, so bytes a value
+// can see never change.
+struct StringValue::Buffer {
+    long refs;
+    uint32_t used;
+    uint32_t capacity;
+
+    char* chars() { return reinterpret_cast<char*>(this + 1); }
+
+    static Buffer* create(size_t capacity) {
+        capacity = min<size_t>(capacity, UINT32_MAX);
+        void* memory = ::operator new(sizeof(Buffer) + capacity);
+        allocated += sizeof(Buffer) + capacity;
+        return new (memory) Buffer{1, 0, (uint32_t)capacity};
+    }
+};
+
+// Once flattened, left holds the whole string as a BUFFER and right is empty.
+struct StringValue::Rope {
+    long refs = 1;
+    bool flat = false;
+    StringValue left, right;
+};
+
+StringValue::StringValue(const StringValue& other) {
+    copyFrom(other);
+    retain();
+}
+
+StringValue::StringValue(StringValue&& other) noexcept {
+    copyFrom(other);
+    other.length = 0;
+    other.kind = SMALL;
+}
+
+StringValue& StringValue::operator=(const StringValue& other) {
+    if (this != &other) *this = StringValue(other);
+    return *this;
+}
+
+StringValue& StringValue::operator=(StringValue&& other) noexcept {
+    if (this == &other) return *this;
+    if (kind >= BUFFER) release();
+    copyFrom(other);
+    other.length = 0;
+    other.kind = SMALL;
+    return *this;
+}
+
+void StringValue::retain() const {
+    if (kind == BUFFER) buffer->refs++;
+    else if (kind == ROPE) rope->refs++;
+}
+
+void StringValue::release() {
+    if (kind == BUFFER) {
+        if (--buffer->refs == 0) {
+            allocated -= sizeof(Buffer) + buffer->capacity;
+            buffer->~Buffer();
+            ::operator delete(buffer);
+        }
+    } else if (kind == ROPE) {
+        if (--rope->refs == 0) destroy(rope);
+    }
+    kind = SMALL;
+    length = 0;
+}
+
+// Ropes built in a loop nest as deep as the loop ran, so they are freed
+// with an explicit stack instead of recursive destructors.
+void StringValue::destroy(Rope* rope) {
+    vector<Rope*> pending = {rope};
+    while (!pending.empty()) {
+        Rope* node = pending.back();
+        pending.pop_back();
+        for (StringValue* child : {&node->left, &node->right}) {
+            if (child->kind != ROPE) continue;
+            if (--child->rope->refs == 0) pending.push_back(child->rope);
+            child->kind = SMALL;
+            child->length = 0;
+        }
+        delete node;
+        allocated -= sizeof(Rope);
+    }
+}
+
+StringValue StringValue::fromBuffer(Buffer* buffer, size_t length) {
+    StringValue value;
+    value.buffer = buffer;
+    value.length = length;
+    value.kind = BUFFER;
+    return value;
+}
+
+// Copies the leaves left to right into one buffer, again without recursion.
+void StringValue::flatten(Rope* rope) {
+    if (rope->flat) return;
+    size_t size = (size_t)rope->left.length + rope->right.length;
+    Buffer* buffer = Buffer::create(size + size / 2);
+    vector<const StringValue*> pending = {&rope->right, &rope->left};
+    while (!pending.empty()) {
+        const StringValue* value = pending.back();
+        pending.pop_back();
+        if (value->kind == ROPE && !value->rope->flat) {
+            pending.push_back(&value->rope->right);
+            pending.push_back(&value->rope->left);
+            continue;
+        }
+        memcpy(buffer->chars() + buffer->used, value->data(), value->length);
+        buffer->used += value->length;
+    }
+    rope->left = fromBuffer(buffer, size);
+    rope->right = StringValue();
+    rope->flat = true;
+}
+
+StringValue StringValue::literal(const string& text) {
+    StringValue value;
+    if (text.size() <= INLINE_CAPACITY) {
+        memcpy(value.small, text.data(), text.size());
+    } else {
+        value.chars = text.data();
+        value.kind = LITERAL;
+    }
+    value.length = text.size();
+    return value;
+}
+
+StringValue StringValue::concat(const StringValue& left, const StringValue& right) {
+    if (right.length == 0) return left;
+    if (left.length == 0) return right;
+    size_t size = (size_t)left.length + right.length;
+    if (size > UINT32_MAX) throw length_error("sttring value too long");
+
+    StringValue result;
+    if (size <= INLINE_CAPACITY) {
+        memcpy(result.small, left.data(), left.length);
+        memcpy(result.small + left.length, right.data(), right.length);
+        result.length = size;
+        return result;
+    }
+
+    // A flattened rope appends through its buffer.
+    const StringValue& base = left.kind == ROPE && left.rope->flat ? left.rope->left : left;
+    bool atEnd = base.kind == BUFFER && base.buffer->used == base.length;
+    if (atEnd && size <= base.buffer->capacity) {
+        const char* chars = right.data();
+        memcpy(base.buffer->chars() + base.length, chars, right.length);
+        base.buffer->used = size;
+        base.buffer->refs++;
+        return fromBuffer(base.buffer, size);
+    }
+    if (atEnd || size < ROPE_MIN) {
+        Buffer* buffer = Buffer::create(max<size_t>(2 * size, 2 * INLINE_CAPACITY + 2));
+        memcpy(buffer->chars(), left.data(), left.length);
+        memcpy(buffer->chars() + left.length, right.data(), right.length);
+        buffer->used = size;
+        return fromBuffer(buffer, size);
+    }
+
+    Rope* rope = new Rope;
+    allocated += sizeof(Rope);
+    rope->left = left;
+    rope->right = right;
+    result.rope = rope;
+    result.length = size;
+    result.kind = ROPE;
+    return result;
+}
+
+long StringValue::allocatedBytes() {
+    return allocated;
+}
+
+const char* StringValue::data() const {
+    switch (kind) {
+    case SMALL:
+        return small;
+    case LITERAL:
+        return chars;
+    case BUFFER:
+        return buffer->chars();
+    case ROPE:
+        flatten(rope);
+        return rope->left.buffer->chars();
+    }
+    return small;
+}
+
+string StringValue::str() const {
+    return string(data(), length);
+}
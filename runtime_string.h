@@ -0,0 +1,79 @@
+#ifndef RUNTIME_STRING_H
+#define RUNTIME_STRING_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+using namespace std;
+
+// A sttring value of a running program, 24 bytes, tagged by where its
+// characters are:
+//
+//   SMALL    up to INLINE_CAPACITY bytes inside the value itself
+//   LITERAL  interned program text, owned by the program, neither counted nor freed
+//   BUFFER   a prefix of a reference-counted append buffer
+//   ROPE     a reference-counted concatenation node, flattened when first read
+//
+// concat() keeps strings built in a loop linear. A value that reaches up to
+// the end of its buffer's contents is extended in place; the values already
+// sharing the buffer keep seeing only their own prefix. Other short results
+// are copied into a new buffer with room to grow, and long ones become rope
+// nodes.
+//
+// Reference counts are not atomic: a counted value and its copies belong to
+// one thread. SMALL and LITERAL values touch no shared state.
+//
+// allocatedBytes() is what buffers and rope nodes allocated on the calling
+// thread take up, less what was freed there, so its change over a stretch of
+// a program's run is the memory that stretch's strings added.
+class StringValue {
+public:
+    static const size_t INLINE_CAPACITY = 15;
+
+    StringValue() : small{}, length(0), kind(SMALL) {}
+    StringValue(const StringValue& other);
+    StringValue(StringValue&& other) noexcept;
+    StringValue& operator=(const StringValue& other);
+    StringValue& operator=(StringValue&& other) noexcept;
+    ~StringValue() {
+        if (kind >= BUFFER) release();
+    }
+
+    // Copies short text inline and refers to longer text, which must then
+    // outlive the value and all of its copies.
+    static StringValue literal(const string& text);
+    static StringValue concat(const StringValue& left, const StringValue& right);
+    static long allocatedBytes();
+
+    size_t size() const { return length; }
+    const char* data() const;  // not terminated; flattens a rope
+    string str() const;
+
+private:
+    enum Kind : uint8_t { SMALL, LITERAL, BUFFER, ROPE };
+    struct Buffer;
+    struct Rope;
+
+    union {
+        char small[INLINE_CAPACITY];
+        const char* chars;
+        Buffer* buffer;
+        Rope* rope;
+    };
+    uint32_t length;
+    Kind kind;
+
+    void copyFrom(const StringValue& other) {
+        memcpy(small, other.small, sizeof(small));
+        length = other.length;
+        kind = other.kind;
+    }
+    void retain() const;
+    void release();
+    static StringValue fromBuffer(Buffer* buffer, size_t length);
+    static void flatten(Rope* rope);
+    static void destroy(Rope* rope);
+};
+
+#endif
@@ -1,209 +1,479 @@
-#include "semantic.h"
-#include <iostream>
-#include <regex>
-using namespace std;
-
-void SemanticAnalyzer::analyze(ParseNode* root) {
-    symbolTable.clear();
-    errors.clear();
-    loopDepth = 0;
-    currentReturnType = "intt"; 
-    traverse(root);
-}
-
-void SemanticAnalyzer::traverse(ParseNode* node) {
-    if (!node) return;
-
-    switch (node->type) {
-        case DECLARATION_NODE: {
-            size_t spacePos = node->value.find(' ');
-            string varType = node->value.substr(0, spacePos);
-            string varName = node->value.substr(spacePos + 1);
-
-            if (symbolTable.count(varName)) {
-                errors.push_back("Error: Redeclaration of variable '" + varName + "'");
-            } else {
-                symbolTable[varName] = {varType, varName};
-            }
-
-            
-            if (!node->children.empty()) {
-                string exprType = getExprType(node->children[0]);
-                if (exprType != varType) {
-                    errors.push_back("Type Error: Cannot assign type '" + exprType + "' to variable '" + varName + "' of type '" + varType + "'");
-                }
-                traverse(node->children[0]);
-            }
-            break;
-        }
-
-        case ASSIGNMENT_NODE: {
-            if (!symbolTable.count(node->value)) {
-                errors.push_back("Error: Assignment to undeclared variable '" + node->value + "'");
-            } else {
-                string varType = symbolTable[node->value].type;
-                if (!node->children.empty()) {
-                    string exprType = getExprType(node->children[0]);
-                    if (exprType != varType) {
-                        errors.push_back("Type Error: Cannot assign type '" + exprType + "' to variable '" + node->value + "' of type '" + varType + "'");
-                    }
-                    traverse(node->children[0]);
-                }
-            }
-            break;
-        }
-
-        case IDENTIFIER_NODE: {
-            if (!symbolTable.count(node->value)) {
-                errors.push_back("Error: Undeclared variable '" + node->value + "'");
-            }
-            break;
-        }
-
-        case RETURN_STATEMENT_NODE: {
-            if (!node->children.empty()) {
-                string retType = getExprType(node->children[0]);
-                if (retType != currentReturnType) {
-                    errors.push_back("Type Error: Return type '" + retType + "' does not match function return type '" + currentReturnType + "'");
-                }
-                traverse(node->children[0]);
-            }
-            break;
-        }
-
-        case FUNCTION_CALL_NODE: {
-            // Built-in function calls: prrint and san
-            string funcName = node->value;
-            if (funcName == "prrint") {
-                if (node->children.size() != 1) {
-                    errors.push_back("Error: 'prrint' expects exactly one argument");
-                } else {
-                    // Just allow intt or sttring types for now
-                    string argType = getExprType(node->children[0]);
-                    if (argType != "intt" && argType != "sttring") {
-                        errors.push_back("Type Error: 'prrint' argument must be intt or sttring, got '" + argType + "'");
-                    }
-                    traverse(node->children[0]);
-                }
-            }
-            else if (funcName == "san") {
-    if (node->children.size() != 1) {
-        errors.push_back("Error: 'san' expects exactly one argument");
-    } else {
-        string argType = getExprType(node->children[0]);
-        if (argType != "intt") {
-            errors.push_back("Type Error: 'san' argument must be of type intt, got '" + argType + "'");
-        }
-        traverse(node->children[0]);
-    }
-}
-else {
-                errors.push_back("Error: Unknown function '" + funcName + "'");
-            }
-            break;
-        }
-
-        case LOOP_STATEMENT_NODE: {
-            loopDepth++;
-            for (auto* child : node->children) traverse(child);
-            loopDepth--;
-            break;
-        }
-
-        case BREAK_STATEMENT_NODE:
-        case CONTINUE_STATEMENT_NODE: {
-            if (loopDepth == 0) {
-                errors.push_back("Error: '" + node->value + "' used outside of loop");
-            }
-            break;
-        }
-
-        default: {
-            for (auto* child : node->children) traverse(child);
-            break;
-        }
-    }
-}
-
-string SemanticAnalyzer::getExprType(ParseNode* node) {
-    if (!node) return "unknown";
-
-    switch (node->type) {
-        case NUMBER_NODE:
-            return "intt";  // Assuming all numbers are intt for now
-
-        case STRING_NODE:
-            return "sttring";
-
-        case IDENTIFIER_NODE: {
-            if (symbolTable.count(node->value)) {
-                return symbolTable[node->value].type;
-            } else {
-                errors.push_back("Error: Undeclared variable '" + node->value + "'");
-                return "unknown";
-            }
-        }
-
-        case EXPRESSION_NODE: {
-    if (node->value.size() >= 2 && node->value.front() == '"' && node->value.back() == '"') {
-        return "sttring";
-    }
-
-    if (regex_match(node->value, regex("^[0-9]+$"))) {
-        return "intt";
-    }
-
-    if (node->value == "+" || node->value == "-" || node->value == "*" || node->value == "/" ||
-        node->value == "==" || node->value == "!=" || node->value == "<" || node->value == "<=" ||
-        node->value == ">" || node->value == ">=" || node->value == "&&" || node->value == "||") {
-
-        if (node->children.size() < 2) return "unknown";
-
-        string leftType = getExprType(node->children[0]);
-        string rightType = getExprType(node->children[1]);
-
-        if (node->value == "&&" || node->value == "||") {
-            return "intt";  
-        }
-
-        if (leftType != rightType) {
-            errors.push_back("Type Error: Mismatched types '" + leftType + "' and '" + rightType + "' in operation '" + node->value + "'");
-            return "unknown";
-        }
-
-        if (node->value == "==" || node->value == "!=" ||
-            node->value == "<" || node->value == "<=" ||
-            node->value == ">" || node->value == ">=") {
-            return "intt";
-        }
-
-        return leftType; 
-    }
-
-    
-    if (symbolTable.count(node->value)) {
-        return symbolTable[node->value].type;
-    }
-
-    return "unknown"; 
-}
-
-        default:
-            return "unknown";
-    }
-}
-
-void SemanticAnalyzer::printErrors() {
-    cout << "\n--- Semantic Analysis ---\n";
-    if (errors.empty()) {
-        cout << "No semantic errors.\n";
-    } else {
-        for (const string& err : errors) {
-            cout << err << endl;
-        }
-    }
-}
-
-bool SemanticAnalyzer::hasErrors() const {
-    return !errors.empty();
-}
+#include "semantic.h"
+#include <algorithm>
+#include <iostream>
+using namespace std;
+
+// Arrays live in one flat block of 32-bit cells in every backend.
+static const long long MAX_ARRAY_SIZE = 1 << 24;
+static const long long MAX_ARRAY_ELEMENTS = 1 << 26;
+
+static bool mentions(ParseNode* node, const string& name) {
+    if (node->type == IDENTIFIER_NODE && node->value == name) return true;
+    for (auto* child : node->children) {
+        if (mentions(child, name)) return true;
+    }
+    return false;
+}
+
+void SemanticAnalyzer::analyze(ParseNode* root) {
+    symbolTable.clear();
+    errors.clear();
+    hiddenPrivates.clear();
+    parallel = nullptr;
+    loopDepth = 0;
+    arrayElements = 0;
+    currentReturnType = "intt"; 
+    traverse(root);
+}
+
+void SemanticAnalyzer::traverse(ParseNode* node) {
+    if (!node) return;
+
+    switch (node->type) {
+        case DECLARATION_NODE: {
+            size_t spacePos = node->value.find(' ');
+            string varType = node->value.substr(0, spacePos);
+            string varName = node->value.substr(spacePos + 1);
+
+            if (symbolTable.count(varName) || hiddenPrivates.count(varName)) {
+                errors.push_back("Error: Redeclaration of variable '" + varName + "'");
+            } else {
+                symbolTable[varName] = {varType, varName};
+                if (parallel) parallel->blocks.back().push_back(varName);
+            }
+            if (parallel && varType == "sttring") {
+                errors.push_back("Error: sttring variable '" + varName + "' cannot be declared in a 'ploop'");
+            }
+            if (parallel && !node->children.empty() && mentions(node->children[0], varName)) {
+                errors.push_back("Error: Private variable '" + varName + "' is read by its own initializer in a 'ploop'");
+            }
+
+            
+            if (!node->children.empty()) {
+                string exprType = getExprType(node->children[0]);
+                if (exprType != varType) {
+                    errors.push_back("Type Error: Cannot assign type '" + exprType + "' to variable '" + varName + "' of type '" + varType + "'");
+                }
+                traverse(node->children[0]);
+            }
+            break;
+        }
+
+        case ARRAY_DECLARATION_NODE: {
+            // The value is "type name"; the only child is the element count.
+            size_t spacePos = node->value.find(' ');
+            string varType = node->value.substr(0, spacePos);
+            string varName = node->value.substr(spacePos + 1);
+            const string& count = node->children[0]->value;
+            long long size = count.size() <= 9 ? stoll(count) : 0;
+
+            if (symbolTable.count(varName) || hiddenPrivates.count(varName)) {
+                errors.push_back("Error: Redeclaration of variable '" + varName + "'");
+            } else {
+                symbolTable[varName] = {varType + "[]", varName, max(size, 1LL)};
+            }
+            if (parallel) {
+                errors.push_back("Error: Array '" + varName + "' cannot be declared in a 'ploop'");
+            }
+            if (varType != "intt") {
+                errors.push_back("Type Error: Arrays of type '" + varType + "' are not supported");
+            }
+            if (size < 1 || size > MAX_ARRAY_SIZE) {
+                errors.push_back("Error: Size of array '" + varName + "' must be between 1 and " +
+                                 to_string(MAX_ARRAY_SIZE));
+            } else if (arrayElements + size > MAX_ARRAY_ELEMENTS) {
+                errors.push_back("Error: Array '" + varName + "' exceeds the limit of " +
+                                 to_string(MAX_ARRAY_ELEMENTS) + " array elements in total");
+            }
+            arrayElements += size;
+            break;
+        }
+
+        case ASSIGNMENT_NODE: {
+            if (node->children.size() == 2) {
+                // an element of an array; the second child is the index
+                ParseNode* index = node->children[1];
+                if (parallel && (index->type != IDENTIFIER_NODE || index->value != parallel->var)) {
+                    errors.push_back("Error: Array '" + node->value + "' can only be written at index '" +
+                                     parallel->var + "' in a 'ploop'");
+                }
+                if (checkIndex(node->value, node->children[1])) {
+                    string exprType = getExprType(node->children[0]);
+                    if (exprType != "intt") {
+                        errors.push_back("Type Error: Cannot assign type '" + exprType + "' to an element of array '" + node->value + "'");
+                    }
+                }
+                for (auto* child : node->children) traverse(child);
+                break;
+            }
+            if (!symbolTable.count(node->value)) {
+                errors.push_back("Error: Assignment to undeclared variable '" + node->value + "'");
+            } else if (parallel && parallel->reductions.count(node->value)) {
+                checkReduction(node);
+            } else {
+                if (parallel && node->value == parallel->var) {
+                    errors.push_back("Error: Loop variable '" + node->value + "' cannot be assigned in a 'ploop'");
+                } else if (parallel) {
+                    bool isPrivate = false;
+                    for (const auto& block : parallel->blocks) {
+                        isPrivate |= find(block.begin(), block.end(), node->value) != block.end();
+                    }
+                    if (!isPrivate) {
+                        errors.push_back("Error: Cannot assign shared variable '" + node->value +
+                                         "' in a 'ploop'; declare it in the loop or list it in 'redduce'");
+                    }
+                }
+                string varType = symbolTable[node->value].type;
+                if (!node->children.empty()) {
+                    string exprType = getExprType(node->children[0]);
+                    if (exprType != varType) {
+                        errors.push_back("Type Error: Cannot assign type '" + exprType + "' to variable '" + node->value + "' of type '" + varType + "'");
+                    }
+                    traverse(node->children[0]);
+                }
+            }
+            break;
+        }
+
+        case IDENTIFIER_NODE: {
+            if (!symbolTable.count(node->value)) {
+                errors.push_back("Error: Undeclared variable '" + node->value + "'");
+            } else if (parallel && parallel->reductions.count(node->value)) {
+                errors.push_back("Error: Reduction variable '" + node->value + "' cannot be read in a 'ploop'");
+            }
+            break;
+        }
+
+        case INDEX_NODE: {
+            ParseNode* index = node->children[0];
+            if (parallel && parallel->writtenArrays.count(node->value) &&
+                (index->type != IDENTIFIER_NODE || index->value != parallel->var)) {
+                errors.push_back("Error: Array '" + node->value + "' is written in the 'ploop', so it can only be read at index '" +
+                                 parallel->var + "' there");
+            }
+            traverse(index);
+            break;
+        }
+
+        case STATEMENT_NODE: {
+            if (!parallel) {
+                for (auto* child : node->children) traverse(child);
+                break;
+            }
+            // Variables declared in a ploop are private to one iteration and
+            // end with their block.
+            parallel->blocks.emplace_back();
+            for (auto* child : node->children) traverse(child);
+            for (const string& name : parallel->blocks.back()) {
+                symbolTable.erase(name);
+                hiddenPrivates.insert(name);
+            }
+            parallel->blocks.pop_back();
+            break;
+        }
+
+        case PARALLEL_LOOP_NODE:
+            checkParallelLoop(node);
+            break;
+
+        case RETURN_STATEMENT_NODE: {
+            if (parallel) {
+                errors.push_back("Error: 'retturn' cannot be used in a 'ploop'");
+            }
+            if (!node->children.empty()) {
+                string retType = getExprType(node->children[0]);
+                if (retType != currentReturnType) {
+                    errors.push_back("Type Error: Return type '" + retType + "' does not match function return type '" + currentReturnType + "'");
+                }
+                traverse(node->children[0]);
+            }
+            break;
+        }
+
+        case FUNCTION_CALL_NODE: {
+            // Built-in function calls: prrint and san
+            string funcName = node->value;
+            if (parallel && (funcName == "prrint" || funcName == "san")) {
+                errors.push_back("Error: '" + funcName + "' cannot be used in a 'ploop'");
+            }
+            if (funcName == "prrint") {
+                if (node->children.size() != 1) {
+                    errors.push_back("Error: 'prrint' expects exactly one argument");
+                } else {
+                    // Just allow intt or sttring types for now
+                    string argType = getExprType(node->children[0]);
+                    if (argType != "intt" && argType != "sttring") {
+                        errors.push_back("Type Error: 'prrint' argument must be intt or sttring, got '" + argType + "'");
+                    }
+                    traverse(node->children[0]);
+                }
+            }
+            else if (funcName == "san") {
+    if (node->children.size() != 1) {
+        errors.push_back("Error: 'san' expects exactly one argument");
+    } else {
+        string argType = getExprType(node->children[0]);
+        if (argType != "intt") {
+            errors.push_back("Type Error: 'san' argument must be of type intt, got '" + argType + "'");
+        }
+        if (node->children[0]->type != IDENTIFIER_NODE && node->children[0]->type != INDEX_NODE) {
+            errors.push_back("Error: 'san' argument must be a variable");
+        }
+        traverse(node->children[0]);
+    }
+}
+else {
+                errors.push_back("Error: Unknown function '" + funcName + "'");
+            }
+            break;
+        }
+
+        case IF_STATEMENT_NODE: {
+            checkCondition(node->children[0]);
+            for (auto* child : node->children) traverse(child);
+            break;
+        }
+
+        case LOOP_STATEMENT_NODE: {
+            checkCondition(node->children[0]);
+            loopDepth++;
+            for (auto* child : node->children) traverse(child);
+            loopDepth--;
+            break;
+        }
+
+        case BREAK_STATEMENT_NODE:
+        case CONTINUE_STATEMENT_NODE: {
+            if (loopDepth == 0) {
+                errors.push_back("Error: '" + node->value + "' used outside of loop");
+            } else if (parallel && loopDepth == parallel->loopDepth && node->type == BREAK_STATEMENT_NODE) {
+                errors.push_back("Error: 'brreak' cannot leave a 'ploop'");
+            }
+            break;
+        }
+
+        default: {
+            for (auto* child : node->children) traverse(child);
+            break;
+        }
+    }
+}
+
+// Array elements written by a ploop body, found before checking its reads.
+static void findWrittenArrays(ParseNode* node, unordered_set<string>& arrays) {
+    if (node->type == ASSIGNMENT_NODE && node->children.size() == 2) arrays.insert(node->value);
+    for (auto* child : node->children) findWrittenArrays(child, arrays);
+}
+
+// ploop (i = start; i < bound) redduce (s, ...) { body }: the bound is
+// evaluated once, before the first iteration.
+void SemanticAnalyzer::checkParallelLoop(ParseNode* node) {
+    ParseNode* start = node->children[0];
+    ParseNode* cond = node->children[1];
+    if (parallel) {
+        errors.push_back("Error: 'ploop' cannot be nested in another 'ploop'");
+        return;
+    }
+    const string& var = start->value;
+    auto isIntScalar = [&](const string& name) {
+        auto it = symbolTable.find(name);
+        return it == symbolTable.end() || it->second.type == "intt";  // undeclared is reported elsewhere
+    };
+    traverse(start);
+    if (!isIntScalar(var)) {
+        errors.push_back("Type Error: Loop variable '" + var + "' of a 'ploop' must be an intt variable");
+    }
+    checkCondition(cond);
+    if (cond->type != EXPRESSION_NODE || cond->value != "<" || cond->children.size() != 2 ||
+        cond->children[0]->type != IDENTIFIER_NODE || cond->children[0]->value != var) {
+        errors.push_back("Error: The condition of a 'ploop' must be '" + var + " < bound'");
+    }
+    traverse(cond);
+
+    ParallelScope scope;
+    scope.var = var;
+    scope.loopDepth = loopDepth + 1;
+    for (auto* reduction : node->children[3]->children) {
+        const string& name = reduction->value;
+        if (!symbolTable.count(name)) {
+            errors.push_back("Error: Undeclared variable '" + name + "'");
+        } else if (!isIntScalar(name)) {
+            errors.push_back("Type Error: Reduction variable '" + name + "' must be an intt variable");
+        } else if (name == var) {
+            errors.push_back("Error: Loop variable '" + name + "' cannot be a reduction variable");
+        } else if (scope.reductions.count(name)) {
+            errors.push_back("Error: Reduction variable '" + name + "' is listed twice");
+        } else {
+            scope.reductions[name] = "";
+        }
+    }
+    findWrittenArrays(node->children[2], scope.writtenArrays);
+
+    parallel = &scope;
+    loopDepth++;
+    traverse(node->children[2]);
+    loopDepth--;
+    parallel = nullptr;
+}
+
+// s = s op e1 op e2 ...: a left-leaning chain of + and - or of * that starts
+// from the reduction variable s, whose other operands do not read s.
+void SemanticAnalyzer::checkReduction(ParseNode* node) {
+    const string& name = node->value;
+    ParseNode* expr = node->children[0];
+    string kind = expr->type == EXPRESSION_NODE && expr->value == "*" ? "*" : "+";
+    auto inKind = [&](ParseNode* n) {
+        return n->type == EXPRESSION_NODE && n->children.size() == 2 &&
+               (kind == "*" ? n->value == "*" : n->value == "+" || n->value == "-");
+    };
+    vector<ParseNode*> terms;
+    ParseNode* chain = expr;
+    for (; inKind(chain); chain = chain->children[0]) terms.push_back(chain->children[1]);
+
+    string exprType = getExprType(expr);
+    if (exprType != "intt") {
+        errors.push_back("Type Error: Cannot assign type '" + exprType + "' to variable '" + name + "' of type 'intt'");
+    }
+    string& seen = parallel->reductions[name];
+    if (terms.empty() || chain->type != IDENTIFIER_NODE || chain->value != name) {
+        errors.push_back("Error: Reduction variable '" + name + "' can only be updated as '" + name + " = " + name +
+                         " + e' or '" + name + " = " + name + " * e' in a 'ploop'");
+        return;
+    }
+    if (!seen.empty() && seen != kind) {
+        errors.push_back("Error: Reduction variable '" + name + "' is both added to and multiplied in a 'ploop'");
+    }
+    seen = kind;
+    for (auto* term : terms) traverse(term);
+}
+
+void SemanticAnalyzer::checkCondition(ParseNode* node) {
+    string type = getExprType(node);
+    if (type != "intt" && type != "unknown") {
+        errors.push_back("Type Error: Condition must be of type intt, got '" + type + "'");
+    }
+}
+
+// An element access name[index]: name must be an array and the index an
+// intt, and a constant index must lie inside the array. Returns whether the
+// access is well formed.
+bool SemanticAnalyzer::checkIndex(const string& name, ParseNode* index) {
+    bool valid = true;
+    auto it = symbolTable.find(name);
+    if (it == symbolTable.end()) {
+        errors.push_back("Error: Undeclared variable '" + name + "'");
+        valid = false;
+    } else if (it->second.size == 0) {
+        errors.push_back("Type Error: Variable '" + name + "' is not an array");
+        valid = false;
+    }
+    string indexType = getExprType(index);
+    if (indexType != "intt") {
+        if (indexType != "unknown") {
+            errors.push_back("Type Error: Array index must be of type intt, got '" + indexType + "'");
+        }
+        return false;
+    }
+    if (valid && index->type == NUMBER_NODE &&
+        (index->value.size() > 9 || stoll(index->value) >= it->second.size)) {
+        errors.push_back("Error: Index " + index->value + " is out of bounds for array '" + name +
+                         "' of size " + to_string(it->second.size));
+        valid = false;
+    }
+    return valid;
+}
+
+string SemanticAnalyzer::getExprType(ParseNode* node) {
+    if (!node) return "unknown";
+
+    switch (node->type) {
+        case NUMBER_NODE:
+            return "intt";  // Assuming all numbers are intt for now
+
+        case STRING_NODE:
+            return "sttring";
+
+        case INDEX_NODE:
+            return checkIndex(node->value, node->children[0]) ? "intt" : "unknown";
+
+        case IDENTIFIER_NODE: {
+            if (symbolTable.count(node->value)) {
+                return symbolTable[node->value].type;
+            } else {
+                errors.push_back("Error: Undeclared variable '" + node->value + "'");
+                return "unknown";
+            }
+        }
+
+        case EXPRESSION_NODE: {
+    if (node->value.size() >= 2 && node->value.front() == '"' && node->value.back() == '"') {
+        return "sttring";
+    }
+
+    if (!node->value.empty() && all_of(node->value.begin(), node->value.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+        return "intt";
+    }
+
+    if (node->value == "+" || node->value == "-" || node->value == "*" || node->value == "/" ||
+        node->value == "==" || node->value == "!=" || node->value == "<" || node->value == "<=" ||
+        node->value == ">" || node->value == ">=" || node->value == "&&" || node->value == "||") {
+
+        if (node->children.size() < 2) return "unknown";
+
+        string leftType = getExprType(node->children[0]);
+        string rightType = getExprType(node->children[1]);
+
+        if (node->value == "&&" || node->value == "||") {
+            return "intt";  
+        }
+
+        if (leftType != rightType) {
+            errors.push_back("Type Error: Mismatched types '" + leftType + "' and '" + rightType + "' in operation '" + node->value + "'");
+            return "unknown";
+        }
+
+        if (leftType == "sttring" && node->value != "+") {
+            errors.push_back("Type Error: Operation '" + node->value + "' is not defined for sttring");
+            return "unknown";
+        }
+
+        if (node->value == "==" || node->value == "!=" ||
+            node->value == "<" || node->value == "<=" ||
+            node->value == ">" || node->value == ">=") {
+            return "intt";
+        }
+
+        return leftType; 
+    }
+
+    
+    if (symbolTable.count(node->value)) {
+        return symbolTable[node->value].type;
+    }
+
+    return "unknown"; 
+}
+
+        default:
+            return "unknown";
+    }
+}
+
+void SemanticAnalyzer::printErrors() {
+    cout << "\n--- Semantic Analysis ---\n";
+    if (errors.empty()) {
+        cout << "No semantic errors.\n";
+    } else {
+        for (const string& err : errors) {
+            cout << err << endl;
+        }
+    }
+}
+
+bool SemanticAnalyzer::hasErrors() const {
+    return !errors.empty();
+}
+
+const vector<string>& SemanticAnalyzer::getErrors() const {
+    return errors;
+}
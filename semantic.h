@@ -1,30 +1,52 @@
-#ifndef SEMANTIC_H
-#define SEMANTIC_H
-
-#include "parser.h"
-#include <unordered_map>
-#include <string>
-#include <vector>
-
-using namespace std;
-
-struct Symbol {
-    string type;
-    string name;
-};
-
-class SemanticAnalyzer {
-    unordered_map<string, Symbol> symbolTable;
-    vector<string> errors;
-    int loopDepth = 0; 
-    string currentReturnType = "intt"; 
-public:
-    void analyze(ParseNode* root);
-    void traverse(ParseNode* node);
-    string getExprType(ParseNode* node);  
-    void printErrors();
-    bool hasErrors() const;
-
-};
-
-#endif
+#ifndef SEMANTIC_H
+#define SEMANTIC_H
+
+#include "parser.h"
+#include <unordered_map>
+#include <unordered_set>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+struct Symbol {
+    string type;      // "intt[]" for arrays
+    string name;
+    long long size = 0;  // elements of an array
+};
+
+// The ploop being checked. Its iterations may run in any order on any
+// thread, so the body may only write variables declared inside it, which are
+// private to an iteration, the elements of arrays at the loop variable, and
+// the reduction variables, by `s = s + e` or `s = s * e`.
+struct ParallelScope {
+    string var;                                // the loop variable
+    unordered_map<string, string> reductions;  // name -> "+" or "*", "" until updated
+    unordered_set<string> writtenArrays;
+    vector<vector<string>> blocks;             // private declarations per open block
+    int loopDepth = 0;                         // of the ploop itself
+};
+
+class SemanticAnalyzer {
+    unordered_map<string, Symbol> symbolTable;
+    unordered_set<string> hiddenPrivates;  // declared in a ploop block that has ended
+    ParallelScope* parallel = nullptr;
+    vector<string> errors;
+    int loopDepth = 0; 
+    long long arrayElements = 0;  // declared so far, over all arrays
+    string currentReturnType = "intt"; 
+public:
+    void analyze(ParseNode* root);
+    void traverse(ParseNode* node);
+    string getExprType(ParseNode* node);  
+    void checkCondition(ParseNode* node);
+    bool checkIndex(const string& name, ParseNode* index);
+    void checkParallelLoop(ParseNode* node);
+    void checkReduction(ParseNode* node);
+    void printErrors();
+    bool hasErrors() const;
+    const vector<string>& getErrors() const;
+
+};
+
+#endif
@@ -0,0 +1,43 @@
+#!/usr/bin/env bash
+# tests/bench_dispatch.sh [EXECUTABLE] [RUNS]
+#
+# Dispatch microbenchmark: runs the loop-heavy programs in tests/bench at -O0
+# and -O2 with --dispatch=switch and --dispatch=threaded, and reports the
+# bytecode instructions executed, the best interpreter time of RUNS runs
+# (default 5) and the throughput in millions of instructions per second.
+#
+# EXECUTABLE defaults to ./executable.exe, built from the command on the first
+# line of executable.cpp when it is missing.
+
+cd "$(dirname "$0")/.." || exit 1
+exe=${1:-./executable.exe}
+runs=${2:-5}
+if [ ! -x "$exe" ]; then
+    echo "building $exe"
+    eval "$(head -n 1 executable.cpp | sed 's|^//||; s|-o executable.exe|-o '"$exe"'|')" || exit 1
+fi
+
+# field NAME FILE: the number after NAME in the --stats output in FILE.
+field() {
+    awk -v name="$1" '$1 == name { print $2; exit }' "$2"
+}
+
+tmp=$(mktemp)
+trap 'rm -f "$tmp"' EXIT
+printf '%-10s %-5s %-9s %14s %10s %12s\n' program level dispatch instructions "best ms" "M instr/s"
+for program in tests/bench/loops.txt tests/bench/collatz.txt; do
+    name=$(basename "$program" .txt)
+    for level in -O0 -O2; do
+        for dispatch in switch threaded; do
+            best=
+            for ((run = 0; run < runs; run++)); do
+                "$exe" "$level" --stats "--dispatch=$dispatch" < "$program" > "$tmp" || exit 1
+                ms=$(field time "$tmp")
+                if [ -z "$best" ] || awk -v a="$ms" -v b="$best" 'BEGIN { exit !(a < b) }'; then best=$ms; fi
+            done
+            executed=$(field executed "$tmp")
+            awk -v p="$name" -v l="$level" -v d="$(field dispatch "$tmp")" -v n="$executed" -v ms="$best" \
+                'BEGIN { printf "%-10s %-5s %-9s %14d %10.3f %12.1f\n", p, l, d, n, ms, n / ms / 1000 }'
+        done
+    done
+done
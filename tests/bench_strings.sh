@@ -0,0 +1,41 @@
+#!/usr/bin/env bash
+# tests/bench_strings.sh [EXECUTABLE] [RUNS]
+#
+# String-building benchmark: runs the tests/bench/str_*.txt programs at -O0
+# and -O2 and reports the bytecode instructions executed and the best
+# interpreter time of RUNS runs (default 5). The programs append and prepend
+# one character 100k times, build 20k lines of 50 appends and concatenate a
+# shared prefix 400k times; with append buffers each of them runs in time
+# linear in the number of concatenations.
+#
+# EXECUTABLE defaults to ./executable.exe, built from the command on the first
+# line of executable.cpp when it is missing.
+
+cd "$(dirname "$0")/.." || exit 1
+exe=${1:-./executable.exe}
+runs=${2:-5}
+if [ ! -x "$exe" ]; then
+    echo "building $exe"
+    eval "$(head -n 1 executable.cpp | sed 's|^//||; s|-o executable.exe|-o '"$exe"'|')" || exit 1
+fi
+
+# field NAME FILE: the number after NAME in the --stats output in FILE.
+field() {
+    awk -v name="$1" '$1 == name { print $2; exit }' "$2"
+}
+
+tmp=$(mktemp)
+trap 'rm -f "$tmp"' EXIT
+printf '%-12s %-5s %14s %10s\n' program level instructions "best ms"
+for program in tests/bench/str_*.txt; do
+    name=$(basename "$program" .txt)
+    for level in -O0 -O2; do
+        best=
+        for ((run = 0; run < runs; run++)); do
+            "$exe" "$level" --stats < "$program" > "$tmp" || exit 1
+            ms=$(field time "$tmp")
+            if [ -z "$best" ] || awk -v a="$ms" -v b="$best" 'BEGIN { exit !(a < b) }'; then best=$ms; fi
+        done
+        printf '%-12s %-5s %14d %10.3f\n' "$name" "$level" "$(field executed "$tmp")" "$best"
+    done
+done
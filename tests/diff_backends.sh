@@ -0,0 +1,110 @@
+#!/usr/bin/env bash
+# tests/diff_backends.sh [EXECUTABLE] [BACKEND...]
+#
+# Runs every program in tests/programs at -O0 to -O3 on each backend and
+# compares its output, errors and exit status with the interpreter's: the
+# tree engine (tree) and the JIT (jit) of executable.exe, and the executables
+# it writes with --native (native) and --native-c (c). BACKENDs select some of
+# them; all are run by default, so `tests/diff_backends.sh "" c` tests the C
+# backend alone. A program holds its input after a line with `#`.
+# The programs return 0, so every backend exits with 0, or 1 after a runtime
+# error. A backend that rejects a program (sttring values) is skipped.
+#
+# EXECUTABLE defaults to ./executable.exe, built from the command on the first
+# line of executable.cpp when it is missing.
+
+cd "$(dirname "$0")/.." || exit 1
+exe=${1:-./executable.exe}
+shift
+backends=" ${*:-tree jit native c} "
+if [ ! -x "$exe" ]; then
+    echo "building $exe"
+    eval "$(head -n 1 executable.cpp | sed 's|^//||; s|-o executable.exe|-o '"$exe"'|')" || exit 1
+fi
+
+tmp=$(mktemp -d)
+trap 'rm -rf "$tmp"' EXIT
+failed=0
+checked=0
+skipped=0
+
+# run NAME FILE COMMAND...: runs COMMAND with the program in FILE on stdin and
+# keeps its stdout, stderr and exit status in $tmp/NAME.{out,err,status}.
+run() {
+    local name=$1 file=$2
+    shift 2
+    timeout 20 "$@" < "$file" > "$tmp/$name.out" 2> "$tmp/$name.err"
+    echo $? > "$tmp/$name.status"
+}
+
+# output NAME: strips what the driver prints before the program's output.
+output() {
+    sed -n '/^--- Output ---$/,$p' "$tmp/$1.out" | tail -n +2 > "$tmp/$1.run"
+    mv "$tmp/$1.run" "$tmp/$1.out"
+}
+
+# selected BACKEND: whether BACKEND is tested.
+selected() {
+    [[ $backends == *" $1 "* ]]
+}
+
+# compare PROGRAM NAME: reports where NAME differs from the interpreter.
+compare() {
+    local part
+    checked=$((checked + 1))
+    for part in out err status; do
+        if ! cmp -s "$tmp/ref.$part" "$tmp/$2.$part"; then
+            echo "FAIL $1 $2: $part differs from the interpreter"
+            diff "$tmp/ref.$part" "$tmp/$2.$part" | head -n 10
+            failed=$((failed + 1))
+            return
+        fi
+    done
+}
+
+for program in tests/programs/*.txt; do
+    name=$(basename "$program" .txt)
+    sed -n '/^#$/,$p' "$program" | tail -n +2 > "$tmp/input"
+
+    selected tree && run tree "$program" "$exe" --engine=tree
+    for level in -O0 -O1 -O2 -O3; do
+        run ref "$program" "$exe" "$level"
+        if ! grep -q '^--- Output ---$' "$tmp/ref.out"; then
+            echo "FAIL $name $level: not compiled"
+            cat "$tmp/ref.out" "$tmp/ref.err" | tail -n 5
+            failed=$((failed + 1))
+            continue
+        fi
+        output ref
+        selected tree && compare "$name $level" tree
+
+        rm -f "$tmp/native" "$tmp/c"
+        run build "$program" "$exe" "$level" "--native=$tmp/native" "--native-c=$tmp/c"
+        if cat "$tmp/build.out" "$tmp/build.err" | grep -q "only supported by the interpreter"; then
+            for backend in jit native c; do
+                selected $backend && skipped=$((skipped + 1))
+            done
+            continue
+        fi
+
+        if selected jit; then
+            run jit "$program" "$exe" "$level" --engine=jit
+            output jit
+            compare "$name $level" jit
+        fi
+
+        for backend in native c; do
+            selected $backend || continue
+            if [ -x "$tmp/$backend" ]; then
+                run "$backend" "$tmp/input" "$tmp/$backend"
+                compare "$name $level" "$backend"
+            else
+                echo "FAIL $name $level $backend: no executable was written"
+                failed=$((failed + 1))
+            fi
+        done
+    done
+done
+
+echo "$checked runs checked, $skipped skipped, $failed failed"
+[ "$failed" -eq 0 ]
@@ -0,0 +1,34 @@
+#!/usr/bin/env bash
+# tests/profile_roundtrip.sh [EXECUTABLE]
+#
+# Profiles tests/programs/trips.txt, whose inner loop runs 9 times per entry,
+# at -O2 and at -O3, then compiles it at -O3 with each profile. Both must
+# unroll the loop by the measured 8 (`- n, 7`) instead of the default 4,
+# although the -O3 profile is taken of the loop already unrolled by 4.
+#
+# EXECUTABLE defaults to ./executable.exe, built from the command on the first
+# line of executable.cpp when it is missing.
+
+cd "$(dirname "$0")/.." || exit 1
+exe=${1:-./executable.exe}
+if [ ! -x "$exe" ]; then
+    echo "building $exe"
+    eval "$(head -n 1 executable.cpp | sed 's|^//||; s|-o executable.exe|-o '"$exe"'|')" || exit 1
+fi
+
+tmp=$(mktemp -d)
+trap 'rm -rf "$tmp"' EXIT
+program=tests/programs/trips.txt
+failed=0
+for level in -O2 -O3; do
+    "$exe" "$level" "--profile-out=$tmp/profile" < "$program" > /dev/null
+    "$exe" -O3 "--profile-use=$tmp/profile" < "$program" | sed -n '/^--- Optimized Code ---$/,/^$/p' > "$tmp/code"
+    if grep -q '^- n, 7 => ' "$tmp/code"; then
+        echo "ok: profile taken at $level unrolls by 8"
+    else
+        echo "FAIL: profile taken at $level does not unroll by 8"
+        grep '^- n, ' "$tmp/code"
+        failed=1
+    fi
+done
+exit $failed
@@ -0,0 +1,132 @@
+#include "thread_pool.h"
+#include <chrono>
+using namespace std;
+
+// Worker index of the current thread within currentPool, so tasks submitted
+// from a worker go to its own queue.
+static thread_local ThreadPool* currentPool = nullptr;
+static thread_local int currentIndex = -1;
+
+ThreadPool::ThreadPool(unsigned threads) {
+    if (threads == 0) threads = max(1u, thread::hardware_concurrency());
+    for (unsigned i = 0; i < threads; ++i) queues.emplace_back(new Queue());
+    for (unsigned i = 0; i < threads; ++i) workers.emplace_back(&ThreadPool::run, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        lock_guard<mutex> guard(sleepLock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers) worker.join();
+}
+
+unsigned ThreadPool::size() const {
+    return workers.size();
+}
+
+void ThreadPool::submit(function<void()> task) {
+    unsigned index = currentPool == this ? currentIndex : nextQueue++ % queues.size();
+    pending++;
+    {
+        lock_guard<mutex> guard(queues[index]->lock);
+        queues[index]->tasks.push_back(move(task));
+    }
+    queued++;
+    {
+        lock_guard<mutex> guard(sleepLock);
+    }
+    wake.notify_one();
+    idle.notify_all();
+}
+
+// Own queue from the back (most recently pushed, still warm), then steal the
+// oldest task of another queue.
+bool ThreadPool::take(int home, function<void()>& task) {
+    if (queued == 0) return false;
+    int count = queues.size();
+    for (int k = 0; k < count; ++k) {
+        int index = home >= 0 ? (home + k) % count : k;
+        Queue& queue = *queues[index];
+        lock_guard<mutex> guard(queue.lock);
+        if (queue.tasks.empty()) continue;
+        if (index == home) {
+            task = move(queue.tasks.back());
+            queue.tasks.pop_back();
+        } else {
+            task = move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+        queued--;
+        return true;
+    }
+    return false;
+}
+
+// Taking sleepLock before notifying closes the window between a waiter
+// checking its predicate and going to sleep.
+void ThreadPool::finished() {
+    pending--;
+    {
+        lock_guard<mutex> guard(sleepLock);
+    }
+    idle.notify_all();
+}
+
+void ThreadPool::run(unsigned index) {
+    currentPool = this;
+    currentIndex = index;
+    function<void()> task;
+    while (true) {
+        if (take(index, task)) {
+            task();
+            task = nullptr;
+            finished();
+            continue;
+        }
+        unique_lock<mutex> guard(sleepLock);
+        wake.wait(guard, [&] { return stopping || queued > 0; });
+        if (stopping && queued == 0) return;
+    }
+}
+
+void ThreadPool::wait() {
+    function<void()> task;
+    while (pending > 0) {
+        if (take(-1, task)) {
+            task();
+            task = nullptr;
+            finished();
+            continue;
+        }
+        unique_lock<mutex> guard(sleepLock);
+        idle.wait(guard, [&] { return pending == 0 || queued > 0; });
+    }
+}
+
+void ThreadPool::parallelFor(size_t count, size_t grain, const function<void(size_t, size_t)>& body) {
+    if (count == 0) return;
+    if (grain == 0) grain = 1;
+    auto remaining = make_shared<atomic<size_t>>((count + grain - 1) / grain);
+    for (size_t begin = 0; begin < count; begin += grain) {
+        size_t end = min(count, begin + grain);
+        submit([&body, begin, end, remaining] {
+            body(begin, end);
+            remaining->fetch_sub(1);
+        });
+    }
+
+    function<void()> task;
+    int home = currentPool == this ? currentIndex : -1;
+    while (*remaining > 0) {
+        if (take(home, task)) {
+            task();
+            task = nullptr;
+            finished();
+            continue;
+        }
+        unique_lock<mutex> guard(sleepLock);
+        idle.wait(guard, [&] { return *remaining == 0 || queued > 0; });
+    }
+}
@@ -0,0 +1,54 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Work-stealing thread pool. Every worker owns a deque: it pushes and pops
+// its own tasks at the back and, when empty, steals from the front of the
+// others. Threads waiting for work they submitted run queued tasks instead
+// of blocking, so parallelFor may be called from inside a task.
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned threads = 0);  // 0: one per hardware thread
+    ~ThreadPool();
+
+    void submit(function<void()> task);
+    void wait();  // until every submitted task has finished; not from inside a task
+
+    // Runs body(begin, end) over [0, count) in chunks of at most `grain`
+    // items and returns once all chunks are done.
+    void parallelFor(size_t count, size_t grain, const function<void(size_t, size_t)>& body);
+
+    unsigned size() const;
+
+private:
+    struct Queue {
+        deque<function<void()>> tasks;
+        mutex lock;
+    };
+
+    vector<unique_ptr<Queue>> queues;
+    vector<thread> workers;
+    mutex sleepLock;
+    condition_variable wake;   // workers: tasks queued or stopping
+    condition_variable idle;   // waiters: something finished or was queued
+    atomic<size_t> queued{0};
+    atomic<size_t> pending{0};
+    atomic<unsigned> nextQueue{0};
+    bool stopping = false;
+
+    void run(unsigned index);
+    bool take(int home, function<void()>& task);
+    void finished();
+};
+
+#endif
@@ -0,0 +1,317 @@
+#include "tree_interpreter.h"
+#include "icg.h"
+#include <chrono>
+#include <climits>
+#include <iomanip>
+#include <iostream>
+
+void TreeInterpreter::setOutput(ostream& out) {
+    output.setStream(out);
+}
+
+void TreeInterpreter::setInput(InputReader& in) {
+    input = &in;
+}
+
+int TreeInterpreter::execute(ParseNode* root) {
+    reset();
+    resolve(root);
+    ints.resize(names.size(), 0);
+    assigned.assign(names.size(), 0);
+    strings.resize(names.size());
+
+    auto start = chrono::steady_clock::now();
+    input->tie(&output);
+    try {
+        exec(root);
+    } catch (...) {
+        input->tie(nullptr);
+        output.flush();
+        throw;
+    }
+    input->tie(nullptr);
+    output.flush();
+    auto end = chrono::steady_clock::now();
+    milliseconds = chrono::duration<double, milli>(end - start).count();
+    return returnValue;
+}
+
+void TreeInterpreter::printStatistics() {
+    cout << "\n--- Tree Interpreter ---\n";
+    cout << left << setw(22) << "slots" << names.size() << "\n";
+    size_t cellCount = cells.size();
+    if (cellCount) cout << setw(22) << "arrays" << cellCount << " cells\n";
+    cout << setw(22) << "evaluated" << steps << " nodes\n";
+    cout << setw(22) << "time" << fixed << setprecision(3) << milliseconds << " ms\n";
+    cout << right << defaultfloat;
+}
+
+void TreeInterpreter::reset() {
+    slots.clear();
+    arrayIds.clear();
+    names.clear();
+    stringSlot.clear();
+    ints.clear();
+    strings.clear();
+    arrays.clear();
+    cells.clear();
+    texts.clear();
+    parallelDepth = 0;
+    returnValue = 0;
+    steps = 0;
+}
+
+// ---- Resolution ----
+
+int TreeInterpreter::slot(const string& name, bool isString) {
+    auto it = slots.find(name);
+    if (it != slots.end()) return it->second;
+    int id = names.size();
+    slots[name] = id;
+    names.push_back(name);
+    stringSlot.push_back(isString);
+    return id;
+}
+
+static string declaredName(const string& declaration) {
+    size_t space = declaration.find(' ');
+    return space == string::npos ? declaration : declaration.substr(space + 1);
+}
+
+void TreeInterpreter::resolve(ParseNode* node) {
+    if (!node) return;
+    switch (node->type) {
+        case DECLARATION_NODE:
+            node->resolved = slot(declaredName(node->value), node->value.rfind("sttring ", 0) == 0);
+            break;
+        case ARRAY_DECLARATION_NODE: {
+            string name = declaredName(node->value);
+            if (!arrayIds.count(name)) {
+                int size = node->children.empty() ? 0 : stoi(node->children[0]->value);
+                arrayIds[name] = arrays.size();
+                arrays.push_back({(int)cells.size(), size, name});
+                cells.resize(cells.size() + size, 0);
+            }
+            node->resolved = arrayIds[name];
+            return;
+        }
+        case ASSIGNMENT_NODE:
+        case INDEX_NODE:
+            if (node->type == INDEX_NODE || node->children.size() == 2) node->resolved = arrayIds[node->value];
+            else node->resolved = slot(node->value);
+            break;
+        case IDENTIFIER_NODE:
+            node->resolved = slot(node->value);
+            break;
+        case NUMBER_NODE: {
+            // Like the IR interpreter, a literal std::stoi rejects only fails when reached.
+            try {
+                int value = stoi(node->value);
+                node->resolved = slot("#" + node->value);
+                ints.resize(names.size(), 0);
+                ints[node->resolved] = value;
+            } catch (const exception&) {
+                node->resolved = -1;
+            }
+            break;
+        }
+        case STRING_NODE: {
+            size_t known = names.size();
+            node->resolved = slot(node->value, true);
+            if (names.size() > known) {
+                strings.resize(names.size());
+                texts.push_back(literalText(node->value));
+                strings[node->resolved] = StringValue::literal(texts.back());
+            }
+            break;
+        }
+        case EXPRESSION_NODE: {
+            static const unordered_map<string, int> operators = {
+                {"+", ADD}, {"-", SUB}, {"*", MUL}, {"/", DIV}, {"<", LT},
+                {">", GT}, {"<=", LE}, {">=", GE}, {"==", EQ}, {"!=", NE}};
+            auto it = operators.find(node->value);
+            node->resolved = it != operators.end() ? it->second : OTHER;
+            break;
+        }
+        default:
+            break;
+    }
+    for (ParseNode* child : node->children) resolve(child);
+}
+
+// ---- Statements ----
+
+TreeInterpreter::Flow TreeInterpreter::exec(ParseNode* node) {
+    ++steps;
+    switch (node->type) {
+        case PROGRAM_NODE:
+        case STATEMENT_NODE:
+            for (ParseNode* child : node->children) {
+                Flow flow = exec(child);
+                if (flow != NEXT) return flow;
+            }
+            return NEXT;
+        case DECLARATION_NODE: {
+            int target = node->resolved;
+            if (stringSlot[target]) {
+                strings[target] = node->children.empty() ? StringValue() : evalString(node->children[0]);
+            } else if (!node->children.empty()) {
+                ints[target] = evalInt(node->children[0]);
+                assigned[target] = 1;
+            } else if (parallelDepth) {
+                // Privates of a ploop start every iteration at 0.
+                ints[target] = 0;
+                assigned[target] = 1;
+            }
+            return NEXT;
+        }
+        case ASSIGNMENT_NODE: {
+            if (node->children.size() == 2) {
+                const Array& array = arrays[node->resolved];
+                int cell = element(node->children[1], array);
+                cells[cell] = evalInt(node->children[0]);
+            } else if (stringSlot[node->resolved]) {
+                strings[node->resolved] = evalString(node->children[0]);
+            } else {
+                ints[node->resolved] = evalInt(node->children[0]);
+                assigned[node->resolved] = 1;
+            }
+            return NEXT;
+        }
+        case IF_STATEMENT_NODE:
+            if (evalInt(node->children[0])) return exec(node->children[1]);
+            if (node->children.size() > 2) return exec(node->children[2]);
+            return NEXT;
+        case LOOP_STATEMENT_NODE:
+            while (evalInt(node->children[0])) {
+                Flow flow = exec(node->children[1]);
+                if (flow == BREAK) break;
+                if (flow == RETURN) return RETURN;
+            }
+            return NEXT;
+        case PARALLEL_LOOP_NODE: {
+            // The bound is evaluated once and the loop variable ends at it.
+            exec(node->children[0]);
+            int var = node->children[0]->resolved;
+            int bound = evalInt(node->children[1]->children[1]);
+            ++parallelDepth;
+            while (ints[var] < bound) {
+                Flow flow = exec(node->children[2]);
+                if (flow == RETURN) {
+                    --parallelDepth;
+                    return RETURN;
+                }
+                ints[var] = (int)((unsigned)ints[var] + 1u);
+            }
+            --parallelDepth;
+            return NEXT;
+        }
+        case BREAK_STATEMENT_NODE:
+            return BREAK;
+        case CONTINUE_STATEMENT_NODE:
+            return CONTINUE;
+        case RETURN_STATEMENT_NODE:
+            returnValue = node->children.empty() ? 0 : evalInt(node->children[0]);
+            return RETURN;
+        case FUNCTION_CALL_NODE:
+            if (node->value == "prrint") {
+                print(node->children.empty() ? nullptr : node->children[0]);
+            } else if (node->value == "san" && !node->children.empty()) {
+                ParseNode* target = node->children[0];
+                if (target->type == INDEX_NODE) {
+                    int cell = element(target->children[0], arrays[target->resolved]);
+                    cells[cell] = input->readInt();
+                } else if (target->type == IDENTIFIER_NODE) {
+                    ints[target->resolved] = input->readInt();
+                    assigned[target->resolved] = 1;
+                }
+            }
+            return NEXT;
+        default:
+            return NEXT;
+    }
+}
+
+void TreeInterpreter::print(ParseNode* node) {
+    if (!node) {
+        output.writeLine("", 0);
+    } else if (isString(node)) {
+        StringValue value = evalString(node);
+        output.writeLine(value.data(), value.size());
+    } else if (node->type == IDENTIFIER_NODE) {
+        if (assigned[node->resolved]) output.writeInt(ints[node->resolved]);
+        else output.writeLine(node->value);
+    } else if (node->type == NUMBER_NODE) {
+        output.writeLine(node->value);  // as written, like the IR interpreter
+    } else {
+        output.writeInt(evalInt(node));
+    }
+}
+
+// ---- Expressions ----
+
+int TreeInterpreter::element(ParseNode* index, const Array& array) {
+    int value = evalInt(index);
+    if (value < 0 || value >= array.size) {
+        throw RuntimeError(outOfBoundsMessage(value, array.name, array.size));
+    }
+    return array.base + value;
+}
+
+int TreeInterpreter::evalInt(ParseNode* node) {
+    ++steps;
+    switch (node->type) {
+        case NUMBER_NODE:
+            if (node->resolved < 0) stoi(node->value);  // throws, as the IR interpreter did
+            return ints[node->resolved];
+        case IDENTIFIER_NODE:
+            return ints[node->resolved];
+        case INDEX_NODE:
+            return cells[element(node->children[0], arrays[node->resolved])];
+        case EXPRESSION_NODE: {
+            if (node->children.size() != 2) return 0;
+            unsigned a = evalInt(node->children[0]);
+            unsigned b = evalInt(node->children[1]);
+            switch (node->resolved) {
+                case ADD: return (int)(a + b);
+                case SUB: return (int)(a - b);
+                case MUL: return (int)(a * b);
+                case DIV:
+                    if (b == 0) return 0;
+                    if ((int)a == INT_MIN && (int)b == -1) return INT_MIN;
+                    return (int)a / (int)b;
+                case LT: return (int)a < (int)b;
+                case GT: return (int)a > (int)b;
+                case LE: return (int)a <= (int)b;
+                case GE: return (int)a >= (int)b;
+                case EQ: return a == b;
+                case NE: return a != b;
+                default: return 0;
+            }
+        }
+        default:
+            return 0;
+    }
+}
+
+StringValue TreeInterpreter::evalString(ParseNode* node) {
+    ++steps;
+    if (node->type == EXPRESSION_NODE && node->children.size() == 2) {
+        return StringValue::concat(evalString(node->children[0]), evalString(node->children[1]));
+    }
+    if (node->type == STRING_NODE || node->type == IDENTIFIER_NODE) return strings[node->resolved];
+    return StringValue();
+}
+
+bool TreeInterpreter::isString(ParseNode* node) const {
+    switch (node->type) {
+        case STRING_NODE:
+            return true;
+        case IDENTIFIER_NODE:
+            return stringSlot[node->resolved];
+        case EXPRESSION_NODE:
+            return node->resolved == ADD && !node->children.empty() && isString(node->children[0]);
+        default:
+            return false;
+    }
+}
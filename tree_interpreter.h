@@ -0,0 +1,70 @@
+#ifndef TREE_INTERPRETER_H
+#define TREE_INTERPRETER_H
+
+#include <deque>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "parser.h"
+#include "runtime_io.h"
+#include "runtime_string.h"
+
+using namespace std;
+
+// Runs a checked parse tree directly, without intermediate code, for scripts
+// too short to repay lowering and optimizing them. Programs behave as under
+// the bytecode interpreter at -O0: intt arithmetic wraps, division by zero
+// yields 0, printing a variable that was never assigned prints its name, and
+// an array index out of bounds throws RuntimeError once the output so far is
+// flushed. A ploop runs its iterations in order.
+//
+// A first pass gives every variable, array and literal a slot and every
+// operator a code (ParseNode::resolved), so evaluation never looks up names.
+class TreeInterpreter {
+public:
+    void setOutput(ostream& out);  // cout by default
+    void setInput(InputReader& in);  // `san` reads 0 without one
+
+    // Runs until the end of the program or a `retturn`; yields the returned value, or 0.
+    int execute(ParseNode* root);
+    void printStatistics();  // of the last execute()
+
+private:
+    enum Flow { NEXT, BREAK, CONTINUE, RETURN };
+    enum Operator { ADD, SUB, MUL, DIV, LT, GT, LE, GE, EQ, NE, OTHER };
+    struct Array {
+        int base, size;
+        string name;
+    };
+
+    unordered_map<string, int> slots;     // variable -> slot
+    unordered_map<string, int> arrayIds;  // array -> index in arrays
+    vector<string> names;                 // per slot, printed while unassigned
+    vector<char> stringSlot;              // per slot
+    vector<int> ints;                     // per slot; literals hold their value
+    vector<char> assigned;
+    vector<StringValue> strings;
+    vector<Array> arrays;
+    vector<int> cells;
+    deque<string> texts;                  // string literals, referred to by strings
+    OutputBuffer output;
+    InputReader noInput{string()};
+    InputReader* input = &noInput;
+    int parallelDepth = 0;
+    int returnValue = 0;
+    long steps = 0;           // statements and expressions evaluated
+    double milliseconds = 0;
+
+    void reset();
+    void resolve(ParseNode* node);
+    int slot(const string& name, bool isString = false);
+    Flow exec(ParseNode* node);
+    void print(ParseNode* node);
+    int evalInt(ParseNode* node);
+    StringValue evalString(ParseNode* node);
+    bool isString(ParseNode* node) const;
+    int element(ParseNode* index, const Array& array);  // checked cell index
+};
+
+#endif
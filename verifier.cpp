@@ -0,0 +1,101 @@
+#include "verifier.h"
+#include <iostream>
+#include <unordered_set>
+using namespace std;
+
+static bool isBinaryOp(const string& op) {
+    return op == "+" || op == "-" || op == "*" || op == "/" || op == "%" ||
+           op == "<" || op == ">" || op == "<=" || op == ">=" || op == "==" || op == "!=";
+}
+
+bool IRVerifier::verify(const vector<Instruction>& instructions) {
+    errors.clear();
+
+    unordered_set<string> labels, arrays;
+    for (size_t i = 0; i < instructions.size(); ++i) {
+        const Instruction& instr = instructions[i];
+        if (instr.op == "array") {
+            if (!arrays.insert(instr.result).second) {
+                errors.push_back("Error: duplicate array '" + instr.result + "' at instruction " + to_string(i));
+            }
+            if (instr.arg1.empty() || instr.arg1.find_first_not_of("0123456789") != string::npos ||
+                instr.arg1.find_first_not_of('0') == string::npos) {
+                errors.push_back("Error: array '" + instr.result + "' without a positive size at instruction " + to_string(i));
+            }
+        }
+        if (instr.op != "label") continue;
+        if (instr.result.empty()) {
+            errors.push_back("Error: label without a name at instruction " + to_string(i));
+        } else if (!labels.insert(instr.result).second) {
+            errors.push_back("Error: duplicate label '" + instr.result + "' at instruction " + to_string(i));
+        }
+    }
+
+    for (size_t i = 0; i < instructions.size(); ++i) {
+        const Instruction& instr = instructions[i];
+        string where = " at instruction " + to_string(i);
+
+        if (instr.op == "goto" || instr.op == "ifFalse" || instr.op == "jumptable" || instr.op == "case") {
+            if (!labels.count(instr.result)) {
+                errors.push_back("Error: '" + instr.op + "' to undefined label '" + instr.result + "'" + where);
+            }
+            if ((instr.op == "ifFalse" || instr.op == "jumptable") && instr.arg1.empty()) {
+                errors.push_back("Error: '" + instr.op + "' without a condition" + where);
+            }
+            if (instr.op == "jumptable" && (i + 1 >= instructions.size() || instructions[i + 1].op != "case")) {
+                errors.push_back("Error: 'jumptable' without case entries" + where);
+            }
+            if (instr.op == "case" && (i == 0 || (instructions[i - 1].op != "jumptable" &&
+                                                  instructions[i - 1].op != "case"))) {
+                errors.push_back("Error: 'case' entry outside a jump table" + where);
+            }
+        } else if (instr.op == "=" || instr.op.empty()) {
+            if (instr.result.empty() || instr.arg1.empty()) {
+                errors.push_back("Error: copy with a missing operand" + where);
+            }
+        } else if (isBinaryOp(instr.op)) {
+            if (instr.result.empty() || instr.arg1.empty() || instr.arg2.empty()) {
+                errors.push_back("Error: '" + instr.op + "' with a missing operand" + where);
+            }
+        } else if (instr.op == "read") {
+            if (instr.result.empty()) {
+                errors.push_back("Error: 'read' without a target" + where);
+            }
+        } else if (instr.op == "load" || instr.op == "store" || instr.op == "bounds") {
+            const string& array = instr.op == "load" ? instr.arg1 : instr.result;
+            if (!arrays.count(array)) {
+                errors.push_back("Error: '" + instr.op + "' on undeclared array '" + array + "'" + where);
+            }
+            if (instr.arg1.empty() || instr.arg2.empty() || instr.result.empty()) {
+                errors.push_back("Error: '" + instr.op + "' with a missing operand" + where);
+            }
+        } else if (instr.op == "parallel" || instr.op == "reduce") {
+            if (instr.arg1.empty() || instr.arg2.empty()) {
+                errors.push_back("Error: '" + instr.op + "' with a missing operand" + where);
+            }
+        } else if (instr.op == "call") {
+            if (instr.result.empty()) {
+                errors.push_back("Error: 'call' without a function name" + where);
+            }
+        } else if (instr.op != "label" && instr.op != "array" && instr.op != "param" &&
+                   instr.op != "print" && instr.op != "return") {
+            errors.push_back("Error: unknown operation '" + instr.op + "'" + where);
+        }
+    }
+
+    return errors.empty();
+}
+
+void IRVerifier::printErrors() {
+    for (const string& err : errors) {
+        cerr << err << endl;
+    }
+}
+
+bool IRVerifier::hasErrors() const {
+    return !errors.empty();
+}
+
+const vector<string>& IRVerifier::getErrors() const {
+    return errors;
+}
@@ -0,0 +1,22 @@
+#ifndef VERIFIER_H
+#define VERIFIER_H
+
+#include "icg.h"
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Structural checks on the three-address code: known opcodes, required
+// operands present, labels unique, every jump target defined and every
+// accessed array declared exactly once, with a size.
+class IRVerifier {
+    vector<string> errors;
+public:
+    bool verify(const vector<Instruction>& instructions);
+    void printErrors();
+    bool hasErrors() const;
+    const vector<string>& getErrors() const;
+};
+
+#endif
@@ -0,0 +1,1160 @@
+#include "x86gen.h"
+#include "elf.h"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+using namespace std;
+
+// Size of the runtime's output buffer; it is flushed when a line might not fit.
+static const long OUTPUT_BUFFER = 1 << 16;
+// Size of the runtime's input buffer, refilled by one read(2) when empty.
+static const long INPUT_BUFFER = 1 << 16;
+
+// Allocatable registers, most preferred first: those the runtime leaves
+// alone, then the ones it clobbers, which are saved around runtime calls
+// while live. rax, rcx and rdx are scratch and rbx holds the frame.
+static const vector<int> ALLOCATABLE = {R12, R13, R14, R15, RBP, R10, RSI, RDI, R8, R9, R11};
+// With parallel loops, r15 holds the shared frame in their chunks.
+static const vector<int> PARALLEL_ALLOCATABLE = {R12, R13, R14, RBP, R10, RSI, RDI, R8, R9, R11};
+
+// A chunk's private slot for the end of its range.
+static const char CHUNK_LIMIT[] = "$limit";
+// Chunks per thread a parallel loop is cut into, as in the interpreter.
+static const long CHUNKS_PER_THREAD = 4;
+// Threads an executable runs parallel loops on at most, and their stack size.
+static const long MAX_THREADS = 16;
+static const long THREAD_STACK = 1 << 14;
+
+static bool isCallerSaved(int r) {
+    return r == RSI || r == RDI || r == R8 || r == R9 || r == R11;
+}
+
+// Same notion of a number literal as the interpreter.
+static bool isLiteral(const string& s) {
+    if (s.empty()) return false;
+    for (char c : s) {
+        if (!isdigit(c) && c != '-') return false;
+    }
+    return true;
+}
+
+static bool isName(const string& s) {
+    return !s.empty() && s[0] != '"' && !isLiteral(s);
+}
+
+static MachineOperand reg(int r) {
+    return regOperand(r);
+}
+
+static MachineOperand imm(long long value) {
+    return immOperand(value);
+}
+
+static MachineOperand sym(const string& name) {
+    return symbolOperand(name);
+}
+
+X86Generator::X86Generator(X86Target target) : target(target), allocator(ALLOCATABLE) {}
+
+void X86Generator::emit(const string& op, const MachineOperand& dst) {
+    program.text.push_back({op, MachineOperand(), dst});
+}
+
+void X86Generator::emit(const string& op, const MachineOperand& src, const MachineOperand& dst) {
+    program.text.push_back({op, src, dst});
+}
+
+void X86Generator::emitLabel(const string& name) {
+    emit("label", sym(name));
+}
+
+string X86Generator::newLabel() {
+    return ".Lx" + to_string(labelCount++);
+}
+
+// IR labels become assembler-local symbols.
+static string irLabel(const string& name) {
+    return ".L_" + name;
+}
+
+string X86Generator::stringLabel(const string& text) {
+    auto it = strings.find(text);
+    if (it != strings.end()) return it->second;
+    string label = ".Lstr" + to_string(strings.size());
+    strings[text] = label;
+    program.strings.push_back({label, text});
+    return label;
+}
+
+MachineOperand X86Generator::slot(const string& name) {
+    return memOperand(RBX, slots[name]);
+}
+
+MachineOperand X86Generator::location(const string& name) {
+    int r = allocator.registerOf(name);
+    return r == NO_REGISTER ? slot(name) : reg(r);
+}
+
+static bool sameLocation(const MachineOperand& a, const MachineOperand& b) {
+    return a.kind == b.kind && a.base == b.base && a.value == b.value && a.symbol == b.symbol;
+}
+
+// Literals become immediates and variables their location; anything else
+// (string literals, missing operands) reads as 0, as in the interpreter.
+MachineOperand X86Generator::value(const string& arg) {
+    if (isLiteral(arg)) return imm((int)strtoll(arg.c_str(), nullptr, 10));
+    if (isName(arg)) return location(arg);
+    return imm(0);
+}
+
+void X86Generator::markAssigned(const string& name) {
+    auto flag = flags.find(name);
+    if (flag != flags.end()) emit("movb", imm(1), memOperand(RBX, flag->second));
+}
+
+// Stores eax into a variable.
+void X86Generator::store(const string& name) {
+    emit("movl", reg(RAX), location(name));
+    markAssigned(name);
+}
+
+// Pushes the runtime-clobbered registers that hold live values across the
+// current instruction.
+vector<int> X86Generator::saveRegisters() {
+    vector<int> saved;
+    for (int r : allocator.registersLiveAcross(position)) {
+        if (isCallerSaved(r)) saved.push_back(r);
+    }
+    for (int r : saved) emit("pushq", reg(r));
+    return saved;
+}
+
+void X86Generator::restoreRegisters(const vector<int>& saved) {
+    for (auto it = saved.rbegin(); it != saved.rend(); ++it) emit("popq", reg(*it));
+}
+
+void X86Generator::lowerCopy(const Instruction& instr) {
+    MachineOperand source = value(instr.arg1);
+    MachineOperand target = location(instr.result);
+    if (sameLocation(source, target)) return;
+    if (source.kind == MachineOperand::MEM && target.kind == MachineOperand::MEM) {
+        emit("movl", source, reg(RAX));
+        source = reg(RAX);
+    }
+    emit("movl", source, target);
+    markAssigned(instr.result);
+}
+
+// Results in a register are computed in place unless the second operand
+// lives in that register; everything else goes through eax.
+void X86Generator::lowerBinary(const Instruction& instr) {
+    static const unordered_map<string, string> arithmetic = {{"+", "addl"}, {"-", "subl"}, {"*", "imull"}};
+    static const unordered_map<string, string> conditions = {
+        {"<", "setl"}, {">", "setg"}, {"<=", "setle"}, {">=", "setge"}, {"==", "sete"}, {"!=", "setne"}};
+
+    MachineOperand left = value(instr.arg1), right = value(instr.arg2);
+    MachineOperand target = location(instr.result);
+    auto op = arithmetic.find(instr.op);
+    if (op != arithmetic.end()) {
+        MachineOperand work = target.kind == MachineOperand::REG && !sameLocation(right, target) ? target : reg(RAX);
+        if (!sameLocation(left, work)) emit("movl", left, work);
+        emit(op->second, right, work);
+        if (sameLocation(work, target)) markAssigned(instr.result);
+        else store(instr.result);
+        return;
+    }
+
+    if (left.kind == MachineOperand::IMM || (left.kind == MachineOperand::MEM && right.kind == MachineOperand::MEM)) {
+        emit("movl", left, reg(RAX));
+        left = reg(RAX);
+    }
+    emit("cmpl", right, left);
+    emit(conditions.at(instr.op), reg(RAX));
+    if (target.kind == MachineOperand::REG) {
+        emit("movzbl", reg(RAX), target);
+        markAssigned(instr.result);
+    } else {
+        emit("movzbl", reg(RAX), reg(RAX));
+        store(instr.result);
+    }
+}
+
+// Division and remainder by zero give 0 like the interpreter; a divisor of
+// -1 is handled without idiv so INT_MIN / -1 wraps instead of trapping.
+void X86Generator::lowerDivision(const Instruction& instr) {
+    bool remainder = instr.op == "%";
+    MachineOperand divisor = value(instr.arg2);
+    emit("movl", value(instr.arg1), reg(RAX));
+    emit("movl", divisor, reg(RCX));
+
+    if (divisor.kind == MachineOperand::IMM && divisor.value != 0 && divisor.value != -1) {
+        emit("cltd");
+        emit("idivl", reg(RCX));
+        if (remainder) emit("movl", reg(RDX), reg(RAX));
+        store(instr.result);
+        return;
+    }
+
+    string byZero = newLabel(), byMinusOne = newLabel(), done = newLabel();
+    emit("testl", reg(RCX), reg(RCX));
+    emit("je", sym(byZero));
+    emit("cmpl", imm(-1), reg(RCX));
+    emit("je", sym(byMinusOne));
+    emit("cltd");
+    emit("idivl", reg(RCX));
+    if (remainder) emit("movl", reg(RDX), reg(RAX));
+    emit("jmp", sym(done));
+    emitLabel(byMinusOne);
+    if (remainder) emit("xorl", reg(RAX), reg(RAX));
+    else emit("negl", reg(RAX));
+    emit("jmp", sym(done));
+    emitLabel(byZero);
+    emit("xorl", reg(RAX), reg(RAX));
+    emitLabel(done);
+    store(instr.result);
+}
+
+// Bounds check, then an indirect jump through a table of label offsets
+// placed right after the jump.
+void X86Generator::lowerJumpTable(const vector<Instruction>& code, size_t& i) {
+    const Instruction& instr = code[i];
+    vector<string> targets;
+    while (i + 1 < code.size() && code[i + 1].op == "case") targets.push_back(code[++i].result);
+
+    if (targets.empty()) {
+        emit("jmp", sym(irLabel(instr.result)));
+        return;
+    }
+    string table = newLabel();
+    emit("movl", value(instr.arg1), reg(RAX));
+    emit("subl", value(instr.arg2), reg(RAX));
+    emit("cmpl", imm(targets.size()), reg(RAX));
+    emit("jae", sym(irLabel(instr.result)));
+    emit("leaq", ripOperand(table), reg(RDX));
+    emit("movslq", memOperand(RDX, RAX, 4), reg(RAX));
+    emit("addq", reg(RDX), reg(RAX));
+    emit("jmp", reg(RAX));
+    emitLabel(table);
+    for (const auto& target : targets) emit(".long", sym(table), sym(irLabel(target)));
+}
+
+// Elements are addressed as rbx + offset + 4 * index. An index in a register
+// is used as a 64-bit index directly: every write to an allocated register is
+// a 32-bit operation, which clears the upper half. Constant indices also go
+// through a register, so the peephole never mistakes an element for a slot.
+MachineOperand X86Generator::element(const string& array, const string& index) {
+    MachineOperand i = value(index);
+    if (i.kind != MachineOperand::REG) {
+        emit("movl", i, reg(RCX));
+        i = reg(RCX);
+    }
+    return memOperand(arrayBase, i.base, 4, arrays[array].offset);
+}
+
+void X86Generator::lowerLoad(const Instruction& instr) {
+    MachineOperand source = element(instr.arg1, instr.arg2);
+    MachineOperand target = location(instr.result);
+    if (target.kind == MachineOperand::REG) {
+        emit("movl", source, target);
+        markAssigned(instr.result);
+    } else {
+        emit("movl", source, reg(RAX));
+        store(instr.result);
+    }
+}
+
+void X86Generator::lowerStore(const Instruction& instr) {
+    MachineOperand target = element(instr.result, instr.arg1);
+    MachineOperand source = value(instr.arg2);
+    if (source.kind == MachineOperand::MEM) {
+        emit("movl", source, reg(RAX));
+        source = reg(RAX);
+    }
+    emit("movl", source, target);
+}
+
+string X86Generator::arrayFailure(const string& array) {
+    ArrayFrame& frame = arrays[array];
+    if (frame.failure.empty()) {
+        frame.failure = newLabel();
+        failures.push_back({frame.failure, array});
+    }
+    return frame.failure;
+}
+
+// One unsigned comparison covers both ends of the range; a constant index
+// is decided here. In a chunk the index goes to edx and the chunk's own
+// stub returns.
+void X86Generator::lowerBounds(const Instruction& instr) {
+    string failure = arrayFailure(instr.result);
+    int indexRegister = RDI;
+    if (!chunkReturn.empty()) {
+        auto stub = find_if(chunkFailures.begin(), chunkFailures.end(),
+                            [&](const pair<string, string>& f) { return f.second == instr.result; });
+        if (stub == chunkFailures.end()) stub = chunkFailures.insert(stub, {newLabel(), instr.result});
+        failure = stub->first;
+        indexRegister = RDX;
+    }
+    long size = arrays[instr.result].size;
+    MachineOperand index = value(instr.arg1);
+    if (index.kind == MachineOperand::IMM) {
+        if (index.value < 0 || index.value >= size) {
+            emit("movl", index, reg(indexRegister));
+            emit("jmp", sym(failure));
+        }
+        return;
+    }
+    checks.push_back({newLabel(), index, failure});
+    emit("cmpl", imm(size), index);
+    emit("jae", sym(checks.back().label));
+}
+
+// Each array's stub passes the index in edi and the rest of the message to
+// rt_fail, which does not return to it.
+void X86Generator::emitFailures() {
+    for (const auto& check : checks) {
+        emitLabel(check.label);
+        emit("movl", check.index, reg(RDI));
+        emit("jmp", sym(check.failure));
+    }
+    for (const auto& failure : failures) {
+        string suffix = outOfBoundsSuffix(failure.second, arrays[failure.second].size);
+        emitLabel(failure.first);
+        emit("leaq", ripOperand(stringLabel(suffix)), reg(RSI));
+        emit("movl", imm(suffix.size()), reg(RDX));
+        emit("call", sym("rt_fail"));
+        if (target == TARGET_JIT) emit("jmp", sym(".Ljit_return"));
+    }
+}
+
+void X86Generator::printString(const string& text) {
+    emit("leaq", ripOperand(stringLabel(text)), reg(RSI));
+    emit("movl", imm(text.size()), reg(RDX));
+    emit("call", sym("rt_print_str"));
+}
+
+void X86Generator::lowerPrint(const string& arg) {
+    auto flag = flags.find(arg);
+    if (flag == flags.end()) {
+        printString(isStringLiteral(arg) ? literalText(arg) : arg);
+        return;
+    }
+    string unassigned = newLabel(), done = newLabel();
+    emit("cmpb", imm(0), memOperand(RBX, flag->second));
+    emit("je", sym(unassigned));
+    emit("movl", location(arg), reg(RDI));
+    emit("call", sym("rt_print_int"));
+    emit("jmp", sym(done));
+    emitLabel(unassigned);
+    printString(arg);
+    emitLabel(done);
+}
+
+void X86Generator::lowerInstruction(const vector<Instruction>& code, size_t& i) {
+    const auto& instr = code[i];
+    const string& op = instr.op;
+    if (op == "" || op == "=" || op == "MOV") {
+        lowerCopy(instr);
+    } else if (op == "+" || op == "-" || op == "*" || op == "<" || op == ">" ||
+               op == "<=" || op == ">=" || op == "==" || op == "!=") {
+        lowerBinary(instr);
+    } else if (op == "/" || op == "%") {
+        lowerDivision(instr);
+    } else if (op == "label") {
+        emitLabel(irLabel(instr.result));
+    } else if (op == "goto") {
+        emit("jmp", sym(irLabel(instr.result)));
+    } else if (op == "ifFalse") {
+        MachineOperand condition = value(instr.arg1);
+        if (condition.kind == MachineOperand::IMM) {
+            if (condition.value == 0) emit("jmp", sym(irLabel(instr.result)));
+        } else if (condition.kind == MachineOperand::REG) {
+            emit("testl", condition, condition);
+            emit("je", sym(irLabel(instr.result)));
+        } else {
+            emit("cmpl", imm(0), condition);
+            emit("je", sym(irLabel(instr.result)));
+        }
+    } else if (op == "jumptable") {
+        lowerJumpTable(code, i);
+    } else if (op == "load") {
+        lowerLoad(instr);
+    } else if (op == "store") {
+        lowerStore(instr);
+    } else if (op == "bounds") {
+        lowerBounds(instr);
+    } else if (op == "print") {
+        vector<int> saved = saveRegisters();
+        lowerPrint(instr.arg1);
+        restoreRegisters(saved);
+    } else if (op == "read") {
+        vector<int> saved = saveRegisters();
+        emit("call", sym("rt_read_int"));
+        restoreRegisters(saved);
+        store(instr.result);
+    } else if (op == "param") {
+        params.push_back(instr.arg1.empty() ? instr.result : instr.arg1);
+    } else if (op == "call") {
+        if (instr.result == "prrint" && !params.empty()) {
+            vector<int> saved = saveRegisters();
+            emit("movl", value(params.back()), reg(RDI));
+            emit("call", sym("rt_print_int"));
+            restoreRegisters(saved);
+            params.clear();
+        }
+    } else if (op == "return") {
+        if (target == TARGET_JIT) {
+            emit("movl", value(instr.arg1), reg(RAX));
+            emit("jmp", sym(".Ljit_return"));
+        } else {
+            emit("movl", value(instr.arg1), reg(RDI));
+            emit("call", sym("rt_exit"));
+        }
+    }
+}
+
+// The loop's header, body and back edge become its chunk function, left
+// where the loop was: the program runs the chunks through rt_parallel and
+// jumps over the function to the exit. Registers live at the header are
+// passed through the frame both ways.
+void X86Generator::lowerParallel(const vector<Instruction>& code, const ParallelLoop& loop) {
+    position = loop.header;
+    vector<pair<string, int>> live;
+    for (const auto& interval : allocator.getIntervals()) {
+        if (interval.reg != NO_REGISTER && interval.start <= loop.header && interval.end >= loop.header)
+            live.push_back({interval.name, interval.reg});
+    }
+    vector<pair<string, int>> reductions;
+    for (const auto& reduction : loop.reductions) {
+        bool seen = find_if(reductions.begin(), reductions.end(), [&](const pair<string, int>& r) {
+                        return r.first == reduction.first;
+                    }) != reductions.end();
+        if (isName(reduction.first) && !seen) reductions.push_back(reduction);
+    }
+    bool checked = false;
+    for (int i = loop.body; i < loop.increment; ++i) checked = checked || code[i].op == "bounds";
+    string header = irLabel(code[loop.header].result), exit = irLabel(code[loop.exit].result);
+    string chunk = newLabel(), failed = newLabel(), done = newLabel();
+
+    for (const auto& var : live) emit("movl", reg(var.second), slot(var.first));
+    emit("movl", value(loop.var), reg(RSI));
+    emit("movl", value(loop.bound), reg(RDX));
+    emit("cmpl", reg(RDX), reg(RSI));
+    emit("jge", sym(exit));
+    emit("leaq", ripOperand(chunk), reg(RDI));
+    emit("call", sym("rt_parallel"));
+    if (checked) {
+        emit("testl", reg(RAX), reg(RAX));
+        emit("jne", sym(failed));
+    }
+    for (const auto& var : live) emit("movl", slot(var.first), reg(var.second));
+    emit("movl", value(loop.bound), reg(RAX));
+    store(loop.var);
+    emit("jmp", sym(exit));
+
+    // ParallelChunk(rdi: private frame, rsi: shared frame, edx: lo, ecx: hi)
+    emitLabel(chunk);
+    for (int r : {RBX, RBP, R12, R13, R14, R15}) emit("pushq", reg(r));
+    emit("movq", reg(RDI), reg(RBX));
+    emit("movq", reg(RSI), reg(R15));
+    emit("movl", reg(RDX), slot(loop.var));
+    emit("movl", reg(RCX), slot(CHUNK_LIMIT));
+    for (const auto& reduction : reductions) emit("movl", imm(reduction.second), slot(reduction.first));
+    for (const auto& var : live) emit("movl", slot(var.first), reg(var.second));
+    arrayBase = R15;
+    chunkReturn = newLabel();
+    chunkFailures.clear();
+    chunkChecks = checks.size();
+
+    emitLabel(header);
+    MachineOperand var = location(loop.var);
+    if (var.kind != MachineOperand::REG) {
+        emit("movl", var, reg(RAX));
+        var = reg(RAX);
+    }
+    emit("cmpl", slot(CHUNK_LIMIT), var);
+    emit("jge", sym(done));
+    for (size_t i = loop.body; i < (size_t)loop.backEdge; ++i) {
+        position = i;
+        lowerInstruction(code, i);
+    }
+    emit("jmp", sym(header));
+
+    // a reduction not live at the header is not read in the loop or after it
+    emitLabel(done);
+    for (const auto& reduction : reductions) {
+        const string& name = reduction.first;
+        bool inRegister = find_if(live.begin(), live.end(), [&](const pair<string, int>& v) {
+                              return v.first == name;
+                          }) != live.end();
+        if (!inRegister && allocator.registerOf(name) != NO_REGISTER) continue;
+        MachineOperand partial = location(name), total = memOperand(R15, slots[name]);
+        if (reduction.second == 0) {
+            if (partial.kind != MachineOperand::REG) {
+                emit("movl", partial, reg(RAX));
+                partial = reg(RAX);
+            }
+            emit("lock addl", partial, total);
+        } else {
+            string retry = newLabel();
+            emit("movl", partial, reg(RCX));
+            emitLabel(retry);
+            emit("movl", total, reg(RAX));
+            emit("movl", reg(RAX), reg(RDX));
+            emit("imull", reg(RCX), reg(RDX));
+            emit("lock cmpxchgl", reg(RDX), total);
+            emit("jne", sym(retry));
+        }
+        auto flag = flags.find(name);
+        if (flag != flags.end()) {
+            string unassigned = newLabel();
+            emit("cmpb", imm(0), memOperand(RBX, flag->second));
+            emit("je", sym(unassigned));
+            emit("movb", imm(1), memOperand(R15, flag->second));
+            emitLabel(unassigned);
+        }
+    }
+    emit("xorl", reg(RAX), reg(RAX));
+    emitLabel(chunkReturn);
+    for (int r : {R15, R14, R13, R12, RBP, RBX}) emit("popq", reg(r));
+    emit("ret");
+
+    // the chunk's bounds stubs return the number of the program's stub
+    for (size_t k = chunkChecks; k < checks.size(); ++k) {
+        emitLabel(checks[k].label);
+        emit("movl", checks[k].index, reg(RDX));
+        emit("jmp", sym(checks[k].failure));
+    }
+    checks.resize(chunkChecks);
+    auto stubNumber = [&](const string& array) {
+        return find_if(failures.begin(), failures.end(), [&](const pair<string, string>& f) {
+                   return f.second == array;
+               }) - failures.begin() + 1;
+    };
+    for (const auto& failure : chunkFailures) {
+        emitLabel(failure.first);
+        emit("movl", imm(stubNumber(failure.second)), reg(RAX));
+        emit("jmp", sym(chunkReturn));
+    }
+    arrayBase = RBX;
+    chunkReturn.clear();
+
+    // back in the program: the stub of the array that failed
+    if (!checked) return;
+    emitLabel(failed);
+    emit("movl", reg(RDX), reg(RDI));
+    for (size_t k = 0; k + 1 < chunkFailures.size(); ++k) {
+        emit("cmpl", imm(stubNumber(chunkFailures[k].second)), reg(RAX));
+        emit("je", sym(arrays[chunkFailures[k].second].failure));
+    }
+    emit("jmp", sym(chunkFailures.empty() ? exit : arrays[chunkFailures.back().second].failure));
+}
+
+MachineProgram X86Generator::generate(const vector<Instruction>& code) {
+    program = MachineProgram();
+    slots.clear();
+    flags.clear();
+    arrays.clear();
+    failures.clear();
+    checks.clear();
+    strings.clear();
+    params.clear();
+    labelCount = 0;
+    errors.clear();
+    parallelLoops.clear();
+    for (size_t i = 0; i < code.size(); ++i) {
+        ParallelLoop loop;
+        if (code[i].op == "parallel" && findParallelLoop(code, i, loop)) parallelLoops[loop.header] = loop;
+    }
+
+    // Frame layout: a slot per variable, then the assigned bytes of printed
+    // variables that have a definition (the others always print their name),
+    // then the arrays.
+    vector<string> printed, declared;
+    unordered_map<string, bool> defined;
+    long header = target == TARGET_JIT ? JIT_FRAME_HEADER : 0;
+    auto addSlot = [&](const string& name) {
+        if (isName(name) && !slots.count(name)) {
+            int offset = header + slots.size() * 4;
+            slots[name] = offset;
+        }
+    };
+    for (const auto& instr : code) {
+        if (instr.op == "label" || instr.op == "goto" || instr.op == "case" || instr.op == "call") continue;
+        if (instr.op == "array") {
+            if (!arrays.count(instr.result)) {
+                arrays[instr.result] = {0, strtol(instr.arg1.c_str(), nullptr, 10), ""};
+                declared.push_back(instr.result);
+            }
+            continue;
+        }
+        if (instr.op != "load") addSlot(instr.arg1);
+        addSlot(instr.arg2);
+        if (instr.op == "param" && instr.arg1.empty()) addSlot(instr.result);
+        if (writesResult(instr)) {
+            addSlot(instr.result);
+            defined[instr.result] = true;
+        }
+        if (instr.op == "print" && isName(instr.arg1)) printed.push_back(instr.arg1);
+    }
+    if (!parallelLoops.empty()) addSlot(CHUNK_LIMIT);
+    frameSize = header + slots.size() * 4;
+    for (const auto& name : printed) {
+        if (defined.count(name) && !flags.count(name)) flags[name] = frameSize++;
+    }
+    frameSize = (frameSize + 3) & ~3L;
+    localsSize = frameSize;
+    for (const auto& name : declared) {
+        arrays[name].offset = frameSize;
+        frameSize += arrays[name].size * 4;
+    }
+
+    allocator = RegisterAllocator(parallelLoops.empty() ? ALLOCATABLE : PARALLEL_ALLOCATABLE);
+    allocator.allocate(code);
+    if (target == TARGET_JIT) {
+        program.entry = "jit_entry";
+        emitLabel(program.entry);
+        for (int r : {RBX, RBP, R12, R13, R14, R15}) emit("pushq", reg(r));
+        emit("movq", reg(RDI), reg(RBX));
+    } else {
+        emitLabel(program.entry);
+        emit("leaq", ripOperand("rt_frame"), reg(RBX));
+    }
+    // registers of variables read before any assignment must start at 0
+    vector<bool> cleared(R15 + 1, false);
+    for (const auto& interval : allocator.getIntervals()) {
+        if (interval.reg == NO_REGISTER || cleared[interval.reg]) continue;
+        cleared[interval.reg] = true;
+        emit("xorl", reg(interval.reg), reg(interval.reg));
+    }
+
+    for (size_t i = 0; i < code.size(); ++i) {
+        auto loop = parallelLoops.find(i);
+        if (loop != parallelLoops.end()) {
+            lowerParallel(code, loop->second);
+            i = loop->second.backEdge;
+            continue;
+        }
+        position = i;
+        lowerInstruction(code, i);
+    }
+
+    if (target == TARGET_JIT) {
+        emit("xorl", reg(RAX), reg(RAX));
+        emitLabel(".Ljit_return");
+        for (int r : {R15, R14, R13, R12, RBP, RBX}) emit("popq", reg(r));
+        emit("ret");
+    } else {
+        emit("xorl", reg(RDI), reg(RDI));
+        emit("call", sym("rt_exit"));
+    }
+    emitFailures();
+
+    // the runtime is written by hand, only the program goes through the peephole
+    peephole.optimize(program.text, {"rt_exit", "rt_fail"}, {"rt_parallel"});
+    if (target == TARGET_JIT) {
+        emitJitRuntime();
+    } else {
+        emitRuntime();
+        if (!parallelLoops.empty()) emitParallelRuntime();
+        program.bss.push_back({"rt_frame", max(16L, (frameSize + 15) & ~15L)});
+    }
+    return program;
+}
+
+void X86Generator::setThreads(unsigned threads) {
+    this->threads = threads;
+}
+
+long X86Generator::getFrameSize() const {
+    return frameSize;
+}
+
+long X86Generator::getLocalsSize() const {
+    return localsSize;
+}
+
+int X86Generator::getParallelLoops() const {
+    return parallelLoops.size();
+}
+
+// ---- Runtime ----
+// rt_print_int(edi) and rt_print_str(rsi, rdx) append a line to the output
+// buffer, rt_read_int returns the next integer of the input in eax and
+// rt_exit(edi) flushes the output and exits. They clobber rax, rcx, rdx,
+// rsi, rdi, r8, r9 and r11 and leave every other register alone.
+// rt_fail(edi, rsi, rdx) flushes the output, writes OUT_OF_BOUNDS_PREFIX,
+// the index in edi and the rest of the message to stderr and exits with
+// status 1. rt_parallel(rdi, esi, edx) runs the ParallelChunk in rdi over
+// [esi, edx) and returns the first failed chunk's result in eax and edx.
+
+void X86Generator::emitRuntime() {
+    MachineOperand length = ripOperand("rt_outlen");
+
+    // rt_flush: write(1, rt_outbuf, rt_outlen)
+    emitLabel("rt_flush");
+    emit("movq", length, reg(RDX));
+    emit("testq", reg(RDX), reg(RDX));
+    emit("je", sym(".Lrt_flushed"));
+    emit("leaq", ripOperand("rt_outbuf"), reg(RSI));
+    emit("movl", imm(1), reg(RDI));
+    emit("movl", imm(1), reg(RAX));
+    emit("syscall");
+    emit("movq", imm(0), length);
+    emitLabel(".Lrt_flushed");
+    emit("ret");
+
+    // rt_print_int: digits are produced backwards into rt_digits
+    emitLabel("rt_print_int");
+    emit("movl", reg(RDI), reg(R8));
+    emit("cmpq", imm(OUTPUT_BUFFER - 16), length);
+    emit("jb", sym(".Lrt_int_room"));
+    emit("call", sym("rt_flush"));
+    emitLabel(".Lrt_int_room");
+    emit("leaq", ripOperand("rt_digits", 16), reg(RCX));
+    emit("movl", reg(R8), reg(RAX));
+    emit("testl", reg(RAX), reg(RAX));
+    emit("jns", sym(".Lrt_int_digits"));
+    emit("negl", reg(RAX));
+    emitLabel(".Lrt_int_digits");
+    emit("movl", imm(10), reg(R9));
+    emitLabel(".Lrt_int_next");
+    emit("xorl", reg(RDX), reg(RDX));
+    emit("divl", reg(R9));
+    emit("addl", imm('0'), reg(RDX));
+    emit("decq", reg(RCX));
+    emit("movb", reg(RDX), memOperand(RCX));
+    emit("testl", reg(RAX), reg(RAX));
+    emit("jne", sym(".Lrt_int_next"));
+    emit("testl", reg(R8), reg(R8));
+    emit("jns", sym(".Lrt_int_copy"));
+    emit("decq", reg(RCX));
+    emit("movb", imm('-'), memOperand(RCX));
+    emitLabel(".Lrt_int_copy");
+    emit("leaq", ripOperand("rt_outbuf"), reg(RDI));
+    emit("addq", length, reg(RDI));
+    emit("leaq", ripOperand("rt_digits", 16), reg(RSI));
+    emitLabel(".Lrt_int_byte");
+    emit("movb", memOperand(RCX), reg(RDX));
+    emit("movb", reg(RDX), memOperand(RDI));
+    emit("incq", reg(RCX));
+    emit("incq", reg(RDI));
+    emit("cmpq", reg(RSI), reg(RCX));
+    emit("jne", sym(".Lrt_int_byte"));
+    emit("movb", imm('\n'), memOperand(RDI));
+    emit("incq", reg(RDI));
+    emit("leaq", ripOperand("rt_outbuf"), reg(RAX));
+    emit("subq", reg(RAX), reg(RDI));
+    emit("movq", reg(RDI), length);
+    emit("ret");
+
+    // rt_print_str: copied a byte at a time, flushing whenever the buffer fills
+    emitLabel("rt_print_str");
+    emit("movq", reg(RSI), reg(R8));
+    emit("movq", reg(RDX), reg(R9));
+    emitLabel(".Lrt_str_next");
+    emit("cmpq", imm(OUTPUT_BUFFER - 1), length);
+    emit("jb", sym(".Lrt_str_room"));
+    emit("call", sym("rt_flush"));
+    emitLabel(".Lrt_str_room");
+    emit("movq", length, reg(RAX));
+    emit("leaq", ripOperand("rt_outbuf"), reg(RDI));
+    emit("testq", reg(R9), reg(R9));
+    emit("je", sym(".Lrt_str_end"));
+    emit("movb", memOperand(R8), reg(RCX));
+    emit("movb", reg(RCX), memOperand(RDI, RAX, 1));
+    emit("incq", length);
+    emit("incq", reg(R8));
+    emit("decq", reg(R9));
+    emit("jmp", sym(".Lrt_str_next"));
+    emitLabel(".Lrt_str_end");
+    emit("movb", imm('\n'), memOperand(RDI, RAX, 1));
+    emit("incq", length);
+    emit("ret");
+
+    // rt_getc: the next input byte in eax, or -1 at the end of the input.
+    // The output is flushed before reading, so prompts appear first.
+    MachineOperand position = ripOperand("rt_inpos");
+    emitLabel("rt_getc");
+    emit("movq", position, reg(RAX));
+    emit("cmpq", ripOperand("rt_inlen"), reg(RAX));
+    emit("jb", sym(".Lrt_getc_byte"));
+    emit("call", sym("rt_flush"));
+    emit("xorl", reg(RAX), reg(RAX));
+    emit("xorl", reg(RDI), reg(RDI));
+    emit("leaq", ripOperand("rt_inbuf"), reg(RSI));
+    emit("movl", imm(INPUT_BUFFER), reg(RDX));
+    emit("syscall");
+    emit("testq", reg(RAX), reg(RAX));
+    emit("jg", sym(".Lrt_getc_filled"));
+    emit("movl", imm(-1), reg(RAX));
+    emit("ret");
+    emitLabel(".Lrt_getc_filled");
+    emit("movq", reg(RAX), ripOperand("rt_inlen"));
+    emit("xorl", reg(RAX), reg(RAX));
+    emitLabel(".Lrt_getc_byte");
+    emit("leaq", ripOperand("rt_inbuf"), reg(RCX));
+    emit("movzbl", memOperand(RCX, RAX, 1), reg(RDX));
+    emit("incq", reg(RAX));
+    emit("movq", reg(RAX), position);
+    emit("movl", reg(RDX), reg(RAX));
+    emit("ret");
+
+    // rt_read_int: whitespace, an optional '-', then digits accumulated in
+    // r8 until the first other byte; r9 is set for a minus sign
+    emitLabel("rt_read_int");
+    emit("xorl", reg(R8), reg(R8));
+    emit("xorl", reg(R9), reg(R9));
+    emitLabel(".Lrt_read_space");
+    emit("call", sym("rt_getc"));
+    emit("testl", reg(RAX), reg(RAX));
+    emit("js", sym(".Lrt_read_done"));
+    emit("cmpl", imm(' '), reg(RAX));
+    emit("jbe", sym(".Lrt_read_space"));
+    emit("cmpl", imm('-'), reg(RAX));
+    emit("jne", sym(".Lrt_read_digit"));
+    emit("movl", imm(1), reg(R9));
+    emitLabel(".Lrt_read_next");
+    emit("call", sym("rt_getc"));
+    emitLabel(".Lrt_read_digit");
+    emit("subl", imm('0'), reg(RAX));
+    emit("cmpl", imm(9), reg(RAX));
+    emit("ja", sym(".Lrt_read_sign"));
+    emit("imull", imm(10), reg(R8));
+    emit("addl", reg(RAX), reg(R8));
+    emit("jmp", sym(".Lrt_read_next"));
+    emitLabel(".Lrt_read_sign");
+    emit("testl", reg(R9), reg(R9));
+    emit("je", sym(".Lrt_read_done"));
+    emit("negl", reg(R8));
+    emitLabel(".Lrt_read_done");
+    emit("movl", reg(R8), reg(RAX));
+    emit("ret");
+
+    // rt_exit: flush, then exit_group(edi)
+    emitLabel("rt_exit");
+    emit("movl", reg(RDI), reg(R8));
+    emit("call", sym("rt_flush"));
+    emit("movl", reg(R8), reg(RDI));
+    emit("movl", imm(231), reg(RAX));
+    emit("syscall");
+
+    // rt_fail: it never returns, so r12 to r14 are free to keep its
+    // arguments. The message is put together in the emptied output buffer,
+    // dropping the newlines rt_print_str and rt_print_int end with, and
+    // written to stderr instead.
+    emitLabel("rt_fail");
+    emit("movl", reg(RDI), reg(R12));
+    emit("movq", reg(RSI), reg(R13));
+    emit("movq", reg(RDX), reg(R14));
+    emit("call", sym("rt_flush"));
+    printString(OUT_OF_BOUNDS_PREFIX);
+    emit("decq", length);
+    emit("movl", reg(R12), reg(RDI));
+    emit("call", sym("rt_print_int"));
+    emit("decq", length);
+    emit("movq", reg(R13), reg(RSI));
+    emit("movq", reg(R14), reg(RDX));
+    emit("call", sym("rt_print_str"));
+    emit("movq", length, reg(RDX));
+    emit("leaq", ripOperand("rt_outbuf"), reg(RSI));
+    emit("movl", imm(2), reg(RDI));
+    emit("movl", imm(1), reg(RAX));
+    emit("syscall");
+    emit("movl", imm(1), reg(RDI));
+    emit("movl", imm(231), reg(RAX));
+    emit("syscall");
+
+    program.bss.push_back({"rt_outbuf", OUTPUT_BUFFER});
+    program.bss.push_back({"rt_outlen", 8});
+    program.bss.push_back({"rt_digits", 16});
+    program.bss.push_back({"rt_inbuf", INPUT_BUFFER});
+    program.bss.push_back({"rt_inpos", 8});
+    program.bss.push_back({"rt_inlen", 8});
+}
+
+// rt_parallel cuts the range into chunks, as many as the interpreter would,
+// that the calling thread and threads started with clone(2) take in turn
+// through rt_par_next. Each thread copies the program's variables into its
+// own frame for every chunk and stores the chunk's result by its number; the
+// caller waits for the others to count rt_par_running down and picks the
+// first failure. A thread's stack is not used after it counts down, so the
+// next loop may give it to a new thread before the old one has exited.
+void X86Generator::emitParallelRuntime() {
+    long stride = max(16L, (localsSize + 15) & ~15L);
+    MachineOperand count = ripOperand("rt_par_count"), chunks = ripOperand("rt_par_chunks");
+    MachineOperand running = ripOperand("rt_par_running");
+
+    emitLabel("rt_parallel");
+    for (int r : {R10, R12, R13, R14, R15}) emit("pushq", reg(r));
+    emit("movq", reg(RDI), ripOperand("rt_par_chunk"));
+    emit("movq", reg(RBX), ripOperand("rt_par_frame"));
+    emit("movl", reg(RSI), ripOperand("rt_par_lo"));
+    emit("movl", reg(RDX), reg(RAX));
+    emit("subl", reg(RSI), reg(RAX));
+    emit("movq", reg(RAX), count);
+
+    // threads: as set, or the CPUs in the affinity mask, counted once
+    emit("movq", ripOperand("rt_par_threads"), reg(R12));
+    emit("testq", reg(R12), reg(R12));
+    emit("jne", sym(".Lrt_par_counted"));
+    if (threads > 0) {
+        emit("movl", imm(min<long>(threads, MAX_THREADS)), reg(R12));
+    } else {
+        emit("movl", imm(204), reg(RAX));  // sched_getaffinity(0, 128, rt_par_mask)
+        emit("xorl", reg(RDI), reg(RDI));
+        emit("movl", imm(128), reg(RSI));
+        emit("leaq", ripOperand("rt_par_mask"), reg(RDX));
+        emit("syscall");
+        emit("testq", reg(RAX), reg(RAX));
+        emit("jle", sym(".Lrt_par_cpus"));
+        emit("movq", reg(RAX), reg(R8));
+        emitLabel(".Lrt_par_byte");
+        emit("movzbl", memOperand(RDX), reg(RAX));
+        emitLabel(".Lrt_par_bit");
+        emit("testl", reg(RAX), reg(RAX));
+        emit("je", sym(".Lrt_par_next_byte"));
+        emit("movl", reg(RAX), reg(RCX));
+        emit("subl", imm(1), reg(RCX));
+        emit("andl", reg(RCX), reg(RAX));
+        emit("incl", reg(R12));
+        emit("jmp", sym(".Lrt_par_bit"));
+        emitLabel(".Lrt_par_next_byte");
+        emit("incq", reg(RDX));
+        emit("decq", reg(R8));
+        emit("jne", sym(".Lrt_par_byte"));
+        emitLabel(".Lrt_par_cpus");
+        emit("cmpq", imm(1), reg(R12));
+        emit("jge", sym(".Lrt_par_some"));
+        emit("movl", imm(1), reg(R12));
+        emitLabel(".Lrt_par_some");
+        emit("cmpq", imm(MAX_THREADS), reg(R12));
+        emit("jbe", sym(".Lrt_par_store"));
+        emit("movl", imm(MAX_THREADS), reg(R12));
+        emitLabel(".Lrt_par_store");
+    }
+    emit("movq", reg(R12), ripOperand("rt_par_threads"));
+    emitLabel(".Lrt_par_counted");
+
+    // chunks: 1 on one thread, else CHUNKS_PER_THREAD per thread but no
+    // more than the iterations
+    emit("movl", imm(1), reg(RAX));
+    emit("cmpq", imm(1), reg(R12));
+    emit("je", sym(".Lrt_par_cut"));
+    emit("movq", reg(R12), reg(RAX));
+    emit("imulq", imm(CHUNKS_PER_THREAD), reg(RAX));
+    emit("cmpq", count, reg(RAX));
+    emit("jbe", sym(".Lrt_par_cut"));
+    emit("movq", count, reg(RAX));
+    emitLabel(".Lrt_par_cut");
+    emit("movq", reg(RAX), chunks);
+    emit("movq", imm(0), ripOperand("rt_par_next"));
+    emit("movq", reg(R12), reg(RAX));
+    emit("decq", reg(RAX));
+    emit("movq", reg(RAX), running);
+
+    // clone(CLONE_VM | CLONE_FS | CLONE_FILES | CLONE_SIGHAND | CLONE_THREAD |
+    // CLONE_SYSVSEM, stack); the new thread starts with the caller's
+    // registers, r14 being its frame
+    emit("movl", imm(1), reg(R13));
+    emitLabel(".Lrt_par_spawn");
+    emit("cmpq", reg(R12), reg(R13));
+    emit("jae", sym(".Lrt_par_spawned"));
+    emit("movq", reg(R13), reg(RAX));
+    emit("imulq", imm(stride), reg(RAX));
+    emit("leaq", ripOperand("rt_par_frames"), reg(R14));
+    emit("addq", reg(RAX), reg(R14));
+    emit("leaq", memOperand(R13, 1), reg(RAX));
+    emit("imulq", imm(THREAD_STACK), reg(RAX));
+    emit("leaq", ripOperand("rt_par_stacks"), reg(RSI));
+    emit("addq", reg(RAX), reg(RSI));
+    emit("movl", imm(0x50F00), reg(RDI));
+    emit("xorl", reg(RDX), reg(RDX));
+    emit("xorl", reg(R10), reg(R10));
+    emit("xorl", reg(R8), reg(R8));
+    emit("movl", imm(56), reg(RAX));
+    emit("syscall");
+    emit("testq", reg(RAX), reg(RAX));
+    emit("je", sym(".Lrt_par_thread"));
+    emit("jns", sym(".Lrt_par_started"));
+    emit("lock decq", running);  // no thread: one fewer to wait for
+    emitLabel(".Lrt_par_started");
+    emit("incq", reg(R13));
+    emit("jmp", sym(".Lrt_par_spawn"));
+    emitLabel(".Lrt_par_spawned");
+    emit("leaq", ripOperand("rt_par_frames"), reg(R14));
+    emit("call", sym(".Lrt_par_work"));
+
+    emitLabel(".Lrt_par_wait");
+    emit("cmpq", imm(0), running);
+    emit("je", sym(".Lrt_par_joined"));
+    emit("movl", imm(24), reg(RAX));  // sched_yield
+    emit("syscall");
+    emit("jmp", sym(".Lrt_par_wait"));
+    emitLabel(".Lrt_par_joined");
+    emit("leaq", ripOperand("rt_par_results"), reg(RSI));
+    emit("xorl", reg(RCX), reg(RCX));
+    emit("xorl", reg(RAX), reg(RAX));
+    emitLabel(".Lrt_par_scan");
+    emit("cmpq", chunks, reg(RCX));
+    emit("jae", sym(".Lrt_par_done"));
+    emit("movl", memOperand(RSI, RCX, 8), reg(RAX));
+    emit("movl", memOperand(RSI, RCX, 8, 4), reg(RDX));
+    emit("incq", reg(RCX));
+    emit("testl", reg(RAX), reg(RAX));
+    emit("je", sym(".Lrt_par_scan"));
+    emitLabel(".Lrt_par_done");
+    for (int r : {R15, R14, R13, R12, R10}) emit("popq", reg(r));
+    emit("ret");
+
+    // a started thread works, counts down and exits
+    emitLabel(".Lrt_par_thread");
+    emit("call", sym(".Lrt_par_work"));
+    emit("lock decq", running);
+    emit("movl", imm(60), reg(RAX));
+    emit("xorl", reg(RDI), reg(RDI));
+    emit("syscall");
+
+    // .Lrt_par_work: runs chunks on the frame in r14 until none are left
+    emitLabel(".Lrt_par_work");
+    emit("movl", imm(1), reg(RAX));
+    emit("lock xaddq", reg(RAX), ripOperand("rt_par_next"));
+    emit("cmpq", chunks, reg(RAX));
+    emit("jae", sym(".Lrt_par_idle"));
+    emit("movq", reg(RAX), reg(R13));
+    emit("imulq", count, reg(RAX));  // lo + count * k / chunks
+    emit("xorl", reg(RDX), reg(RDX));
+    emit("divq", chunks);
+    emit("addl", ripOperand("rt_par_lo"), reg(RAX));
+    emit("movl", reg(RAX), reg(R15));
+    emit("leaq", memOperand(R13, 1), reg(RAX));
+    emit("imulq", count, reg(RAX));
+    emit("xorl", reg(RDX), reg(RDX));
+    emit("divq", chunks);
+    emit("addl", ripOperand("rt_par_lo"), reg(RAX));
+    emit("movl", reg(RAX), reg(R9));
+    emit("movq", ripOperand("rt_par_frame"), reg(RSI));
+    emit("xorl", reg(RCX), reg(RCX));
+    emitLabel(".Lrt_par_copy");
+    emit("movq", memOperand(RSI, RCX, 8), reg(RAX));
+    emit("movq", reg(RAX), memOperand(R14, RCX, 8));
+    emit("incq", reg(RCX));
+    emit("cmpq", imm(stride / 8), reg(RCX));
+    emit("jb", sym(".Lrt_par_copy"));
+    emit("movq", reg(R14), reg(RDI));
+    emit("movl", reg(R15), reg(RDX));
+    emit("movl", reg(R9), reg(RCX));
+    emit("call", ripOperand("rt_par_chunk"));
+    emit("leaq", ripOperand("rt_par_results"), reg(RSI));
+    emit("movl", reg(RAX), memOperand(RSI, R13, 8));
+    emit("movl", reg(RDX), memOperand(RSI, R13, 8, 4));
+    emit("jmp", sym(".Lrt_par_work"));
+    emitLabel(".Lrt_par_idle");
+    emit("ret");
+
+    program.bss.push_back({"rt_par_chunk", 8});
+    program.bss.push_back({"rt_par_frame", 8});
+    program.bss.push_back({"rt_par_lo", 8});
+    program.bss.push_back({"rt_par_count", 8});
+    program.bss.push_back({"rt_par_chunks", 8});
+    program.bss.push_back({"rt_par_next", 8});
+    program.bss.push_back({"rt_par_running", 8});
+    program.bss.push_back({"rt_par_threads", 8});
+    program.bss.push_back({"rt_par_mask", 128});
+    program.bss.push_back({"rt_par_results", 8 * CHUNKS_PER_THREAD * MAX_THREADS});
+    program.bss.push_back({"rt_par_frames", stride * MAX_THREADS});
+    program.bss.push_back({"rt_par_stacks", THREAD_STACK * MAX_THREADS});
+}
+
+// JIT versions of rt_print_int, rt_print_str, rt_read_int, rt_fail and
+// rt_parallel call the host functions in the frame header; after rt_fail the
+// stub returns from the program. The host follows the System V ABI, so the
+// stack is aligned for the call and r10, which the rest of the code assumes
+// the runtime preserves, is saved.
+void X86Generator::emitJitRuntime() {
+    auto thunk = [&](const string& name, int function, bool intArgument) {
+        emitLabel(name);
+        emit("pushq", reg(R10));
+        emit("pushq", reg(RBP));
+        emit("movq", reg(RSP), reg(RBP));
+        emit("andq", imm(-16), reg(RSP));
+        if (function == JIT_PARALLEL) {
+            // the context goes first and the frame after the chunk function
+            emit("movl", reg(RDX), reg(R8));
+            emit("movl", reg(RSI), reg(RCX));
+            emit("movq", reg(RDI), reg(RSI));
+            emit("movq", reg(RBX), reg(RDX));
+        } else if (intArgument) {
+            // the context goes first, so the arguments move up a register
+            emit("movq", reg(RDX), reg(RCX));
+            emit("movq", reg(RSI), reg(RDX));
+            emit("movl", reg(RDI), reg(RSI));
+        }
+        emit("movq", memOperand(RBX, JIT_CONTEXT), reg(RDI));
+        emit("call", memOperand(RBX, function));
+        emit("movq", reg(RBP), reg(RSP));
+        emit("popq", reg(RBP));
+        emit("popq", reg(R10));
+        emit("ret");
+    };
+    thunk("rt_print_int", JIT_PRINT_INT, true);
+    thunk("rt_print_str", JIT_PRINT_STRING, false);
+    thunk("rt_read_int", JIT_READ_INT, false);
+    thunk("rt_fail", JIT_FAIL, true);
+    if (!parallelLoops.empty()) thunk("rt_parallel", JIT_PARALLEL, false);
+}
+
+string X86Generator::generateAssembly(const vector<Instruction>& code) {
+    return printGas(generate(code));
+}
+
+bool X86Generator::buildExecutable(const vector<Instruction>& code, const string& output, bool systemTools) {
+    if (!findStringNames(code).empty()) {
+        errors.push_back("sttring values are only supported by the interpreter");
+        return false;
+    }
+    if (!systemTools) {
+        ElfWriter writer;
+        if (writer.writeExecutable(generate(code), output)) return true;
+        writer.printErrors();
+        errors.push_back("Could not write " + output);
+        return false;
+    }
+
+    string assembly = generateAssembly(code);
+    string source = output + ".s", object = output + ".o";
+    ofstream file(source);
+    if (!file) {
+        errors.push_back("Could not write " + source);
+        return false;
+    }
+    file << assembly;
+    file.close();
+
+    string assemble = "as --64 -o \"" + object + "\" \"" + source + "\"";
+    if (system(assemble.c_str()) != 0) {
+        errors.push_back("Assembler failed: " + assemble);
+        return false;
+    }
+    string link = "ld -o \"" + output + "\" \"" + object + "\"";
+    if (system(link.c_str()) != 0) {
+        errors.push_back("Linker failed: " + link);
+        return false;
+    }
+    return true;
+}
+
+void X86Generator::printStatistics() {
+    allocator.printStatistics();
+    peephole.printStatistics();
+}
+
+void X86Generator::printErrors() {
+    for (const auto& error : errors) cerr << "Native build error: " << error << endl;
+}
+
+bool X86Generator::hasErrors() const {
+    return !errors.empty();
+}
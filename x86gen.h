@@ -0,0 +1,151 @@
+#ifndef X86GEN_H
+#define X86GEN_H
+
+#include "icg.h"
+#include "machine.h"
+#include "peephole.h"
+#include "regalloc.h"
+#include "runtime_io.h"
+#include <unordered_map>
+
+using namespace std;
+
+// Lowers the IR to x86-64 Linux code. Variables are kept in the registers
+// the RegisterAllocator gives them; spilled ones use a 32-bit slot in a
+// zeroed frame addressed through rbx. Printing a variable that was never
+// assigned prints its name, so printed variables also get a byte that is set
+// on assignment. Arrays follow in the same frame; a failed bounds check jumps
+// to a stub that reports the array and stops the program.
+//
+// For executables, input and output go through a small buffered runtime
+// emitted with the program and `return` ends the process with its value as
+// the exit status. For the JIT the program is a function `int f(void* frame)`:
+// the caller supplies the zeroed frame, whose header holds an I/O context and
+// the host print and read functions, and `return` returns from the function.
+//
+// The body of a parallel loop (see findParallelLoop) becomes a chunk
+// function, ParallelChunk, that runs the iterations [lo, hi) on a private
+// copy of the frame's variables, below the arrays, which it reaches through
+// the shared frame in r15. It starts the reduction variables at their
+// identities and adds or multiplies them, and ORs their assigned bytes,
+// into the shared frame atomically when done. The program stores its live
+// registers, has rt_parallel run the chunks, reloads the registers and sets
+// the loop variable to the bound. A failed bounds check in a chunk returns
+// the number of the array's stub, counted from 1, and the index, which the
+// program then passes to that stub.
+enum X86Target { TARGET_EXECUTABLE, TARGET_JIT };
+
+struct ParallelResult {
+    long failure;  // 0, or the number of the failed array's stub
+    long index;
+};
+typedef ParallelResult (*ParallelChunk)(void* frame, void* shared, int lo, int hi);
+
+// JIT frame header: context pointer, then
+// void printInt(void* context, int value),
+// void printString(void* context, const char* text, size_t length) and
+// int readInt(void* context) and
+// void fail(void* context, int index, const char* suffix, size_t length),
+// after which the program returns at once, and
+// ParallelResult parallel(void* context, ParallelChunk chunk, void* frame, int lo, int hi),
+// which runs chunk over [lo, hi) and returns the result of the first chunk
+// that failed, if any.
+static const int JIT_CONTEXT = 0;
+static const int JIT_PRINT_INT = 8;
+static const int JIT_PRINT_STRING = 16;
+static const int JIT_READ_INT = 24;
+static const int JIT_FAIL = 32;
+static const int JIT_PARALLEL = 40;
+static const int JIT_FRAME_HEADER = 48;
+
+struct ArrayFrame {
+    long offset;     // of element 0
+    long size;
+    string failure;  // label of the out-of-bounds stub, empty until a check needs it
+};
+
+// A bounds check's own stub, which moves the failing index to edi and jumps
+// to the array's stub.
+struct BoundsCheck {
+    string label;
+    MachineOperand index;
+    string failure;
+};
+
+class X86Generator {
+public:
+    explicit X86Generator(X86Target target = TARGET_EXECUTABLE);
+    MachineProgram generate(const vector<Instruction>& code);
+    string generateAssembly(const vector<Instruction>& code);
+    // Writes the executable with the built-in encoder and ELF writer, or,
+    // with systemTools, writes output.s and output.o and links them with as/ld.
+    bool buildExecutable(const vector<Instruction>& code, const string& output, bool systemTools = false);
+    void printErrors();
+    bool hasErrors() const;
+    void printStatistics();  // register allocation and peephole of the last generate()
+    // Threads of an executable's parallel loops, 0: one per CPU it may run on.
+    void setThreads(unsigned threads);
+    long getFrameSize() const;
+    long getLocalsSize() const;  // the part of the frame before the arrays
+    int getParallelLoops() const;
+
+private:
+    X86Target target;
+    unsigned threads = 0;
+    MachineProgram program;
+    long frameSize = 0;
+    long localsSize = 0;
+    RegisterAllocator allocator;
+    MachinePeephole peephole;
+    int position = 0;                       // index of the IR instruction being lowered
+    unordered_map<string, int> slots;       // variable -> frame offset
+    unordered_map<string, int> flags;       // printed variable -> offset of its assigned byte
+    unordered_map<string, ArrayFrame> arrays;
+    vector<pair<string, string>> failures;  // stub label, array
+    vector<BoundsCheck> checks;
+    unordered_map<string, string> strings;  // printed text -> rodata label
+    vector<string> params;
+    int labelCount = 0;
+    vector<string> errors;
+
+    // Parallel loops by header index, and the state of the chunk being lowered.
+    unordered_map<int, ParallelLoop> parallelLoops;
+    int arrayBase = RBX;                         // r15 in a chunk
+    string chunkReturn;                          // label of its epilogue, empty outside a chunk
+    vector<pair<string, string>> chunkFailures;  // stub label, array
+    size_t chunkChecks = 0;                      // checks that came before it
+
+    void emit(const string& op, const MachineOperand& dst = MachineOperand());
+    void emit(const string& op, const MachineOperand& src, const MachineOperand& dst);
+    void emitLabel(const string& name);
+    string newLabel();
+    string stringLabel(const string& text);
+
+    MachineOperand value(const string& arg);
+    MachineOperand slot(const string& name);
+    MachineOperand location(const string& name);
+    void store(const string& name);
+    void markAssigned(const string& name);
+    vector<int> saveRegisters();
+    void restoreRegisters(const vector<int>& saved);
+
+    void lowerCopy(const Instruction& instr);
+    void lowerBinary(const Instruction& instr);
+    void lowerDivision(const Instruction& instr);
+    void lowerJumpTable(const vector<Instruction>& code, size_t& i);
+    MachineOperand element(const string& array, const string& index);
+    void lowerLoad(const Instruction& instr);
+    void lowerStore(const Instruction& instr);
+    void lowerBounds(const Instruction& instr);
+    string arrayFailure(const string& array);
+    void emitFailures();
+    void lowerInstruction(const vector<Instruction>& code, size_t& i);
+    void lowerParallel(const vector<Instruction>& code, const ParallelLoop& loop);
+    void lowerPrint(const string& arg);
+    void printString(const string& text);
+    void emitRuntime();
+    void emitParallelRuntime();
+    void emitJitRuntime();
+};
+
+#endif